@@ -0,0 +1,87 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "AdcDmaSource.h"
+
+#if defined(KINETISK)
+
+AdcDmaSource *AdcDmaSource::_source = NULL;
+
+/*
+ * Start an ADC sweeping its channels into the ring
+ * The core has to have set the ADCs up first (analogReadResolution and a
+ * first analogRead, which waits out their calibration); the channels are
+ * SC1A values with MUXSEL left on the b side, as the core leaves it
+ */
+void AdcDmaSource::Start(uint8_t adc, const uint8_t *channels, uint8_t count, volatile uint16_t *ring, uint16_t length){
+
+  _source = this;
+  _ring[adc] = ring;
+  _length[adc] = length;
+  _laps[adc] = 0;
+
+  // the first conversion is started below, so each write selects the one after
+  for (uint8_t i = 0; i < count; i++)
+    _channels[adc][i] = channels[(i + 1) % count];
+
+  volatile uint32_t &sc1a = adc ? ADC1_SC1A : ADC0_SC1A;
+
+  // each result into the ring, wrapping at its end ...
+  _result[adc].source((volatile uint16_t &)(adc ? ADC1_RA : ADC0_RA));
+  _result[adc].destinationBuffer(ring, length * sizeof(uint16_t));
+  _result[adc].triggerAtHardwareEvent(adc ? DMAMUX_SOURCE_ADC1 : DMAMUX_SOURCE_ADC0);
+  _result[adc].interruptAtCompletion();
+  _result[adc].attachInterrupt(adc ? Lap1 : Lap0);
+  // (ahead of the read timer, so Written() never misses a lap)
+  NVIC_SET_PRIORITY(IRQ_DMA_CH0 + (_result[adc].channel & 15), 64);
+
+  // ... then the next channel selected (the last result of a lap links through completion)
+  _select[adc].sourceBuffer(_channels[adc], count * sizeof(uint32_t));
+  _select[adc].destination(sc1a);
+  _select[adc].triggerAtTransfersOf(_result[adc]);
+  _select[adc].triggerAtCompletionOf(_result[adc]);
+
+  _select[adc].enable();
+  _result[adc].enable();
+
+  // a DMA request for each finished conversion, then the first one
+  if (adc) ADC1_SC2 |= ADC_SC2_DMAEN;
+  else ADC0_SC2 |= ADC_SC2_DMAEN;
+  sc1a = channels[0];
+
+}
+
+/*
+ * The samples written since Start: the laps, and where the DMA is in this
+ * one (a lap that has ended but not yet been counted shows as a pending
+ * interrupt)
+ */
+uint32_t FASTRUN AdcDmaSource::Written(uint8_t adc){
+
+  uint32_t laps, position;
+  bool lapped;
+
+  do {
+    laps = _laps[adc];
+    lapped = _result[adc].complete();
+    position = (volatile uint16_t *)_result[adc].destinationAddress() - _ring[adc];
+  } while (laps != _laps[adc] || lapped != _result[adc].complete());
+
+  return (laps + lapped) * _length[adc] + position;
+
+}
+
+void AdcDmaSource::Lap0(){
+  _source->_result[0].clearInterrupt();
+  _source->_laps[0]++;
+}
+
+void AdcDmaSource::Lap1(){
+  _source->_result[1].clearInterrupt();
+  _source->_laps[1]++;
+}
+
+#endif
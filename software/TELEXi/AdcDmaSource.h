@@ -0,0 +1,49 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef AdcDmaSource_h
+#define AdcDmaSource_h
+
+#if defined(KINETISK)
+
+#include "Arduino.h"
+#include <DMAChannel.h>
+#include "AdcScanner.h"
+
+/*
+ * Sweeps the channels of ADC0 and ADC1 with DMA
+ * A finished conversion has one channel copy its result into the ring; that
+ * links to a second which writes the next channel to SC1A, starting the
+ * next conversion, so both modules run free of the CPU
+ */
+class AdcDmaSource : public AdcSource
+{
+  public:
+
+    void Start(uint8_t adc, const uint8_t *channels, uint8_t count, volatile uint16_t *ring, uint16_t length);
+    uint32_t Written(uint8_t adc);
+
+  private:
+
+    static void Lap0();
+    static void Lap1();
+    static AdcDmaSource *_source;
+
+    DMAChannel _result[ADCCOUNT];
+    DMAChannel _select[ADCCOUNT];
+
+    // the SC1A values, a channel on from the results they follow
+    uint32_t _channels[ADCCOUNT][ADCINPUTS];
+    volatile uint16_t *_ring[ADCCOUNT];
+    uint16_t _length[ADCCOUNT];
+    // times round the ring (counted by the result channels' interrupts)
+    volatile uint32_t _laps[ADCCOUNT];
+
+};
+
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "AdcScanner.h"
+
+AdcScanner::AdcScanner(AdcSource *source){
+  _source = source;
+  for (int i = 0; i < ADCINPUTS; i++) {
+    _value[i] = 0;
+    _samples[i] = 0;
+  }
+}
+
+/*
+ * Hands each ADC the channels of its inputs (in input order) and starts
+ * them sweeping
+ */
+void AdcScanner::Begin(const AdcSlot *slots, uint8_t count){
+
+  uint8_t channels[ADCCOUNT][ADCINPUTS];
+
+  for (int i = 0; i < count && i < ADCINPUTS; i++) {
+    uint8_t adc = slots[i].Adc;
+    if (adc >= ADCCOUNT) continue;
+    channels[adc][_count[adc]] = slots[i].Channel;
+    _inputs[adc][_count[adc]++] = i;
+  }
+
+  for (uint8_t adc = 0; adc < ADCCOUNT; adc++) {
+    if (!_count[adc]) continue;
+    // whole sweeps, so a sample's place in the ring gives its input
+    _length[adc] = ADCRINGSIZE / _count[adc] * _count[adc];
+    _read[adc] = 0;
+    _position[adc] = 0;
+    _source->Start(adc, channels[adc], _count[adc], _ring[adc], _length[adc]);
+  }
+
+}
+
+/*
+ * Averages each input's samples since the last pass (the read timer)
+ * A pass that comes too late for the ring keeps only its newest samples
+ */
+void FASTRUN AdcScanner::Collect(){
+
+  int32_t sum[ADCINPUTS] = { 0 };
+  uint16_t samples[ADCINPUTS] = { 0 };
+
+  for (uint8_t adc = 0; adc < ADCCOUNT; adc++) {
+
+    uint8_t count = _count[adc];
+    if (!count) continue;
+
+    uint32_t written = _source->Written(adc);
+    uint32_t fresh = written - _read[adc];
+
+    // the oldest sweep may already be being written over
+    uint16_t keep = _length[adc] - count;
+    if (fresh > keep) {
+      _overruns++;
+      _position[adc] = (_position[adc] + fresh - keep) % _length[adc];
+      fresh = keep;
+    }
+
+    // the sample count wraps, so the ring place is kept rather than worked out from it
+    uint16_t position = _position[adc];
+    uint8_t place = position % count;
+    for (; fresh; fresh--) {
+      uint8_t input = _inputs[adc][place];
+      sum[input] += _ring[adc][position];
+      samples[input]++;
+      if (++position == _length[adc]) position = 0;
+      if (++place == count) place = 0;
+    }
+    _read[adc] = written;
+    _position[adc] = position;
+
+  }
+
+  // an input with nothing new keeps its last value
+  for (int i = 0; i < ADCINPUTS; i++) {
+    _samples[i] = samples[i];
+    if (samples[i]) _value[i] = (sum[i] + samples[i] / 2) / samples[i];
+  }
+
+}
+
+/*
+ * The input's average over the last pass, in the ADC's raw 16 bits (the
+ * 13 analogRead returns shifted up by READSHIFT, as AnalogReader::Update takes them)
+ */
+int AdcScanner::Value(int input){
+  return _value[input];
+}
+
+/*
+ * The samples the last pass averaged for the input
+ */
+uint16_t AdcScanner::Samples(int input){
+  return _samples[input];
+}
+
+/*
+ * Passes that came too late and lost samples
+ */
+unsigned long AdcScanner::Overruns(){
+  return _overruns;
+}
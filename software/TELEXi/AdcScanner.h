@@ -0,0 +1,80 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef AdcScanner_h
+#define AdcScanner_h
+
+#include "Arduino.h"
+
+// the Teensy's two ADC modules
+#define ADCCOUNT 2
+#define ADCINPUTS 8
+// samples held per ADC (rounded down to whole sweeps of its channels)
+#define ADCRINGSIZE 256
+
+/*
+ * An input's place on an ADC: the module and its channel (SC1A ADCH)
+ */
+struct AdcSlot {
+  uint8_t Adc;
+  uint8_t Channel;
+};
+
+/*
+ * Converts an ADC's channels over and over into a ring without the CPU
+ * (DMA on the Teensy, a timed model on the host)
+ */
+class AdcSource
+{
+  public:
+
+    virtual ~AdcSource() {}
+
+    // starts sweeping the channels in order; sample n lands at ring[n % length]
+    virtual void Start(uint8_t adc, const uint8_t *channels, uint8_t count, volatile uint16_t *ring, uint16_t length) = 0;
+    // the samples written since Start (every one before it is complete)
+    virtual uint32_t Written(uint8_t adc) = 0;
+
+};
+
+/*
+ * Scans the inputs on both ADCs at once, each sweeping its own channels
+ * continuously; the read timer only collects what has been converted since
+ * its last pass and averages each input's new samples
+ */
+class AdcScanner
+{
+  public:
+
+    AdcScanner(AdcSource *source);
+
+    void Begin(const AdcSlot *slots, uint8_t count);
+    void Collect();
+
+    int Value(int input);
+    uint16_t Samples(int input);
+    unsigned long Overruns();
+
+  private:
+
+    AdcSource *_source;
+
+    volatile uint16_t _ring[ADCCOUNT][ADCRINGSIZE];
+    // the input at each place of an ADC's sweep
+    uint8_t _inputs[ADCCOUNT][ADCINPUTS];
+    uint8_t _count[ADCCOUNT] = { 0, 0 };
+    uint16_t _length[ADCCOUNT] = { 0, 0 };
+    // the samples collected so far, and where the next one is in the ring
+    uint32_t _read[ADCCOUNT] = { 0, 0 };
+    uint16_t _position[ADCCOUNT] = { 0, 0 };
+
+    int _value[ADCINPUTS];
+    uint16_t _samples[ADCINPUTS];
+    unsigned long _overruns = 0;
+
+};
+
+#endif
@@ -7,15 +7,28 @@
 #include "Arduino.h"
 #include "AnalogReader.h"
 
-#include <ResponsiveAnalogRead.h>
-
 #define MAXPOT 16379
 
+// smoothing in 16-bit ADC units with 8 fraction bits
+#define SMOOTHBITS 8
+#define SMOOTHTOP (65535 << SMOOTHBITS)
+// the activity threshold (4 steps of 13 bits) and the edges it snaps to
+#define ACTIVITY (4 << (READSHIFT + SMOOTHBITS))
+#define EDGE (65536 << SMOOTHBITS)
+// the output's slopes and offsets carry this many fraction bits (past the smoothing's)
+#define SLOPEBITS 20
+// a curve position's carry 16 more, which it keeps
+#define CURVEBITS 36
+#define POSITIONBITS (CURVEBITS - SLOPEBITS)
+
+// how steep the exponential (and logarithmic) and S curves are
+#define EXPSTEEP 4.
+#define SSTEEP 5.
+
 /*
  * simple constructor for unipolar things (like pots)
  */
-AnalogReader::AnalogReader(int address){
-  AnalogReader(address, false);
+AnalogReader::AnalogReader(int address) : AnalogReader(address, false) {
 }
 
 /*
@@ -26,17 +39,31 @@ AnalogReader::AnalogReader(int address, bool reverse){
   _reverse = reverse;
   if (!_reverse) _bottom = 0;
 
-  // set the appropriate smoothing for CV (_reverse) and potentiometers
-  if (_reverse)
-    _analog = new ResponsiveAnalogRead(0, false);
-  else
-    _analog = new ResponsiveAnalogRead(0, true, .0001);
+  // set the appropriate smoothing for CV (_reverse) and potentiometers (which sleep)
+  _sleep = !_reverse;
+  float multiplier = _reverse ? .01 : .0001;
     
-  _analog->setAnalogResolution(1<<13);
+  // the snap curve, 2 - 2 / (x + 1) up to where it reaches 1, x being the
+  // distance in steps of 13 bits times the multiplier
+  float full = (1 << (READSHIFT + SMOOTHBITS)) / multiplier;
+  _snapShift = 0;
+  while (((long)SNAPSTEPS << _snapShift) < full) _snapShift++;
+  for (_i = 0; _i <= SNAPSTEPS; _i++) {
+    float x = ((float)_i * (1 << _snapShift)) / full;
+    float snap = x >= 1 ? 1 : 2 - 2 / (x + 1);
+    _snap[_i] = (uint16_t)(snap * 32768 + .5);
+  }
   
   _calibrationData[0] = -16384;
   _calibrationData[1] = 0;
   _calibrationData[2] = 16383;
+
+  // the user curve starts out straight
+  for (_i = 0; _i < CURVEPOINTS; _i++)
+    _points[_i] = _nextPoints[_i] = (int16_t)(TOP * _i / (CURVEPOINTS - 1));
+
+  Prepare(*_shape);
+  _latestValue = Output();
 }
 
 /*
@@ -44,30 +71,36 @@ AnalogReader::AnalogReader(int address, bool reverse){
  */
 int FASTRUN AnalogReader::Read() {
   // read the value from the pin
-  _readValue = analogRead(_address);
-  _analog->update(_readValue);
-  _readValue = _analog->getValue();
-
-  // if it is a potentiometer (not reversed) constrain and scale to the MAXPOT range
-  if (!_reverse){
-    _readValue = constrain(_readValue, 0, MAXPOT);
-    _readValue = map(_readValue, 0, MAXPOT, 0, 16383);
-  }
+  return Update(analogRead(_address) << READSHIFT);
+}
 
-  // shift it, flip it and reverse it (_reverse is for CV)
-  _readValue = _readValue << (_reverse ? 2 : 1);
-  if (_reverse) _readValue = 16383 - _readValue;
+/*
+ *  takes a value read elsewhere (the ADC scanner) in 16-bit ADC units
+ */
+int FASTRUN AnalogReader::Update(int value) {
   
-  // scale if this input is actively calibrated
-  if (_calibrated) _readValue = Scale(_readValue);
+  int32_t input = value << SMOOTHBITS;
+
+  // pots get dragged towards their ends (easier to reach and to wake from)
+  if (_sleep) {
+    if (input < ACTIVITY)
+      input = input * 2 - ACTIVITY;
+    else if (input > EDGE - ACTIVITY)
+      input = input * 2 - EDGE + ACTIVITY;
+  }
 
-  // map it (if we are mapping values)
-  if (_map){
-    _readValue = map(_readValue, _reverse ? BOTTOM : 0, TOP, _bottom, _top);
+  // the error average (0.4 as near as shifts get)
+  int32_t distance = input - _smooth;
+  _error += (distance - _error) * 13 >> 5;
+
+  // a sleeping pot holds its value until the error wakes it
+  if (!_sleep || abs(_error) >= ACTIVITY) {
+    _smooth += (int32_t)(((int64_t)distance * Snap(abs(distance))) >> 15);
+    _smooth = constrain(_smooth, 0, SMOOTHTOP);
   }
 
   // store as latest value and return
-  _latestValue = _readValue;
+  _latestValue = Output();
   return _latestValue;
   
 }
@@ -79,6 +112,19 @@ int AnalogReader::GetLatest() {
   return _latestValue;
 }
 
+/*
+ * rebuilds the shape if the settings changed, into the one Output() isn't
+ * reading, and swaps it in (a settings change while it builds marks it to
+ * be built again)
+ */
+void AnalogReader::Refresh() {
+  if (!_changed) return;
+  _changed = false;
+  ReaderShape *next = _shape == &_shapes[0] ? &_shapes[1] : &_shapes[0];
+  Prepare(*next);
+  _shape = next;
+}
+
 
 void AnalogReader::SetTop(int top){
   SetMap(top, _bottom);
@@ -92,6 +138,53 @@ void AnalogReader::SetMap(int top, int bottom){
   if (_top != top) _top = top;
   if (_bottom != bottom) _bottom = bottom;
   _map = _top != TOP || _bottom != (_reverse ? BOTTOM : 0);
+  _changed = true;
+}
+
+/*
+ * sets the response curve (CURVE_LINEAR for none); selecting the user
+ * curve takes up the breakpoints set since it last was
+ */
+void AnalogReader::SetCurve(int curve){
+  _curve = curve >= CURVE_LINEAR && curve <= CURVE_USER ? curve : CURVE_LINEAR;
+  if (_curve == CURVE_USER)
+    for (_i = 0; _i < CURVEPOINTS; _i++)
+      _points[_i] = _nextPoints[_i];
+  _changed = true;
+}
+
+/*
+ * sets one of the user curve's breakpoints (evenly spaced across the
+ * input's range) to a part of that range (0 - 16383); it is only stored,
+ * so a whole set of points makes one new curve when SetCurve commits them
+ */
+void AnalogReader::SetCurvePoint(int point, int value){
+  if (point < 0 || point >= CURVEPOINTS) return;
+  _nextPoints[point] = (int16_t)constrain(value, 0, TOP);
+}
+
+/*
+ * the response curve at a position along the input's range (0 to 1), as
+ * a part of the range (the table's points come from here)
+ */
+double AnalogReader::Shape(double position){
+
+  switch (_curve) {
+    case CURVE_EXP:
+      return (exp(EXPSTEEP * position) - 1) / (exp(EXPSTEEP) - 1);
+    case CURVE_LOG:
+      return log(1 + position * (exp(EXPSTEEP) - 1)) / EXPSTEEP;
+    case CURVE_S:
+      return (tanh(SSTEEP * (position - .5)) / tanh(SSTEEP / 2) + 1) / 2;
+    case CURVE_USER: {
+      double at = position * (CURVEPOINTS - 1);
+      int point = constrain((int)at, 0, CURVEPOINTS - 2);
+      return (_points[point] + (_points[point + 1] - _points[point]) * (at - point)) / TOP;
+    }
+    default:
+      return position;
+  }
+
 }
 
 /*
@@ -106,6 +199,7 @@ bool AnalogReader::GetCalibrated(){
  */
 void AnalogReader::SetCalibrated(bool calibrated){
   _calibrated = calibrated;
+  _changed = true;
 }
 
 /*
@@ -117,8 +211,8 @@ void AnalogReader::Calibrate(int measure){
     // set this reader as calibrated
     _calibrated = true;
 
-    // pull the accumulated value
-    int value = _analog->getValue();
+    // pull the accumulated value (in 13 bits, as it always was)
+    int value = _smooth >> (SMOOTHBITS + READSHIFT);
     
     // flip and reverse
     value = value << (_reverse ? 2 : 1);
@@ -134,6 +228,8 @@ void AnalogReader::Calibrate(int measure){
       _calibrationData[0] = value;
     }
 
+    _changed = true;
+
 }
 
 /*
@@ -148,24 +244,117 @@ void AnalogReader::GetCalibrationData(int data[3]){
  */
 void AnalogReader::SetCalibrationData(int measure, int value){
   _calibrationData[measure] = value;
+  _changed = true;
 }
 
 
 /*
- * performs the scaling function based on calibration
+ * folds the scaling, calibration and mapping into a slope and offset for
+ * each side of the calibration midpoint (this is where the divisions went)
+ *
+ * with a curve, the slope and offset lead to a position along its table
+ * instead, and the mapping goes into the table's points
  */
-int FASTRUN AnalogReader::Scale(int value) {
+void AnalogReader::Prepare(ReaderShape& shape) {
+
+  // potentiometers scale up from the MAXPOT range; CV is shifted, flipped and reversed
+  double gain = _reverse ? -4. / (1 << READSHIFT) : 2. * 16383 / MAXPOT / (1 << READSHIFT);
+  double offset = _reverse ? 16383 : 0;
+  double low = _calibrated || _reverse ? BOTTOM : 0;
+  double high = TOP;
+  bool curved = _curve != CURVE_LINEAR;
+  int bits = curved ? CURVEBITS : SLOPEBITS;
+
+  for (int side = 0; side < 2; side++) {
+
+    double g = gain;
+    double o = offset;
+
+    // the calibration maps each side of the midpoint on to its half of the range
+    if (_calibrated) {
+      double from = _calibrationData[side];
+      double span = _calibrationData[side + 1] - from;
+      double k = span ? (side ? 16383. : 16384.) / span : 0;
+      g *= k;
+      o = (o - from) * k - (side ? 0 : 16384);
+    }
+
+    // then on to the range mapped to, or along the curve's table
+    if (curved) {
+      double k = CURVESTEPS / (high - low);
+      g *= k;
+      o = (o - low) * k;
+    } else if (_map) {
+      double from = _reverse ? BOTTOM : 0;
+      double k = (double)(_top - _bottom) / (TOP - from);
+      g *= k;
+      o = (o - from) * k + _bottom;
+    }
+
+    shape.Slope[side] = (int32_t)constrain(llround(g * (1LL << bits)), -2147483647LL, 2147483647LL);
+    // (rounded to the nearest on the way out)
+    shape.Offset[side] = llround(o * (1LL << (bits + SMOOTHBITS))) + (1LL << (SLOPEBITS + SMOOTHBITS - 1));
 
-  // map the polar values
-  if (value >= _calibrationData[1]){
-    value = map(value, _calibrationData[1], _calibrationData[2], 0, 16383);
-  } else {
-    value = map(value, _calibrationData[0], _calibrationData[1], -16384, 0);
   }
 
-  // constrain to our TI range
-  value = constrain(value, -16384, 16383);
-  
-  return value;
+  // where the scaled input crosses the calibration midpoint
+  shape.Rising = gain > 0 || !_calibrated;
+  shape.Split = _calibrated ? (int32_t)constrain(llround((_calibrationData[1] - offset) / gain * (1 << SMOOTHBITS)), -(1LL << 30), 1LL << 30) : 0;
+
+  // the curve's points through the range, mapped
+  shape.Curved = curved;
+  if (curved) {
+    for (int i = 0; i <= CURVESTEPS; i++) {
+      double value = low + (high - low) * Shape((double)i / CURVESTEPS);
+      if (_map) {
+        double from = _reverse ? BOTTOM : 0;
+        value = (value - from) * (_top - _bottom) / (TOP - from) + _bottom;
+      }
+      shape.Table[i] = (int16_t)constrain(lround(value), -32768L, 32767L);
+    }
+    shape.Table[CURVESTEPS + 1] = shape.Table[CURVESTEPS];
+  }
+
+  // the output is held to the range (mapped, when it is)
+  if (_map) {
+    double from = _reverse ? BOTTOM : 0;
+    double k = (double)(_top - _bottom) / (TOP - from);
+    low = (low - from) * k + _bottom;
+    high = (high - from) * k + _bottom;
+  }
+  shape.Low = (int)lround(min(low, high));
+  shape.High = (int)lround(max(low, high));
+
 }
 
+/*
+ * the snap curve at a distance, between its points
+ */
+int FASTRUN AnalogReader::Snap(int32_t distance) {
+
+  int32_t step = distance >> _snapShift;
+  if (step >= SNAPSTEPS) return _snap[SNAPSTEPS];
+
+  int32_t part = distance - (step << _snapShift);
+  return _snap[step] + (int32_t)(((int64_t)(_snap[step + 1] - _snap[step]) * part) >> _snapShift);
+
+}
+
+/*
+ * the smoothed value scaled, calibrated and mapped (through the curve)
+ */
+int FASTRUN AnalogReader::Output() {
+
+  // one shape throughout (Refresh may swap in another between reads)
+  const ReaderShape *shape = _shape;
+  int side = (_smooth >= shape->Split) == shape->Rising ? 1 : 0;
+  int32_t value = (int32_t)(((int64_t)_smooth * shape->Slope[side] + shape->Offset[side]) >> (SLOPEBITS + SMOOTHBITS));
+  if (!shape->Curved) return constrain(value, shape->Low, shape->High);
+
+  // the table's point below, and the 15 bits of the way to the next
+  value = constrain(value, 0, CURVESTEPS << POSITIONBITS);
+  int point = value >> POSITIONBITS;
+  int32_t part = (value & ((1 << POSITIONBITS) - 1)) >> 1;
+  return shape->Table[point] + ((shape->Table[point + 1] - shape->Table[point]) * part >> 15);
+
+}
@@ -8,13 +8,56 @@
 #define AnalogReader_h
 
 #include "Arduino.h"
-#include <ResponsiveAnalogRead.h>
 
 #define TOP 16383
 #define BOTTOM -16384
 
+// analogRead's 13 bits up to the 16-bit ADC units Update() takes
+#define READSHIFT 3
+
+// points of the smoothing's snap curve (interpolated between)
+#define SNAPSTEPS 64
+
+// response curves (TI_IN_MAP / TI_PARAM_MAP)
+#define CURVE_LINEAR 0
+#define CURVE_EXP 1
+#define CURVE_LOG 2
+#define CURVE_S 3
+#define CURVE_USER 4
+// points of a curve's table (interpolated between), and the user breakpoints
+#define CURVESTEPS 32
+#define CURVEPOINTS 9
+
+/*
+ * everything Output() reads besides the smoothed value: the output (8 + 20
+ * fraction bits), or the curve position (8 + 36, of which 16 are kept), for
+ * each side of the split, its range, and the curve mapped (its last point
+ * twice, for the top of the range)
+ */
+struct ReaderShape {
+  int32_t Slope[2];
+  int64_t Offset[2];
+  int32_t Split;
+  bool Rising;
+  int Low;
+  int High;
+  bool Curved;
+  int16_t Table[CURVESTEPS + 2];
+};
+
 /*
  * helper class created for the TELEXi to read and scale inputs
+ *
+ * each value goes through one integer pipeline: an adaptive exponential
+ * average (as ResponsiveAnalogRead did it: the closer the input, the
+ * slower it follows, with sleep for the knobs), then the scaling,
+ * calibration and mapping folded into a slope and offset for either side
+ * of the calibration midpoint; the divisions all happen when those change,
+ * in Refresh (from loop(), not the interrupts), which swaps the new set in
+ * whole
+ *
+ * a response curve turns that into a position along a table of the curve
+ * (already mapped), read between its two nearest points
  */
 class AnalogReader
 {
@@ -24,11 +67,16 @@ class AnalogReader
     AnalogReader(int address, bool reverse);
     
     int Read();
+    int Update(int value);
     int GetLatest();
+    void Refresh();
 
     void SetTop(int top);
     void SetBottom(int bottom);
     void SetMap (int top, int bottom);
+    void SetCurve(int curve);
+    void SetCurvePoint(int point, int value);
+    double Shape(double position);
     
     void Calibrate(int measure);
     bool GetCalibrated();
@@ -41,18 +89,38 @@ class AnalogReader
     int _address;
     bool _reverse = false;
     
-    ResponsiveAnalogRead *_analog;
+    // the smoothed value and its error average (16-bit ADC units, 8 fraction bits)
+    int32_t _smooth = 0;
+    int32_t _error = 0;
+    bool _sleep = false;
+    // the snap curve (1.0 = 32768), a point every 1 << _snapShift of distance
+    uint16_t _snap[SNAPSTEPS + 1];
+    uint8_t _snapShift;
     
-    int volatile _readValue;
     int volatile _latestValue;
     
-    int Scale(int value);
+    void Prepare(ReaderShape& shape);
+    int Snap(int32_t distance);
+    int Output();
+
+    // the shape Output() reads, and the one Refresh builds next
+    ReaderShape _shapes[2];
+    ReaderShape * volatile _shape = &_shapes[0];
+    // the settings changed since the last Refresh
+    bool volatile _changed = false;
+
     int _calibrationData[3];
     bool _calibrated = false;
 
     bool _map = false;
     int _top = TOP;
     int _bottom = BOTTOM;
+
+    int _curve = CURVE_LINEAR;
+    // the user breakpoints, evenly across the range (as the curve has them,
+    // and as set since, until the curve is selected again)
+    int16_t _points[CURVEPOINTS];
+    int16_t _nextPoints[CURVEPOINTS];
     
     int _i;
     
@@ -0,0 +1,96 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "InputReport.h"
+#include "TxHelper.h"
+
+/*
+ * Copies the values with the read timer held off
+ */
+void InputReport::Snapshot(const volatile int *values){
+  noInterrupts();
+  for (int i = 0; i < INPUTCOUNT; i++)
+    _values[i] = values[i];
+  interrupts();
+}
+
+/*
+ * Writes the snapshot to the master (the request callback); returns the bytes sent
+ */
+size_t InputReport::Send(){
+  for (int i = 0; i < INPUTCOUNT; i++)
+    TxHelper::Send(_values[i]);
+  return INPUTCOUNT * 2;
+}
+
+/*
+ * Answers a delta read (the request callback): the change bitmap from a
+ * fresh snapshot, or the values of the changes it last sent
+ * Returns the bytes sent (none for a set there is no such read of)
+ */
+size_t InputReport::SendDelta(const volatile int *values, int set){
+
+  if (set < 0 || set >= INPUTSETS) return 0;
+
+  if (!_pending) {
+    Snapshot(values);
+    _pending = Compare(set);
+    _pendingSet = set;
+    Wire.write(_pending);
+    return 1;
+  }
+
+  size_t sent = 0;
+  for (int i = 0; i < INPUTCOUNT; i++) {
+    if (!(_pending & (1 << i))) continue;
+    TxHelper::Send(_values[i]);
+    _sent[_pendingSet][i] = _values[i];
+    sent += 2;
+  }
+  _primed[_pendingSet] = true;
+  _pending = 0;
+  return sent;
+
+}
+
+/*
+ * Starts the next delta read with the change bitmap (a new select does,
+ * in case the master never read the values of the last one)
+ */
+void InputReport::ResetDelta(){
+  _pending = 0;
+}
+
+/*
+ * Sets how far an input's normal value moves before a delta read reports it
+ */
+void InputReport::SetThreshold(int input, int threshold){
+  if (input >= 0 && input < INPUTCOUNT)
+    _threshold[input] = max(threshold, 0);
+}
+
+int InputReport::Value(int input){
+  return _values[input];
+}
+
+/*
+ * The inputs whose snapshot moved from the values last sent (all of them
+ * the first time)
+ */
+byte InputReport::Compare(int set){
+
+  if (!_primed[set]) return (1 << INPUTCOUNT) - 1;
+
+  byte changes = 0;
+  for (int i = 0; i < INPUTCOUNT; i++) {
+    int threshold = set == 0 ? _threshold[i] : 0;
+    if (abs(_values[i] - _sent[set][i]) > threshold)
+      changes |= 1 << i;
+  }
+  return changes;
+
+}
@@ -0,0 +1,60 @@
+/*
+ * TELEXi Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef InputReport_h
+#define InputReport_h
+
+#include "Arduino.h"
+
+#define INPUTCOUNT 8
+// normal, quantized and note number values
+#define INPUTSETS 3
+
+// the change a normal value needs before a delta read reports it
+#define DELTATHRESHOLD 16
+
+/*
+ * The eight inputs' values sent in one read (the bulk selects): copied
+ * together from the read timer's values, so they all come from the same
+ * pass, and sent as eight big-endian words in input order
+ *
+ * Delta reads send only what has changed since the values last sent: a
+ * read of one byte with a bit for each input that moved (by more than its
+ * threshold for normal values, at all for quantized and note numbers),
+ * then, when any did, a read of just their values in input order
+ */
+class InputReport
+{
+  public:
+
+    void Snapshot(const volatile int *values);
+    size_t Send();
+
+    size_t SendDelta(const volatile int *values, int set);
+    void ResetDelta();
+    void SetThreshold(int input, int threshold);
+
+    int Value(int input);
+
+  private:
+
+    byte Compare(int set);
+
+    int _values[INPUTCOUNT];
+
+    // the values a delta read last sent of each set (none until the first)
+    int _sent[INPUTSETS][INPUTCOUNT];
+    bool _primed[INPUTSETS] = { false, false, false };
+    int _threshold[INPUTCOUNT] = { DELTATHRESHOLD, DELTATHRESHOLD, DELTATHRESHOLD, DELTATHRESHOLD,
+      DELTATHRESHOLD, DELTATHRESHOLD, DELTATHRESHOLD, DELTATHRESHOLD };
+
+    // the changes sent and waiting for their values to be read
+    byte _pending = 0;
+    int _pendingSet = 0;
+
+};
+
+#endif
@@ -16,6 +16,9 @@
 #include "Quantizer.h"
 #include "AnalogReader.h"
 #include "TxHelper.h"
+#include "InputReport.h"
+#include "AdcScanner.h"
+#include "AdcDmaSource.h"
 
 /*
  * Ugly Globals
@@ -40,6 +43,12 @@ int volatile inputValue[8];
 int volatile quantizedValue[8];
 int volatile quantizedNote[8];
 
+// the inputs' ADC channels: A2 and A3 also reach ADC1, which scans those two
+// while ADC0 scans the other six (both on their own, into a ring each)
+AdcSlot adcSlots[] = { { 0, 6 }, { 0, 7 }, { 0, 15 }, { 0, 4 }, { 0, 14 }, { 1, 9 }, { 0, 5 }, { 1, 8 } };
+AdcDmaSource adcSource;
+AdcScanner scanner(&adcSource);
+
 // read timer and its local variables
 IntervalTimer readTimer;
 int p = 0;
@@ -54,6 +63,10 @@ int targetOutput = 0;
 // i2c slave transmit
 byte activeInput = 0;
 byte activeMode = 0;
+bool activeBulk = false;
+bool activeDelta = false;
+// all eight inputs for a bulk read (or what changed, for a delta read)
+InputReport report;
 
 #ifdef DEBUG
 unsigned long logInterval = 0;
@@ -101,6 +114,12 @@ void setup() {
 
   // read the calibration data from EEPROM
   readCalibrationData();
+  for (i=0; i <8; i++)
+    analogReaders[i]->Refresh();
+
+  // a first read waits out the core's ADC calibration, then the scanner takes both ADCs over
+  analogRead(inputs[0]);
+  scanner.Begin(adcSlots, 8);
 
 #ifdef DEBUG
   // take a quick pause (for the calibration data to print for debugging)
@@ -121,11 +140,14 @@ void setup() {
  * the read input timer interrupt
  * need to be careful with what we access and do here
  * this function is pushing it with the quantization and stuff
+ * (the ADCs convert on their own; this only averages what they have
+ * written since the last pass, keeping all 16 bits for the readers)
  */
 void readInputs(){
+  scanner.Collect();
   // loop through the 8 inputs and store the latest value 
   for (p=0; p < 8; p++){
-    inputValue[p] = analogReaders[p]->Read();
+    inputValue[p] = analogReaders[p]->Update(scanner.Value(p));
     // handle the quantized response
     qresponse = quant[p]->Quantize(inputValue[p]);
     quantizedValue[p] = qresponse.Value;
@@ -134,10 +156,15 @@ void readInputs(){
 }
 
 /*
- * a simple debugging print loop - all other actions happen in the callbacks and timers
+ * rebuilds the readers' settings changed over i2c (out here, so the
+ * interrupts never do the divisions) - all other actions happen in the
+ * callbacks and timers, and the rest is debugging
  */
 void loop() {
 
+  for (int l=0; l < 8; l++)
+    analogReaders[l]->Refresh();
+
 #ifdef DEBUG
     // print stuff
     if (millis() >= logInterval) {
@@ -182,8 +209,14 @@ void receiveEvent(size_t len) {
 #endif
     
     // this is the single byte that sets the active input
-    activeInput = io.Port;
-    activeMode = io.Mode;
+    // (or, for a bulk or delta read, the values of all eight to send;
+    // the rest of their range reads an input as usual)
+    byte select = response.Command;
+    activeBulk = select >= TI_BULK && select <= TI_BULK_N;
+    activeDelta = select >= TI_DELTA && select <= TI_DELTA_N;
+    activeInput = activeBulk || activeDelta ? 0 : io.Port;
+    activeMode = activeDelta ? select - TI_DELTA : activeBulk ? select - TI_BULK : io.Mode;
+    if (activeDelta) report.ResetDelta();
     
   } else {
     // act on the command
@@ -192,39 +225,50 @@ void receiveEvent(size_t len) {
   
 }
 
+/*
+ * the values a mode reads: normal, quantized or note number
+ */
+const volatile int *modeValues(byte mode) {
+  switch(mode){
+    case 1:
+      return quantizedValue;
+    case 2:
+      return quantizedNote;
+    default:
+      return inputValue;
+  }
+}
+
 /*
  * this is when the master is requesting data from an input
  * we return the int (which is cast to unsigned so the sign can survive the transit)
+ * a bulk read returns all eight inputs, copied together
+ * a delta read returns the inputs that changed (then their values)
  */
 void requestEvent() {
 
-  // disable interrupts. get and cast the value
-  uint16_t shiftReady = 0;
-  switch(activeMode){
-    case 1:
-      noInterrupts();
-      shiftReady = (uint16_t)quantizedValue[activeInput];
-      interrupts();
-      break;
-    case 2:
-      noInterrupts();
-      shiftReady = (uint16_t)quantizedNote[activeInput];
-      interrupts();
-      break;
-    default:
-      noInterrupts();
-      shiftReady = (uint16_t)inputValue[activeInput];
-      interrupts();
-      break;
+  if (activeDelta) {
+    report.SendDelta(modeValues(activeMode), activeMode);
+    return;
+  }
+
+  if (activeBulk) {
+    report.Snapshot(modeValues(activeMode));
+    report.Send();
+    return;
   }
+
+  // disable interrupts and get the value
+  noInterrupts();
+  int value = modeValues(activeMode)[activeInput];
+  interrupts();
   
 #ifdef DEBUG
-  Serial.printf("delivering: %d; value: %d [%d]\n", activeInput, inputValue[activeInput], shiftReady);
+  Serial.printf("delivering: %d; value: %d [%d]\n", activeInput, inputValue[activeInput], value);
 #endif
 
   // send the puppy as a pair of bytes
-  Wire.write(shiftReady >> 8);
-  Wire.write(shiftReady & 255);
+  TxHelper::Send(value);
 }
 
 
@@ -257,6 +301,29 @@ void actOnCommand(byte cmd, byte out, int value){
       analogReaders[outHelper]->SetBottom(value);
       break;
 
+    case TI_IN_MAP:
+      outHelper += 4;
+    case TI_PARAM_MAP:
+      analogReaders[outHelper]->SetCurve(value);
+      break;
+
+    case TI_IN_MAP_PT:
+    case TI_PARAM_MAP_PT: {
+      // the breakpoint rides in the top four bits of the output, the input
+      // (0 - 3 of its kind) in the bottom four
+      int point = out >> 4;
+      int input = out & 0x0F;
+      if (input > 3) break;
+      analogReaders[input + (cmd == TI_IN_MAP_PT ? 4 : 0)]->SetCurvePoint(point, value);
+      break;
+    }
+
+    case TI_IN_DELTA:
+      outHelper += 4;
+    case TI_PARAM_DELTA:
+      report.SetThreshold(outHelper, value);
+      break;
+
     case TI_IN_CALIB:  
       outHelper += 4;  
     case TI_PARAM_CALIB:
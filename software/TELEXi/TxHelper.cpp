@@ -10,7 +10,7 @@
 // i2c
 #include <i2c_t3.h>
 
-TxResponse TxHelper::Parse(size_t len){
+TxResponse TxHelper::Parse(size_t){
 
   TxResponse response;
 
@@ -42,6 +42,16 @@ TxResponse TxHelper::Parse(size_t len){
   
 }
 
+/*
+ * Writes a value to the master as a pair of bytes (cast to unsigned so
+ * the sign survives the transit)
+ */
+void TxHelper::Send(int value) {
+  uint16_t shiftReady = (uint16_t)value;
+  Wire.write(shiftReady >> 8);
+  Wire.write(shiftReady & 255);
+}
+
 TxIO TxHelper::DecodeIO(int io) {
   
   TxIO decoded;
@@ -49,7 +59,8 @@ TxIO TxHelper::DecodeIO(int io) {
   // turn it into 0-7 for the individual device's port
   decoded.Port = io % 8;
   
-  // output mode (0-7 = normal; 8-15 = Quantized; 16-23 = Note Number)
+  // output mode (0-7 = normal; 8-15 = Quantized; 16-23 = Note Number;
+  // 24-26 = all eight inputs, normal, quantized or note number)
   decoded.Mode = io >> 3;
 
   return decoded;
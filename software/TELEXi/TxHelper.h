@@ -29,6 +29,7 @@ class TxHelper
 
     static TxResponse Parse(size_t len);
     static TxIO DecodeIO(int io);
+    static void Send(int value);
 
   protected:
     
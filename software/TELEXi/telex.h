@@ -114,6 +114,7 @@
 #define TI_IN_TOP 0x04
 #define TI_IN_BOT 0x05
 #define TI_IN_MAP 0x06
+#define TI_IN_DELTA 0x07
 
 #define TI_PARAM 0x10
 #define TI_PARAM_QT 0x11
@@ -122,10 +123,25 @@
 #define TI_PARAM_TOP 0x14
 #define TI_PARAM_BOT 0x15
 #define TI_PARAM_MAP 0x16
+#define TI_PARAM_DELTA 0x17
+
+// one-byte selects for a bulk read of all eight inputs (16 bytes):
+// normal, quantized and note number values
+#define TI_BULK 0x18
+#define TI_BULK_QT 0x19
+#define TI_BULK_N 0x1A
+// one-byte selects for a delta read: a byte with a bit for each input that
+// changed since the last delta read, then a read of just their values
+#define TI_DELTA 0x1B
+#define TI_DELTA_QT 0x1C
+#define TI_DELTA_N 0x1D
 
 #define TI_IN_CALIB 0x20
 #define TI_PARAM_CALIB 0x21
 #define TI_STORE 0x22
 #define TI_RESET 0x23
 
+#define TI_IN_MAP_PT 0x24
+#define TI_PARAM_MAP_PT 0x25
+
 #endif
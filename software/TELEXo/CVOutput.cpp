@@ -9,15 +9,17 @@
 #include "CVOutput.h"
 #include "TxHelper.h"
 #include "DAC7565.h"
+#include "FixedPoint.h"
 
 #include "ExpTable.h"
 
+uint8_t CVOutput::_oscPhase = 0;
+bool CVOutput::_multirate = true;
+
 /*
  * Constructor for Setting up the Output
  */
-CVOutput::CVOutput(int output, int led, DAC& dac) : Output(output, led){
-  // store the DAC reference
-  _dac = dac;
+CVOutput::CVOutput(int output, int led, DAC& dac) : Output(output, led), _dac(dac){
   // initialize the Quantizers
   _quantizer = new Quantizer(0);
   _oscQuantizer = new Quantizer(0);
@@ -201,6 +203,9 @@ void CVOutput::Reset(){
   SetWidth(50);
   SetFrequencySlew(0, 0);
   SetCenter(0);
+  SetScanSlew(0, 0);
+  SetScanFrom(0);
+  SetScanTo((Oscillator::GetWaveformCount() - 1) * MORPHRANGE);
   
   SetEnvelopeMode(0);
   SetAttack(12, 0);
@@ -256,7 +261,7 @@ void CVOutput::TargetNote(int note){
 /*
  * Sets the Format for the Slew Time Value
  */
-void CVOutput::SetTimeFormat(int format){
+void CVOutput::SetTimeFormat(int){
   // call the base class
   // Output::SetTimeFormat(format);
 }
@@ -267,8 +272,12 @@ void CVOutput::SetTimeFormat(int format){
 void CVOutput::SharedOscil(int value){
 
   // reset the phase if it isn't currently oscillation mode
-  if (!_oscilMode)
+  // (and read in step with the outputs already oscillating)
+  if (!_oscilMode) {
     _oscillator->ResetPhase(_target);
+    _oscRead = _oscPhase ? _oscPhase : OSCBUFFER;
+    _oscValid = 0;
+  }
 
   // determine if we are entering oscil mode
   _oscilMode = value > 0;
@@ -481,6 +490,7 @@ void CVOutput::Sync(){
     _oscillator->ResetPhase(0);
   else
     _oscillator->ResetPhase(_target);
+  _oscValid = 0;
 }
 
 /*
@@ -488,6 +498,7 @@ void CVOutput::Sync(){
  */
 void CVOutput::SetPhaseOffset(int phase){
   _oscillator->SetPhaseOffset(phase);
+  _oscValid = 0;
 }
 
 /*
@@ -502,6 +513,42 @@ void CVOutput::SetWaveform(int wave){
   _oscillator->SetWaveform(wave);
 }
 
+/*
+ * Scans the wavetables: sets the position (0 to 16384) across the scan range,
+ * crossfading the neighbouring tables; TO.OSC.WAVE returns to a single waveform
+ */
+void CVOutput::SetScan(int position){
+  _oscillator->SetScan(position);
+}
+
+/*
+ * Targets the scan position (slews over the scan slew time)
+ */
+void CVOutput::TargetScan(int position){
+  _oscillator->TargetScan(position);
+}
+
+/*
+ * Sets the slew time for the scan position
+ */
+void CVOutput::SetScanSlew(int slew, short format){
+  _oscillator->SetScanSlewMs(TxHelper::ConvertMs(slew, format));
+}
+
+/*
+ * Sets the start of the scan range in TO.OSC.WAVE units
+ */
+void CVOutput::SetScanFrom(int wave){
+  _oscillator->SetScanFrom(wave);
+}
+
+/*
+ * Sets the end of the scan range in TO.OSC.WAVE units
+ */
+void CVOutput::SetScanTo(int wave){
+  _oscillator->SetScanTo(wave);
+}
+
 /*
  * Sets the quantization scale based on the included scales 
  * (see the Quantizer for the list)
@@ -518,7 +565,8 @@ void CVOutput::SetAttack(int att, short format){
   _attackSlew = CalculateRawSlew(_attack, _envTarget, _lOffset);
   if (_envelopeActive && !_decaying){
     SlewSteps tempSlew = CalculateRawSlew(_attack, _envTarget, _lOffset);
-    tempSlew.Steps = (_envTarget - _current) / tempSlew.Delta;
+    // a zero delta (nothing to traverse) yields zero steps like the Cortex-M divider does
+    tempSlew.Steps = tempSlew.Delta != 0 ? (_envTarget - _current) / tempSlew.Delta : 0;
     _slew = tempSlew;
   }
 }
@@ -531,7 +579,7 @@ void CVOutput::SetDecay(int dec, short format){
   _decaySlew = CalculateRawSlew(_decay, _lOffset, _envTarget);
   if (!_envelopeActive && _decaying){
     SlewSteps tempSlew = CalculateRawSlew(_decay, _lOffset, _envTarget);
-    tempSlew.Steps = (_lOffset - _current) / tempSlew.Delta;
+    tempSlew.Steps = tempSlew.Delta != 0 ? (_lOffset - _current) / tempSlew.Delta : 0;
     _slew = tempSlew;
   }
 }
@@ -748,6 +796,73 @@ void FASTRUN CVOutput::Update() {
 
 }
 
+/*
+ * Renders the next slice of every buffer in one bank pass, one slice every
+ * OSCSLICE ticks; the outputs resynced part way through a slice refill it
+ * themselves in UpdateDAC
+ */
+void FASTRUN CVOutput::RenderOscillators(CVOutput * const outputs[BANKLANES], OscillatorBank& bank) {
+
+  Oscillator *osc[BANKLANES];
+  int16_t *out[BANKLANES];
+  CVOutput *cv;
+  bool due = false;
+
+  for (int l = 0; l < BANKLANES; l++) {
+    cv = outputs[l];
+    osc[l] = NULL;
+    out[l] = cv->_oscBuffer;
+    if (!cv->_oscilMode) continue;
+    if (cv->_oscRead >= OSCBUFFER) {
+      cv->_oscRead = 0;
+      // a slow oscillator ramps from the buffer's last sample (unless it was discarded)
+      if (_multirate && cv->_oscValid == OSCBUFFER && cv->_oscillator->ControlRate()) {
+        cv->RenderControl();
+        continue;
+      }
+      cv->_oscValid = 0;
+    }
+    if (cv->_oscRead == cv->_oscValid && cv->_oscRead % OSCSLICE == 0) {
+      osc[l] = cv->_oscillator;
+      out[l] += cv->_oscRead;
+      cv->_oscValid += OSCSLICE;
+      due = true;
+    }
+  }
+
+  if (due)
+    bank.Render(osc, out, OSCSLICE);
+
+  _oscPhase = (_oscPhase + 1) % OSCBUFFER;
+}
+
+/*
+ * Fills the buffer with a ramp to the oscillator's next control point
+ * (one oscillator sample per OSCBUFFER output samples)
+ */
+void FASTRUN CVOutput::RenderControl() {
+  int from = _oscBuffer[OSCBUFFER - 1];
+  int delta = _oscillator->RenderControl(OSCBUFFER) - from;
+  for (int i = 0; i < OSCBUFFER; i++)
+    _oscBuffer[i] = from + ((delta * (i + 1)) >> CONTROLSHIFT);
+}
+
+/*
+ * Turns the control rate for slow oscillators on or off (for every output)
+ */
+void CVOutput::SetMultirate(bool multirate) {
+  _multirate = multirate;
+}
+
+/*
+ * Returns what the output needs each sample (RATE_IDLE to RATE_AUDIO)
+ */
+uint8_t CVOutput::GetRate() {
+  if (_oscilMode)
+    return _multirate && _oscillator->ControlRate() ? RATE_CONTROL : RATE_AUDIO;
+  return _set || _slew.Steps > 0 || _envelopeActive ? RATE_RAMP : RATE_IDLE;
+}
+
 /*
  * Update the DAC
  * Keep it Very Lean - Hardly Any CPU to Spare!
@@ -768,13 +883,21 @@ void FASTRUN CVOutput::UpdateDAC(int value){
   }
 
   // invert for DAC circuit
-  if (_oscilMode)
-    value = (int)(value * (_oscillator->Oscillate() / 32768.));
+  if (_oscilMode) {
+    // refill the rest of the slice when it runs out (or was discarded)
+    if (_oscRead >= _oscValid) {
+      if (_oscRead >= OSCBUFFER) _oscRead = 0;
+      _oscValid = (_oscRead / OSCSLICE + 1) * OSCSLICE;
+      _oscillator->Render(_oscBuffer + _oscRead, _oscValid - _oscRead);
+    }
+    value = ScaleQ15(value, _oscBuffer[_oscRead++]);
+  }
 
   // added the conditional write only if the CV value changes
+  // (staged here; writeOutputs() sends all four channels as one frame)
   if (value != _cvHelper){
     _cvHelper = value;
-    _dac.writeChannel(_output, (_dacCenter - _cvHelper));
+    _dac.stageChannel(_output, (_dacCenter - _cvHelper));
   }  
   
 }
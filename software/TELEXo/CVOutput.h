@@ -13,11 +13,25 @@
 #include "Output.h"
 #include "Quantizer.h"
 #include "Oscillator.h"
+#include "OscillatorBank.h"
 #include "TriggerOutput.h"
 
 #define RETRIGGERMS 5
 #define DACCENTER 32767
 
+// oscillator samples buffered per output (the four outputs read in step)
+#define OSCBUFFER 16
+// samples of every buffer rendered on one tick, so the refill is spread over the buffer
+#define OSCSLICE (OSCBUFFER / BANKLANES)
+// a slow oscillator renders one control point per buffer (see RenderOscillators)
+#define CONTROLSHIFT 4 // OSCBUFFER = 1 << CONTROLSHIFT
+
+// what an output needs each sample (see GetRate)
+#define RATE_IDLE 0     // holding a value: nothing to do
+#define RATE_RAMP 1     // slewing or running an envelope: one add a sample
+#define RATE_CONTROL 2  // slow oscillator: rendered at the control rate, ramped between
+#define RATE_AUDIO 3    // oscillator rendered every sample
+
 // 50 microseconds per millisecond - 1000 / 50
 
 struct SlewSteps {
@@ -36,6 +50,11 @@ class CVOutput : public Output
 
     // audio-rate update methid
     void Update();
+    // refills the oscillators that ran out together (once per tick, before Update)
+    static void RenderOscillators(CVOutput * const outputs[BANKLANES], OscillatorBank& bank);
+    // slow oscillators drop to the control rate unless this is turned off
+    static void SetMultirate(bool multirate);
+    uint8_t GetRate();
 
     void SetValue(int value);
     void TargetValue(int value);
@@ -70,6 +89,11 @@ class CVOutput : public Output
     void SetCycle(int value, short format);
     void TargetCycle(int value, short format);
     void SetCenter(int value);
+    void SetScan(int position);
+    void TargetScan(int position);
+    void SetScanSlew(int slew, short format);
+    void SetScanFrom(int wave);
+    void SetScanTo(int wave);
 
     void SetOscQuantizationScale(int scale);
     void SetQuantizedVOct(int value);
@@ -134,7 +158,8 @@ class CVOutput : public Output
     
     int _cvHelper;
 
-    DAC _dac;
+    // shared by the four outputs so their values go out in one frame
+    DAC& _dac;
 
     void UpdateDAC(int value);
     void CalculateSlewValue();
@@ -148,6 +173,16 @@ class CVOutput : public Output
     Oscillator *_oscillator;
     bool _oscilMode = false;
 
+    // rendered oscillator samples; _oscValid drops to zero to discard the rest after a sync
+    int16_t _oscBuffer[OSCBUFFER];
+    uint8_t _oscRead = OSCBUFFER;
+    uint8_t _oscValid = 0;
+    // where every oscillating output reads on this tick (outputs join in step)
+    static uint8_t _oscPhase;
+    static bool _multirate;
+
+    void RenderControl();
+
     void SharedOscil(int value);
 
     int _dacCenter = DACCENTER;
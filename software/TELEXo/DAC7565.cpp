@@ -29,6 +29,8 @@ DAC::DAC(uint8_t enable_pin, uint8_t sync_pin, uint8_t ldac_pin, uint8_t data_pi
   _ldac_pin   = ldac_pin;
   _data_pin   = data_pin;
   _clock_pin  = clock_pin;
+  _staged     = 0;
+  _queue      = NULL;
 
   // Hardware SPI
   // if (clock_pin==-1 && data_pin==-1)
@@ -56,14 +58,14 @@ void DAC::init(void)
   Serial.print("in init for dac\n");
 
   // Sync HIGH
-  if (_sync_pin != -1)
+  if (_sync_pin != (uint8_t)-1)
   {
     pinMode(_sync_pin, OUTPUT);
     digitalWrite(_sync_pin, HIGH);
   }
 
   // LDAC to low
-  if (_ldac_pin != -1)
+  if (_ldac_pin != (uint8_t)-1)
   {
     pinMode(_ldac_pin, OUTPUT);
     digitalWrite(_ldac_pin, LOW);
@@ -100,7 +102,7 @@ void DAC::write(uint32_t data)
 { 
   uint8_t datahigh, datamid, datalow;
 
-  if (_enable_pin != -1)
+  if (_enable_pin != (uint8_t)-1)
     digitalWrite(_enable_pin, LOW);
 
   datahigh = (uint8_t) ((data >> 16) & 0xFF); 
@@ -116,7 +118,7 @@ void DAC::write(uint32_t data)
   Serial.print(F(" Data3="));    Serial.println(datalow,HEX);
 */
 
-  if (_sync_pin != -1)
+  if (_sync_pin != (uint8_t)-1)
     digitalWrite(_sync_pin, LOW);
 
   //SPI.transfer((uint8_t) ((data >> 16) & 0xFF) );
@@ -137,10 +139,10 @@ void DAC::write(uint32_t data)
     shiftOut(_data_pin, _clock_pin, MSBFIRST, datalow);  
   }
 
-  if (_sync_pin != -1) 
+  if (_sync_pin != (uint8_t)-1) 
     digitalWrite(_sync_pin, HIGH);
 
-  if (_enable_pin != -1)
+  if (_enable_pin != (uint8_t)-1)
     digitalWrite(_enable_pin, HIGH);
 }
 
@@ -235,3 +237,106 @@ void DAC::setChannelPower(uint8_t channel, uint16_t power)
   write (data);
 }
 
+
+/* ======================================================================
+Function: stageChannel
+Purpose : hold a channel value for the next frame
+Input   : DAC_CHANNEL_A to DAC_CHANNEL_D
+          data value (in 16 bits)
+Output  : 
+Comments: nothing is sent until writeFrame; staging a channel twice
+          keeps the last value
+====================================================================== */
+void DAC::stageChannel(uint8_t channel, uint16_t value)
+{ 
+  // the broadcast channel has no slot in the frame
+  if (channel < DAC_CHANNEL_A || channel > DAC_CHANNEL_D)
+    return;
+
+  _frame[channel - 1] = value;
+  _staged |= 1 << (channel - 1);
+}
+
+/* ======================================================================
+Function: writeFrame
+Purpose : send the staged channels and latch them together
+Input   : -
+Output  : 
+Comments: each staged channel is stored in its buffer register in
+          channel order and the last one is sent with the simultaneous
+          update, which loads every buffer into its DAC at once; the
+          DAC needs a SYNC falling edge per 24 bit word, so the words
+          go out back to back with enable held low for the whole frame
+          and each one as a 16 bit and an 8 bit transfer; with a queue
+          set the words are handed to it instead
+====================================================================== */
+void DAC::writeFrame(void)
+{ 
+  uint32_t data;
+  uint8_t staged = _staged;
+
+  if (!staged)
+    return;
+
+  _staged = 0;
+
+  if (!_queue && _enable_pin != (uint8_t)-1)
+    digitalWrite(_enable_pin, LOW);
+
+  for (uint8_t i = 0; i < DAC_FRAME_CHANNELS; i++)
+  {
+    if (!(staged & (1 << i)))
+      continue;
+
+    staged &= ~(1 << i);
+
+    // DACSEL1..DACSEL0 hold the channel index
+    data = (uint32_t) i << 17;
+
+    // the last staged channel latches the whole frame
+    data |= staged ? DAC_SINGLE_CHANNEL_STORE : DAC_SIMULTANEOUS_UPDATE;
+    data |= _frame[i];
+
+    if (_queue)
+    {
+      _queue->Push(data);
+      continue;
+    }
+
+    if (_sync_pin != (uint8_t)-1)
+      digitalWrite(_sync_pin, LOW);
+
+    if (_hw_spi)
+    {
+      SPI.transfer16((uint16_t) (data >> 8));
+      SPI.transfer((uint8_t) (data & 0xFF));
+    }
+    else
+    {
+      shiftOut(_data_pin, _clock_pin, MSBFIRST, (uint8_t) ((data >> 16) & 0xFF));  
+      shiftOut(_data_pin, _clock_pin, MSBFIRST, (uint8_t) ((data >>  8) & 0xFF));  
+      shiftOut(_data_pin, _clock_pin, MSBFIRST, (uint8_t) ((data >>  0) & 0xFF));  
+    }
+
+    if (_sync_pin != (uint8_t)-1) 
+      digitalWrite(_sync_pin, HIGH);
+  }
+
+  if (_queue)
+    _queue->Flush();
+  else if (_enable_pin != (uint8_t)-1)
+    digitalWrite(_enable_pin, HIGH);
+}
+
+/* ======================================================================
+Function: setQueue
+Purpose : send frames through a transmit queue
+Input   : the queue (NULL writes them directly again)
+Output  : 
+Comments: only writeFrame uses the queue; the other writes stay
+          blocking and must not be mixed with queued frames
+====================================================================== */
+void DAC::setQueue(DacQueue *queue)
+{ 
+  _queue = queue;
+}
@@ -22,6 +22,7 @@
 #define DAC_H
 
 #include <arduino.h>
+#include "DacQueue.h"
 
 // 24 bits code definition
 #define DAC_REFERENCE_ALWAYS_POWERED_DOWN  0x2000
@@ -55,6 +56,9 @@
 #define DAC_CHANNEL_D   4
 #define DAC_CHANNEL_ALL 5
 
+// number of channels held in a frame (DAC_CHANNEL_A to DAC_CHANNEL_D)
+#define DAC_FRAME_CHANNELS 4
+
 // #define DAC_MAX_SCALE 4096 // Max Scale points (DAC 14 bits)
 #define DAC_MAX_SCALE 65536 // Max Scale points (DAC 16 bits)
 
@@ -66,9 +70,15 @@ class DAC {
     void setReference(uint16_t reference);
     void writeChannel(uint8_t channel, uint16_t value);
     void setChannelPower(uint8_t channel, uint16_t power);
+    void stageChannel(uint8_t channel, uint16_t value);
+    void writeFrame(void);
+    void setQueue(DacQueue *queue);
 
   private:
     void    write(uint32_t data);
+    uint16_t _frame[DAC_FRAME_CHANNELS];
+    uint8_t _staged;
+    DacQueue *_queue;
     uint8_t _enable_pin;
     uint8_t _sync_pin ;
     uint8_t _ldac_pin ;
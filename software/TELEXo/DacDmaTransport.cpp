@@ -0,0 +1,76 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "DacDmaTransport.h"
+
+#if defined(KINETISK)
+
+#include <SPI.h>
+
+/*
+ * Take over SPI0 once the DAC has been set up (after DAC::init)
+ */
+void DacDmaTransport::Begin(){
+
+  // pin 10 (PTC4) as SPI0_PCS0 - SPI.begin() already set it idle high
+  CORE_PIN10_CONFIG = PORT_PCR_MUX(2);
+
+  // request DMA whenever the transmit FIFO has room
+  SPI0_RSER = SPI_RSER_TFFF_RE | SPI_RSER_TFFF_DIRS;
+
+  _dma.destination((volatile uint32_t &)SPI0_PUSHR);
+  _dma.triggerAtHardwareEvent(DMAMUX_SOURCE_SPI0_TX);
+  _dma.disableOnCompletion();
+
+}
+
+/*
+ * Queue the words as FIFO commands and let the DMA push them
+ */
+void FASTRUN DacDmaTransport::Start(const uint32_t *words, uint8_t count){
+
+  uint8_t c = 0;
+
+  // chip select stays low for the three bytes of a word (CONT) and rises after the last
+  for (uint8_t i = 0; i < count; i++){
+    _commands[c++] = SPI_PUSHR_PCS(1) | SPI_PUSHR_CONT | ((words[i] >> 16) & 0xFF);
+    _commands[c++] = SPI_PUSHR_PCS(1) | SPI_PUSHR_CONT | ((words[i] >> 8) & 0xFF);
+    _commands[c++] = SPI_PUSHR_PCS(1) | (words[i] & 0xFF);
+  }
+
+  // end of queue - the flag marks the last byte shifted out
+  _commands[c - 1] |= SPI_PUSHR_EOQ;
+
+  _dma.sourceBuffer(_commands, c * sizeof(uint32_t));
+  _sending = true;
+  _dma.enable();
+
+  // clearing the end of queue flag (and the unread receive data) restarts the transfers
+  SPI0_MCR |= SPI_MCR_CLR_RXF;
+  SPI0_SR = SPI_SR_EOQF | SPI_SR_RFOF;
+
+}
+
+/*
+ * Still shifting out?
+ */
+bool FASTRUN DacDmaTransport::Busy(){
+
+  if (_sending && (SPI0_SR & SPI_SR_EOQF))
+    _sending = false;
+
+  return _sending;
+
+}
+
+/*
+ * Spin until the last word has gone out
+ */
+void FASTRUN DacDmaTransport::Wait(){
+  while (Busy());
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef DacDmaTransport_h
+#define DacDmaTransport_h
+
+#if defined(KINETISK)
+
+#include "Arduino.h"
+#include <DMAChannel.h>
+#include "DacQueue.h"
+
+/*
+ * Feeds the SPI0 transmit FIFO from DMA
+ * SYNC (pin 10) becomes the FIFO's chip select, framing each 24-bit word
+ */
+class DacDmaTransport : public DacTransport
+{
+  public:
+
+    void Begin();
+
+    void Start(const uint32_t *words, uint8_t count);
+    bool Busy();
+    void Wait();
+
+  private:
+
+    DMAChannel _dma;
+
+    // three FIFO commands (one per byte) for each word
+    uint32_t _commands[DACQUEUESIZE * 3];
+    volatile bool _sending = false;
+
+};
+
+#endif
+
+#endif
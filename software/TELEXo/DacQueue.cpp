@@ -0,0 +1,85 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "DacQueue.h"
+
+/*
+ * Constructor
+ */
+DacQueue::DacQueue(DacTransport *transport){
+  _transport = transport;
+}
+
+/*
+ * Add a word to the buffer being filled
+ * (waits for the transport only if the buffer is full)
+ */
+void FASTRUN DacQueue::Push(uint32_t word){
+
+  if (_count == DACQUEUESIZE){
+    _stalls++;
+    _transport->Wait();
+    Send();
+  }
+
+  _buffer[_fill][_count++] = word;
+
+}
+
+/*
+ * Hand the filled buffer to the transport at the end of a tick
+ * If the last one is still going out the words stay put and
+ * leave with the next tick's (the DAC keeps the order anyway)
+ */
+void FASTRUN DacQueue::Flush(){
+
+  if (!_count) return;
+
+  if (_transport->Busy()){
+    _overruns++;
+    return;
+  }
+
+  Send();
+
+}
+
+/*
+ * Send everything queued and wait for it
+ */
+void DacQueue::Drain(){
+  _transport->Wait();
+  Send();
+  _transport->Wait();
+}
+
+/*
+ * Swap the buffers (the transport must be idle)
+ */
+void FASTRUN DacQueue::Send(){
+
+  if (!_count) return;
+
+  _transport->Start(_buffer[_fill], _count);
+  _fill ^= 1;
+  _count = 0;
+
+}
+
+/*
+ * Ticks that ended with the previous buffer still going out
+ */
+unsigned long DacQueue::Overruns(){
+  return _overruns;
+}
+
+/*
+ * Times the ISR had to wait for the transport
+ */
+unsigned long DacQueue::Stalls(){
+  return _stalls;
+}
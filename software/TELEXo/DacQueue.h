@@ -0,0 +1,65 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef DacQueue_h
+#define DacQueue_h
+
+#include "Arduino.h"
+
+// DAC words held per buffer (four full frames)
+#define DACQUEUESIZE 16
+
+/*
+ * Sends a buffer of 24-bit DAC words without the CPU
+ * (DMA on the Teensy, a timed model on the host)
+ */
+class DacTransport
+{
+  public:
+
+    virtual ~DacTransport() {}
+
+    // starts sending; the words must stay untouched until Busy() is false
+    virtual void Start(const uint32_t *words, uint8_t count) = 0;
+    virtual bool Busy() = 0;
+    // blocks until the words have gone out
+    virtual void Wait() = 0;
+
+};
+
+/*
+ * Double-buffered DAC transmit queue
+ * The ISR fills one buffer while the transport sends the other
+ */
+class DacQueue
+{
+  public:
+
+    DacQueue(DacTransport *transport);
+
+    void Push(uint32_t word);
+    void Flush();
+    void Drain();
+
+    unsigned long Overruns();
+    unsigned long Stalls();
+
+  private:
+
+    void Send();
+
+    DacTransport *_transport;
+
+    uint32_t _buffer[2][DACQUEUESIZE];
+    uint8_t _fill = 0;
+    uint8_t _count = 0;
+
+    unsigned long _overruns = 0;
+    unsigned long _stalls = 0;
+
+};
+
+#endif
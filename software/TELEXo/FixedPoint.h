@@ -0,0 +1,104 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef FixedPoint_h
+#define FixedPoint_h
+
+#include <string.h>
+
+#include "Arduino.h"
+
+/*
+ * Integer helpers for the per-sample path, so the ISR has no float or
+ * double math (the Teensy 3.2 emulates both in software)
+ *
+ * Table interpolation used to be (int)(a + frac * 2^-23 * (b - a)) with a
+ * double scaler, which is exactly trunc((a * 2^23 + frac * (b - a)) / 2^23).
+ * Splitting the 23-bit fraction into 14 high and 9 low bits keeps every
+ * product inside 16 x 16 bits (b - a is taken as b * w - a * w), so the same
+ * result comes out of two signed dual 16-bit multiply-adds and a few shifts.
+ * The two neighbouring samples are read as one 32-bit pair (a low, b high).
+ */
+
+#define LERPHIBITS 14
+#define LERPLOBITS 9
+#define LERPLOMASK 511
+
+/*
+ * The samples at a location and the next as one word
+ */
+static inline uint32_t TablePair(const int16_t *table, uint32_t location) {
+  uint32_t pair;
+  memcpy(&pair, table + location, sizeof(pair));
+  return pair;
+}
+
+/*
+ * Rounds the split products towards zero
+ */
+static inline int LerpTruncate(int a, int32_t p, int32_t q) {
+  int32_t x = p + (q >> LERPLOBITS);
+  int down = a + (x >> LERPHIBITS);
+  return down < 0 && ((x & ((1 << LERPHIBITS) - 1)) | (q & LERPLOMASK)) ? down + 1 : down;
+}
+
+#if defined(KINETISK)
+
+/*
+ * Cortex-M4 dual 16-bit multiply, add the products
+ */
+static inline int32_t Smuad(uint32_t x, uint32_t y) {
+  int32_t result;
+  asm ("smuad %0, %1, %2" : "=r" (result) : "r" (x), "r" (y));
+  return result;
+}
+
+/*
+ * Interpolates a sample pair by a 23-bit fraction: SMUAD multiplies (a, b) by (-w, w)
+ */
+static inline int PairLerp(uint32_t pair, uint32_t frac) {
+  uint32_t hi = frac >> LERPLOBITS;
+  uint32_t lo = frac & LERPLOMASK;
+  int32_t p = Smuad(pair, (uint16_t)-hi | (hi << 16));
+  int32_t q = Smuad(pair, (uint16_t)-lo | (lo << 16));
+  return LerpTruncate((int16_t)pair, p, q);
+}
+
+#else
+
+/*
+ * Interpolates a sample pair by a 23-bit fraction
+ */
+static inline int PairLerp(uint32_t pair, uint32_t frac) {
+  int a = (int16_t)pair;
+  int diff = (int16_t)(pair >> 16) - a;
+  return LerpTruncate(a, (int32_t)(frac >> LERPLOBITS) * diff, (int32_t)(frac & LERPLOMASK) * diff);
+}
+
+#endif
+
+/*
+ * Reads a table at a location, interpolating towards the next sample by a 23-bit fraction
+ */
+static inline int TableLerp(const int16_t *table, uint32_t location, uint32_t frac) {
+  return PairLerp(TablePair(table, location), frac);
+}
+
+/*
+ * Crossfades two 16-bit samples by a Q15 weight (0 is all a)
+ */
+static inline int CrossfadeQ15(int a, int b, int weight) {
+  return a + (((b - a) * weight) >> 15);
+}
+
+/*
+ * Scales a value by a Q15 sample, truncating like value * (sample / 32768.)
+ */
+static inline int ScaleQ15(int value, int sample) {
+  return value * sample / 32768;
+}
+
+#endif
@@ -7,123 +7,234 @@
 #include "defines.h" 
 #include "Arduino.h"
 #include "Oscillator.h"
+#include "FixedPoint.h"
 #include "Wavetables.h"
+#include "UserTables.h"
+
+#ifdef BASIC
+// the 3.2 reads the scanned tables without interpolating, like its morph
+#define SCANMASK 0
+#else
+#define SCANMASK PHASEMASK
+#endif
+
+// the user tables follow the noise
+#define USERWAVE (WAVETABLECOUNT + 1)
+
+bool Oscillator::_bandLimit = true;
 
 /*
  * Constructor; requires the sampling rate
  */
 Oscillator::Oscillator() {
+  _scanTo = (WAVETABLECOUNT - 1) * MORPHRANGE;
+  SelectKernel();
+  SelectRectifier();
+  SelectLevels();
 }
 
 /*
- * The primary function called once per sample.
- * Every operation counts here; if you can, do math elsewhere.
+ * Reads a band-limited level at a phase (a zero mask reads without interpolating)
+ */
+inline int Oscillator::ReadLevel(const TableLevel& level, uint32_t phase, uint32_t mask) {
+  return TableLerp(level.Table, phase >> (REDUCEBITS + level.Shift), (phase >> level.Shift) & mask);
+}
+
+/*
+ * Moves the scan position one sample along its slide (only called while it slides)
+ */
+inline void Oscillator::StepScan() {
+  if (--_scanSteps == 0)
+    _scanPosition = _scanTarget;
+  else
+    _scanPosition += _scanDelta;
+}
+
+/*
+ * Reads the scan at a phase: the two tables around the position, crossfaded
+ * by its fraction (a Q15 weight instead of the morph's divide)
  */
-float Oscillator::Oscillate() {
+inline int Oscillator::ReadScan(uint32_t phase, bool slide) {
+  uint32_t table = _scanPosition >> 32;
+  if (table != _scanTable || slide != _scanSlide)
+    SelectScanLevels(table, slide);
+  int a = ReadLevel(_scanLevel, phase, SCANMASK);
+  int b = ReadLevel(_scanNextLevel, phase, SCANMASK);
+  return CrossfadeQ15(a, b, (uint32_t)_scanPosition >> 17);
+}
+
+/*
+ * Renders the scan for a block in runs that stay on one pair of tables (and
+ * one side of the frequency slide): the position steps once a run and the
+ * weight steps by its fraction, landing where stepping each sample would
+ */
+void Oscillator::RenderScan(int *value, size_t n, size_t porta) {
+  size_t i = 0;
+  while (i < n) {
+    bool slide = i < porta;
+    size_t run = (slide ? porta : n) - i;
+    if (_scanSteps) StepScan();
+    uint32_t table = _scanPosition >> 32;
+    if (table != _scanTable || slide != _scanSlide)
+      SelectScanLevels(table, slide);
+    uint32_t fraction = (uint32_t)_scanPosition;
+    uint32_t step = 0;
+    if (_scanSteps) {
+      // the plain steps left before the slide lands or crosses into another
+      // table (divided out only when the run would cross)
+      uint64_t distance = _scanDelta < 0 ? -(uint64_t)_scanDelta : (uint64_t)_scanDelta;
+      uint32_t room = _scanDelta < 0 ? fraction : 0xFFFFFFFF - fraction;
+      unsigned long steps = run - 1 < _scanSteps - 1 ? run - 1 : _scanSteps - 1;
+      if (distance >> 32)
+        steps = 0;
+      else if (steps * distance > room)
+        steps = room / (uint32_t)distance;
+      run = steps + 1;
+      step = (uint32_t)_scanDelta;
+      _scanSteps -= run - 1;
+      _scanPosition += (int64_t)(run - 1) * _scanDelta;
+    }
+    // (copies, which the stores to value[] can't alias)
+    const TableLevel level = _scanLevel;
+    const TableLevel next = _scanNextLevel;
+    for (size_t end = i + run; i < end; i++, fraction += step)
+      value[i] = CrossfadeQ15(ReadLevel(level, _blockPhase[i], SCANMASK),
+        ReadLevel(next, _blockPhase[i], SCANMASK), fraction >> 17);
+  }
+}
+
+/*
+ * Steps the phase one sample with the 32 fractional bits (and the slide, if any)
+ * returns whether the step slid on this sample
+ */
+inline bool Oscillator::StepPrecise() {
+
+  bool slid = false;
 
-  // slew frequency?
   if (_portamento) {
+    uint64_t step = ((uint64_t)_ulstep << 32) | _stepFraction;
     if (_steps-- <= 0){
-      _ulstep = _targetUlstep;
+      step = _preciseTarget;
       _portamento = false;
     } else {
-      _ulstep = _sign ? _ulstep + _delta : _ulstep - _delta;
+      step = _sign ? step + _preciseDelta : step - _preciseDelta;
+      slid = true;
+    }
+    _ulstep = step >> 32;
+    _stepFraction = (uint32_t)step;
+    if (!_portamento) {
+      // landed at audio rate: back to the 32-bit step
+      if (_ulstep >= PRECISESTEP) {
+        _precise = false;
+        _stepFraction = 0;
+      }
+      _blepRecip = BlepReciprocal(_ulstep);
     }
   }
 
-  // unsigned long automatically wraps
-  _actualPhase += _ulstep;
+  // carry out of the fraction into the 32-bit phase
+  uint32_t fraction = _phaseFraction + _stepFraction;
+  _actualPhase += _ulstep + (fraction < _phaseFraction);
+  _phaseFraction = fraction;
 
-  // reduce this down to meet the tablesize range
-  _location = _actualPhase >> REDUCEBITS;
+  return slid;
+}
+
+/*
+ * The primary function called once per sample.
+ * Every operation counts here; if you can, do math elsewhere.
+ */
+int Oscillator::Oscillate() {
 
-  // too expensive to do this for the primary and morphing waveforms -
-  // we do the PolyBlep calculations once for both
-  if (_blepItOne){
-    _blepOne = PolyBlepFixed(_actualPhase);
-    if (_blepItTwo){
-      _blepTwo = PolyBlepFixed((FULLPHASEL - _ulWidth + 1) + _actualPhase);
+  if (_precise) {
+    // slow LFOs and slides step with the fractional bits
+    StepPrecise();
+  } else {
+    // slew frequency?
+    if (_portamento) {
+      if (_steps-- <= 0){
+        _ulstep = _targetUlstep;
+        _portamento = false;
+        _blepRecip = BlepReciprocal(_ulstep);
+      } else {
+        _ulstep = _sign ? _ulstep + _delta : _ulstep - _delta;
+      }
     }
+
+    // the 32-bit phase automatically wraps
+    _actualPhase += _ulstep;
   }
 
+  // reduce this down to meet the tablesize range
+  _location = _actualPhase >> REDUCEBITS;
+
+  // the reciprocal is stale while the step slides (the edges divide instead)
+  uint32_t recip = _portamento ? 0 : _blepRecip;
+
+  // the band-limited levels for the step (the slide's until it lands)
+  const TableLevel& level = _portamento ? _slideLevel : _level;
+  const TableLevel& morphLevel = _portamento ? _slideMorphLevel : _morphLevel;
+
+  // the edge at phase zero is shared by the primary and morphing waveforms
+  int blep = _blepIt ? PolyBlep(_actualPhase, _ulstep, recip) : 0;
+
   // optimized to chained if statements
-  if (_wave == SQUARE_WAVE) { 
+  if (_scanning) {
+    if (_scanSteps) StepScan();
+    _lastValue = ReadScan(_actualPhase, _portamento);
+  } else if (_wave == SQUARE_WAVE) { 
     _lastValue =  _actualPhase < _ulWidth ? 32767 : -32767;    
-  #ifdef TURBO
-    // polyblep frequencies above 20k
-    if (_ulstep >= FQ20K){
-      _lastValue -= _blepOne;
-      _lastValue += _blepTwo;     
-    }
-  #endif
+    // rising edge at zero, falling edge at the width
+    _lastValue += blep - PolyBlep(_actualPhase - _ulWidth, _ulstep, recip);
   } else if (_wave == SAW_WAVE) {  
     // do actual calculations when we have the CPU
     _lastValue = (int)(_actualPhase >> 16) - 32767;
-  #ifdef TURBO
-    // polyblep frequencies above 20k
-    if (_ulstep >= FQ20K)
-      _lastValue -= _blepOne;      
+    _lastValue -= blep;
   } else if (_wave == TRIANGLE_WAVE) { 
-    // do actual calculations when we have the CPU  
+    // cheaper than the table; the corners are rounded with polyblamp
     _lastValue = _actualPhase & 0x80000000 ? (int)((FULLPHASEL - _actualPhase) >> 15) - 32767 : (int)(_actualPhase >> 15) - 32767;
-  #endif 
-  // fall back on the table if we don't have the CPU to spare
-  } else if (_wave < WAVETABLECOUNT) {
+    _lastValue += PolyBlamp(_actualPhase, _ulstep, recip) - PolyBlamp(_actualPhase - HALFPHASE, _ulstep, recip);
+  // fall back on the table if we don't have the CPU to spare (or a user table)
+  } else if (_wave != WAVETABLECOUNT) {
     #ifdef BASIC
     if (_portamento || _morphing || _doRect){
       // no interpolation or rounding
-      _lastValue =  wavetables[_wave][_location];
+      _lastValue =  ReadLevel(level, _actualPhase, 0);
     } else {  
     #endif
-      // interpolate using some fixed math magic (and a floating point scaler)
-      _lastValue = wavetables[_wave][_location] + (_actualPhase & PHASEMASK) * _phasescale * (wavetables[_wave][_location + 1] - wavetables[_wave][_location]);
+      // interpolate in fixed point (see FixedPoint.h)
+      _lastValue = ReadLevel(level, _actualPhase, PHASEMASK);
     #ifdef BASIC
     }
     #endif
-  } else if (_wave == WAVETABLECOUNT) {
+  } else {
     // generate a new number if we have flipped
     if (_actualPhase < _oldPhase)
-      _lastValue = random(0, 65536) - 32878.;
+      _lastValue = random(0, 65536) - 32878;
     _oldPhase = _actualPhase;
-  } else {
-    _lastValue =  0;
   }
 
   // optimized by moving to chained if statements
   if (_morphing){
-    if (_morphWave == 3) {
+    if (_morphWave == SQUARE_WAVE) {
       _morphValue =  _actualPhase & 0x80000000 ? 32767 : -32767;   
-    #ifdef TURBO
-      // polyblep frequencies above 20k
-      if (_ulstep >= FQ20K){
-        _morphValue -= _blepOne;
-        _morphValue += _blepTwo;     
-      }
-    #endif
-    } else if (_wave == SAW_WAVE) {  
-      // do actual calculations when we have the CPU
-      _morphValue = (int)(_actualPhase >> 16) - 32767;
-    #ifdef TURBO
-      // polyblep frequencies above 20k
-      if (_ulstep >= FQ20K)
-        _morphValue -= _blepOne;      
+      // rising edge at half, falling edge at zero
+      _morphValue += PolyBlep(_actualPhase - HALFPHASE, _ulstep, recip) - blep;
     } else if (_morphWave == TRIANGLE_WAVE) { 
       // do actual calculations when we have the CPU 
       _morphValue =  _actualPhase & 0x80000000 ? (int)((FULLPHASEL - _actualPhase) >> 15) - 32767 : (int)(_actualPhase >> 15) - 32767 ;  
-    #endif 
+      _morphValue += PolyBlamp(_actualPhase, _ulstep, recip) - PolyBlamp(_actualPhase - HALFPHASE, _ulstep, recip);
     // fall back on the table if we don't have the CPU to spare
-    } else if (_morphWave < WAVETABLECOUNT){
+    } else if (_morphWave != WAVETABLECOUNT){
       #ifdef BASIC
-      _morphValue =  wavetables[_morphWave][_location];
+      _morphValue =  ReadLevel(morphLevel, _actualPhase, 0);
       #else
-      _morphValue =  wavetables[_morphWave][_location] + (_actualPhase & PHASEMASK) * _phasescale * (wavetables[_morphWave][_location + 1] - wavetables[_morphWave][_location]);
+      _morphValue =  ReadLevel(morphLevel, _actualPhase, PHASEMASK);
     #endif
-    } else if (_morphWave == WAVETABLECOUNT) {
+    } else {
       if (_actualPhase < _oldPhase)
-        _morphValue = random(0, 65536) - 32878.;
+        _morphValue = random(0, 65536) - 32878;
       _oldPhase = _actualPhase;
-    } else {
-      _morphValue =  0;
     }
     _lastValue = (_lastValue * _invMorph + _morphValue * _morph) / MORPHRANGE;
   }
@@ -145,6 +256,405 @@ float Oscillator::Oscillate() {
   
 }
 
+/*
+ * Renders a block of samples; the same samples as n calls to Oscillate()
+ * (saturated to 16 bits) but with the mode decisions made once per block
+ */
+void Oscillator::Render(int16_t *out, size_t n) {
+  size_t count;
+  while (n > 0) {
+    count = n < RENDERBLOCK ? n : RENDERBLOCK;
+    RenderBlock(out, count);
+    out += count;
+    n -= count;
+  }
+}
+
+/*
+ * Moves the phase on n samples and renders only the last of them
+ * (the phase lands exactly where n samples of Render() would leave it)
+ */
+int Oscillator::RenderControl(size_t n) {
+
+  if (_precise) {
+    uint64_t phase = ((uint64_t)_actualPhase << 32) | _phaseFraction;
+    phase += (((uint64_t)_ulstep << 32) | _stepFraction) * n;
+    _actualPhase = phase >> 32;
+    _phaseFraction = (uint32_t)phase;
+  } else {
+    _actualPhase += _ulstep * n;
+  }
+
+  _blockPhase[0] = _actualPhase;
+  _blockStep[0] = _ulstep;
+  _location = _actualPhase >> REDUCEBITS;
+
+  (this->*_kernel)(1, 0);
+
+  _lastValue = _blockValue[0];
+  return constrain(_lastValue, -32768, 32767);
+}
+
+/*
+ * Whether the oscillator is slow enough (and steady) to render at the control rate
+ * edges and noise stay at audio rate so they are not ramped over a control period
+ */
+bool Oscillator::ControlRate() {
+  if (_portamento || _ulstep >= CONTROLSTEP || _blepIt)
+    return false;
+  // a sliding scan moves its position every sample
+  if (_scanning)
+    return _scanSteps == 0;
+  return _wave != WAVETABLECOUNT && !(_morphing && _morphWave == WAVETABLECOUNT);
+}
+
+/*
+ * Renders up to RENDERBLOCK samples with the kernel selected for the waveform
+ */
+void Oscillator::RenderBlock(int16_t *out, size_t n) {
+
+  size_t i;
+  size_t porta = AdvanceBlock(n);
+
+  (this->*_kernel)(n, porta);
+
+  _lastValue = _blockValue[n - 1];
+
+  for (i = 0; i < n; i++)
+    out[i] = constrain(_blockValue[i], -32768, 32767);
+}
+
+/*
+ * Steps the phase (and portamento) for a block, keeping each sample's phase and step
+ * returns the number of leading samples that were rendered with portamento active
+ */
+size_t Oscillator::AdvanceBlock(size_t n) {
+
+  size_t i = 0;
+  size_t porta = 0;
+
+  if (_precise) {
+    for (; i < n; i++) {
+      if (StepPrecise()) porta = i + 1;
+      _blockPhase[i] = _actualPhase;
+      _blockStep[i] = _ulstep;
+    }
+    _location = _actualPhase >> REDUCEBITS;
+    return porta;
+  }
+
+  // portamento runs until it lands, then the rest of the block has a fixed step
+  while (_portamento && i < n) {
+    if (_steps-- <= 0){
+      _ulstep = _targetUlstep;
+      _portamento = false;
+      _blepRecip = BlepReciprocal(_ulstep);
+    } else {
+      _ulstep = _sign ? _ulstep + _delta : _ulstep - _delta;
+      porta = i + 1;
+    }
+    _actualPhase += _ulstep;
+    _blockPhase[i] = _actualPhase;
+    _blockStep[i++] = _ulstep;
+  }
+  for (; i < n; i++) {
+    _actualPhase += _ulstep;
+    _blockPhase[i] = _actualPhase;
+    _blockStep[i] = _ulstep;
+  }
+
+  _location = _actualPhase >> REDUCEBITS;
+
+  return porta;
+}
+
+/*
+ * Returns the kernel family for a waveform (as the primary or the morph target)
+ */
+uint8_t Oscillator::GetFamily(uint16_t wave, bool primary) {
+  if (wave == WAVETABLECOUNT)
+    return FAMILY_NOISE;
+  if (wave == SQUARE_WAVE)
+    return primary ? FAMILY_PULSE : FAMILY_SQUARE;
+  if (primary && wave == SAW_WAVE)
+    return FAMILY_SAW;
+  if (wave == TRIANGLE_WAVE)
+    return FAMILY_TRIANGLE;
+  return FAMILY_TABLE;
+}
+
+/*
+ * Returns the band-limited level of a waveform for a step: the first whose
+ * highest harmonic stays below Nyquist (Wavetables.h only belongs to this file)
+ */
+TableLevel Oscillator::GetLevel(uint16_t wave, uint32_t ulstep) {
+  TableLevel level = { wavemips[0][0], 0, 0 };
+  // the user tables have no levels: they are read as uploaded
+  if (wave >= USERWAVE)
+    level.Table = UserTables::Table(wave - USERWAVE);
+  if (wave >= WAVETABLECOUNT)
+    return level;
+  uint32_t top = wavetops[wave];
+  uint32_t harmonics = TABLERANGEDIV2;
+  while (_bandLimit && level.Level < WAVEMIPS && (uint64_t)min(top, harmonics) * ulstep > HALFPHASE) {
+    harmonics = (TABLERANGEDIV2 >> ++level.Level) - 1;
+#ifdef BASIC
+    // at this rate level 1's images fold into the band, where it makes them stronger
+    if (level.Level == 1 && level.Level < WAVEMIPS && waveimaged[wave])
+      harmonics = (TABLERANGEDIV2 >> ++level.Level) - 1;
+#endif
+  }
+  level.Table = wavemips[wave][level.Level];
+  level.Shift = LEVELSHIFT(level.Level);
+  return level;
+}
+
+/*
+ * Picks the levels for the step (or for the target and the higher end of a slide)
+ */
+void Oscillator::SelectLevels() {
+  uint32_t step = _portamento ? _targetUlstep : _ulstep;
+  uint32_t slide = _portamento && _ulstep > step ? _ulstep : step;
+  _level = GetLevel(_wave, step);
+  _morphLevel = GetLevel(_morphWave, step);
+  _slideLevel = GetLevel(_wave, slide);
+  _slideMorphLevel = GetLevel(_morphWave, slide);
+  // the scan picks its levels as its position crosses the tables
+  _levelStep = step;
+  _slideLevelStep = slide;
+  _scanTable = SCANNOTABLE;
+}
+
+/*
+ * Picks the levels of the two tables around the scan position
+ * (the last table fades into itself)
+ */
+void Oscillator::SelectScanLevels(uint32_t table, bool slide) {
+  uint32_t step = slide ? _slideLevelStep : _levelStep;
+  _scanTable = table;
+  _scanSlide = slide;
+  _scanLevel = GetLevel(table, step);
+  _scanNextLevel = GetLevel(table + 1 < WAVETABLECOUNT ? table + 1 : table, step);
+}
+
+/*
+ * Turns the band-limited levels on or off (for oscillators set from then on)
+ */
+void Oscillator::SetBandLimit(bool bandLimit) {
+  _bandLimit = bandLimit;
+}
+
+/*
+ * Swaps in the kernel for the current waveform and morph target
+ * only the pairs SetWaveform can produce are instantiated (morph is always _wave + 1)
+ */
+void Oscillator::SelectKernel() {
+
+  uint8_t morph = _morphing ? GetFamily(_morphWave, false) : FAMILY_NONE;
+
+  if (_scanning) {
+    _kernel = &Oscillator::RenderKernel<FAMILY_SCAN, FAMILY_NONE>;
+    return;
+  }
+
+  switch (GetFamily(_wave, true)) {
+    case FAMILY_PULSE:
+      if (morph == FAMILY_NOISE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_PULSE, FAMILY_NOISE>;
+      else if (morph == FAMILY_TABLE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_PULSE, FAMILY_TABLE>;
+      else
+        _kernel = &Oscillator::RenderKernel<FAMILY_PULSE, FAMILY_NONE>;
+      break;
+    case FAMILY_SAW:
+      if (morph == FAMILY_SQUARE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_SAW, FAMILY_SQUARE>;
+      else
+        _kernel = &Oscillator::RenderKernel<FAMILY_SAW, FAMILY_NONE>;
+      break;
+    case FAMILY_TRIANGLE:
+      if (morph == FAMILY_TABLE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_TRIANGLE, FAMILY_TABLE>;
+      else
+        _kernel = &Oscillator::RenderKernel<FAMILY_TRIANGLE, FAMILY_NONE>;
+      break;
+    case FAMILY_NOISE:
+      if (morph == FAMILY_TABLE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_NOISE, FAMILY_TABLE>;
+      else
+        _kernel = &Oscillator::RenderKernel<FAMILY_NOISE, FAMILY_NONE>;
+      break;
+    default:
+      if (morph == FAMILY_NOISE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_TABLE, FAMILY_NOISE>;
+      else if (morph == FAMILY_TABLE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_TABLE, FAMILY_TABLE>;
+      else if (morph == FAMILY_TRIANGLE)
+        _kernel = &Oscillator::RenderKernel<FAMILY_TABLE, FAMILY_TRIANGLE>;
+      else
+        _kernel = &Oscillator::RenderKernel<FAMILY_TABLE, FAMILY_NONE>;
+      break;
+  }
+}
+
+/*
+ * Swaps in the rectifier for the current rectification mode
+ */
+void Oscillator::SelectRectifier() {
+  switch (_rectify) {
+    case -2: _rectifier = &Oscillator::RectifyBlock<-2>; break;
+    case -1: _rectifier = &Oscillator::RectifyBlock<-1>; break;
+    case 1: _rectifier = &Oscillator::RectifyBlock<1>; break;
+    case 2: _rectifier = &Oscillator::RectifyBlock<2>; break;
+    default: _rectifier = &Oscillator::RectifyBlock<0>; break;
+  }
+}
+
+/*
+ * A block kernel: the primary waveform, its morph target and the rectifier
+ * every family test below is a compile-time constant, so each kernel is branch free
+ */
+template <uint8_t Wave, uint8_t Morph>
+void Oscillator::RenderKernel(size_t n, size_t porta) {
+
+  size_t i;
+
+  // the edge at phase zero is shared by the primary and morphing waveforms
+  // (the reciprocal is stale while the step slides, so those samples divide instead)
+  if (Wave == FAMILY_PULSE || Wave == FAMILY_SAW || Morph == FAMILY_SQUARE) {
+    for (i = 0; i < porta; i++)
+      _blockBlep[i] = PolyBlep(_blockPhase[i], _blockStep[i], 0);
+    for (; i < n; i++)
+      _blockBlep[i] = PolyBlep(_blockPhase[i], _ulstep, _blepRecip);
+  }
+
+  if (Wave == FAMILY_NOISE) {
+    RenderHeldNoise<Morph>(n, porta);
+    return;
+  }
+
+  RenderFamily<Wave, true>(_blockValue, n, porta);
+
+  if (Morph != FAMILY_NONE) {
+    RenderFamily<Morph, false>(_blockMorph, n, porta);
+    for (i = 0; i < n; i++)
+      _blockValue[i] = (_blockValue[i] * _invMorph + _blockMorph[i] * _morph) / MORPHRANGE;
+    _morphValue = _blockMorph[n - 1];
+  }
+
+  (this->*_rectifier)(_blockValue, n);
+}
+
+/*
+ * Renders one waveform family for the block (as the primary or the morph target)
+ */
+template <uint8_t Family, bool Primary>
+void Oscillator::RenderFamily(int *value, size_t n, size_t porta) {
+
+  size_t i;
+
+  if (Family == FAMILY_PULSE) {
+    // rising edge at zero, falling edge at the width
+    for (i = 0; i < porta; i++)
+      _blockEdge[i] = PolyBlep(_blockPhase[i] - _ulWidth, _blockStep[i], 0);
+    for (; i < n; i++)
+      _blockEdge[i] = PolyBlep(_blockPhase[i] - _ulWidth, _ulstep, _blepRecip);
+    for (i = 0; i < n; i++)
+      value[i] = (_blockPhase[i] < _ulWidth ? 32767 : -32767) + _blockBlep[i] - _blockEdge[i];
+  } else if (Family == FAMILY_SQUARE) {
+    // the morph target ignores the pulse width: rising edge at half, falling edge at zero
+    for (i = 0; i < porta; i++)
+      _blockEdge[i] = PolyBlep(_blockPhase[i] - HALFPHASE, _blockStep[i], 0);
+    for (; i < n; i++)
+      _blockEdge[i] = PolyBlep(_blockPhase[i] - HALFPHASE, _ulstep, _blepRecip);
+    for (i = 0; i < n; i++)
+      value[i] = (_blockPhase[i] & 0x80000000 ? 32767 : -32767) + _blockEdge[i] - _blockBlep[i];
+  } else if (Family == FAMILY_SAW) {
+    for (i = 0; i < n; i++)
+      value[i] = (int)(_blockPhase[i] >> 16) - 32767 - _blockBlep[i];
+  } else if (Family == FAMILY_TRIANGLE) {
+    // the corners are rounded with polyblamp (the minimum at zero, the peak at half)
+    for (i = 0; i < porta; i++)
+      _blockEdge[i] = PolyBlamp(_blockPhase[i], _blockStep[i], 0) - PolyBlamp(_blockPhase[i] - HALFPHASE, _blockStep[i], 0);
+    for (; i < n; i++)
+      _blockEdge[i] = PolyBlamp(_blockPhase[i], _ulstep, _blepRecip) - PolyBlamp(_blockPhase[i] - HALFPHASE, _ulstep, _blepRecip);
+    for (i = 0; i < n; i++)
+      value[i] = (_blockPhase[i] & 0x80000000 ? (int)((FULLPHASEL - _blockPhase[i]) >> 15) - 32767 : (int)(_blockPhase[i] >> 15) - 32767) + _blockEdge[i];
+  } else if (Family == FAMILY_TABLE) {
+    // samples before `interpolated` are read without interpolation
+    size_t interpolated = 0;
+  #ifdef BASIC
+    interpolated = (!Primary || _morphing || _doRect) ? n : porta;
+  #endif
+    // the slide's level up to `porta`, then the steady one
+    const TableLevel *level = Primary ? &_slideLevel : &_slideMorphLevel;
+    size_t end = porta;
+    for (i = 0; i < n; end = n, level = Primary ? &_level : &_morphLevel) {
+      const int16_t *table = level->Table;
+      uint8_t reduce = REDUCEBITS + level->Shift;
+      for (; i < end && i < interpolated; i++)
+        value[i] = table[_blockPhase[i] >> reduce];
+      for (; i < end; i++)
+        value[i] = ReadLevel(*level, _blockPhase[i], PHASEMASK);
+    }
+  } else if (Family == FAMILY_SCAN) {
+    RenderScan(value, n, porta);
+  } else if (Family == FAMILY_NOISE) {
+    // only the morph target gets here (see RenderHeldNoise)
+    int held = _morphValue;
+    for (i = 0; i < n; i++) {
+      if (_blockPhase[i] < _oldPhase)
+        held = random(0, 65536) - 32878;
+      _oldPhase = _blockPhase[i];
+      value[i] = held;
+    }
+  }
+}
+
+/*
+ * Noise as the primary waveform holds the previous (morphed and rectified) output
+ * between phase flips, so it has to be finished one sample at a time
+ */
+template <uint8_t Morph>
+void Oscillator::RenderHeldNoise(size_t n, size_t porta) {
+
+  size_t i;
+  int held = _lastValue;
+
+  if (Morph != FAMILY_NONE)
+    RenderFamily<Morph, false>(_blockMorph, n, porta);
+
+  for (i = 0; i < n; i++) {
+    if (_blockPhase[i] < _oldPhase)
+      held = random(0, 65536) - 32878;
+    _oldPhase = _blockPhase[i];
+    if (Morph != FAMILY_NONE)
+      held = (held * _invMorph + _blockMorph[i] * _morph) / MORPHRANGE;
+    (this->*_rectifier)(&held, 1);
+    _blockValue[i] = held;
+  }
+
+  if (Morph != FAMILY_NONE)
+    _morphValue = _blockMorph[n - 1];
+}
+
+/*
+ * Applies a rectification mode to a block (mode 0 leaves it alone)
+ */
+template <int8_t Rect>
+void Oscillator::RectifyBlock(int *value, size_t n) {
+  size_t i;
+  if (Rect == -2) {
+    for (i = 0; i < n; i++) value[i] = -abs(value[i]);
+  } else if (Rect == -1) {
+    for (i = 0; i < n; i++) value[i] = value[i] <= 0 ? value[i] : 0;
+  } else if (Rect == 1) {
+    for (i = 0; i < n; i++) value[i] = value[i] >= 0 ? value[i] : 0;
+  } else if (Rect == 2) {
+    for (i = 0; i < n; i++) value[i] = abs(value[i]);
+  }
+}
+
 /*
  * Sets the frequency of the oscillator
  */
@@ -152,6 +662,18 @@ void Oscillator::SetFreq(float freq){
   _frequency = freq;
   _portamento = false;
   _ulstep = (int)((freq / SAMPLINGRATE) * FULLPHASE);
+  // a slow step truncated to 32 bits would be off by up to one part in _ulstep
+  _precise = _ulstep < PRECISESTEP;
+  if (_precise) {
+    uint64_t step = PreciseStep(freq);
+    _ulstep = step >> 32;
+    _stepFraction = (uint32_t)step;
+  } else {
+    _stepFraction = 0;
+    _phaseFraction = 0;
+  }
+  _blepRecip = BlepReciprocal(_ulstep);
+  SelectLevels();
   #ifdef DEBUG
   Serial.printf("FQ: %f - %lu\n", freq, _ulstep); 
   #endif
@@ -173,8 +695,41 @@ void Oscillator::TargetFreq(float freq){
       _delta = (_ulstep - _targetUlstep) / _stepsCalculated;
       _sign = false;
     }
+    // slow ends and long slides would truncate the step or the delta
+    _precise = _ulstep < PRECISESTEP || _targetUlstep < PRECISESTEP || _delta < PRECISEDELTA;
+    if (_precise) {
+      _preciseTarget = PreciseStep(freq);
+      PreciseSlide();
+    } else {
+      _stepFraction = 0;
+      _phaseFraction = 0;
+    }
     _steps = _stepsCalculated;
     _portamento = true;
+    SelectLevels();
+  }
+}
+
+/*
+ * Returns the 32.32 phase step for a frequency
+ */
+uint64_t Oscillator::PreciseStep(float freq) {
+  return (uint64_t)(freq * (FULLPHASE * FULLPHASE / SAMPLINGRATE));
+}
+
+/*
+ * Sets the 32.32 slide from the current step to the target over the portamento time
+ */
+void Oscillator::PreciseSlide() {
+  uint64_t step = ((uint64_t)_ulstep << 32) | _stepFraction;
+  if (_stepsCalculated == 0) {
+    _preciseDelta = 0;
+  } else if (_preciseTarget > step) {
+    _preciseDelta = (_preciseTarget - step) / _stepsCalculated;
+    _sign = true;
+  } else {
+    _preciseDelta = (step - _preciseTarget) / _stepsCalculated;
+    _sign = false;
   }
 }
 
@@ -253,43 +808,49 @@ void Oscillator::SetWidth(int width) {
 void Oscillator::SetRectify(int mode) {
   _rectify = constrain(mode, -2, 2);
   _doRect = _rectify != 0;
+  SelectRectifier();
 }
 
 /*
  * Sets the waveform for the oscillator
+ * negative waveforms select the user tables: -100 is the first, -150 is half
+ * way from it to the second (the last morphs into the first)
  */
 void Oscillator::SetWaveform(int wave) {
-  _wave = constrain((wave / MORPHRANGE) % (WAVETABLECOUNT + 1), 0, WAVETABLECOUNT);
+  _scanning = false;
+  if (wave <= -MORPHRANGE) {
+    wave = -wave - MORPHRANGE;
+    _wave = USERWAVE + (wave / MORPHRANGE) % USERTABLES;
+    _morphWave = _wave + 1;
+    if (_morphWave >= USERWAVE + USERTABLES) _morphWave = USERWAVE;
+  } else {
+    _wave = constrain((wave / MORPHRANGE) % (WAVETABLECOUNT + 1), 0, WAVETABLECOUNT);
+    _morphWave = _wave + 1;
+    if (_morphWave > WAVETABLECOUNT) _morphWave = 0;
+  }
   #ifdef DEBUG
   Serial.printf("Waveform: %d [%d]\n", _wave, wave);
   #endif
-  _morphWave = _wave + 1;
-  if (_morphWave > WAVETABLECOUNT) _morphWave = 0;
   _morph = wave % MORPHRANGE;
   _invMorph = MORPHRANGE - _morph;
   _morphing = _morph != 0;
 
-  if (_wave == SAW_WAVE || _morphWave == SAW_WAVE){
-    _blepItOne = true;
-    if (_wave == SQUARE_WAVE || _morphWave == SQUARE_WAVE) {
-      _blepItTwo = true;
-    } else {
-      _blepItTwo = false;
-    }
-  } else {
-    _blepItOne = false;
-    _blepItTwo = false;
-  }
+  // the saw and both squares have an edge at phase zero
+  _blepIt = _wave == SAW_WAVE || _wave == SQUARE_WAVE || (_morphing && _morphWave == SQUARE_WAVE);
+
+  SelectKernel();
+  SelectLevels();
 }
 
 /*
  * Resets the phase of the oscillator to its default
  */
 void Oscillator::ResetPhase(long polarity) {
+  _phaseFraction = 0;
   if (polarity == 0)
     _actualPhase = _phaseOffset << PHASEBITS;
   else
-    _actualPhase = _wave < 2 ? (unsigned long)peaks[_wave] : 0 << REDUCEBITS;
+    _actualPhase = _wave < 2 ? (uint32_t)peaks[_wave] : 0 << REDUCEBITS;
 }
 
 /*
@@ -308,17 +869,92 @@ void Oscillator::SetPhaseOffset(int phase) {
 void Oscillator::SetPortamentoMs(unsigned long milliseconds){
   _stepsCalculated = milliseconds * KRATE;
   if (_portamento && _steps > 0){
-      if (_targetUlstep > _ulstep){
+      if (_stepsCalculated == 0){
+        // portamento switched off mid-slide; land on the target next sample
+        _delta = 0;
+      } else if (_targetUlstep > _ulstep){
         _delta = (_targetUlstep - _ulstep) / _stepsCalculated;
         _sign = true;
       } else {
         _delta = (_ulstep - _targetUlstep) / _stepsCalculated;
         _sign = false;
       }
+      if (_precise)
+        PreciseSlide();
     _steps = _stepsCalculated;
   }
 }
 
+/*
+ * Returns the Q32 table position of a scan position (0-SCANRANGE across the range)
+ */
+uint64_t Oscillator::ScanPosition(int position) {
+  int64_t wave = ((int64_t)_scanFrom * SCANRANGE + (int64_t)(_scanTo - _scanFrom) * position);
+  return ((uint64_t)wave << 32) / (SCANRANGE * MORPHRANGE);
+}
+
+/*
+ * Switches to the scan kernel (morph and the edges belong to SetWaveform)
+ */
+void Oscillator::StartScan() {
+  if (_scanning) return;
+  _scanning = true;
+  _morphing = false;
+  _blepIt = false;
+  _scanTable = SCANNOTABLE;
+  SelectKernel();
+}
+
+/*
+ * Sets the scan position (0-16384 across the scan range) and scans from then on
+ */
+void Oscillator::SetScan(int position) {
+  _scanValue = constrain(position, 0, SCANRANGE);
+  _scanPosition = _scanTarget = ScanPosition(_scanValue);
+  _scanSteps = 0;
+  StartScan();
+}
+
+/*
+ * Targets the scan position (slides over the scan slew time)
+ */
+void Oscillator::TargetScan(int position) {
+  if (!_scanning || _scanStepsCalculated == 0) {
+    SetScan(position);
+    return;
+  }
+  _scanValue = constrain(position, 0, SCANRANGE);
+  _scanTarget = ScanPosition(_scanValue);
+  _scanDelta = (int64_t)(_scanTarget - _scanPosition) / (int64_t)_scanStepsCalculated;
+  _scanSteps = _scanStepsCalculated;
+}
+
+/*
+ * Sets the start of the scan range (in SetWaveform units: 450 is halfway from table 4 to 5)
+ * a running scan slides to its position in the new range
+ */
+void Oscillator::SetScanFrom(int wave) {
+  _scanFrom = constrain(wave, 0, (WAVETABLECOUNT - 1) * MORPHRANGE);
+  if (_scanning) TargetScan(_scanValue);
+}
+
+/*
+ * Sets the end of the scan range (it may be below the start)
+ */
+void Oscillator::SetScanTo(int wave) {
+  _scanTo = constrain(wave, 0, (WAVETABLECOUNT - 1) * MORPHRANGE);
+  if (_scanning) TargetScan(_scanValue);
+}
+
+/*
+ * Sets the time the scan position slides for in milliseconds
+ */
+void Oscillator::SetScanSlewMs(unsigned long milliseconds) {
+  _scanStepsCalculated = milliseconds * KRATE;
+  if (_scanSteps > 0)
+    TargetScan(_scanValue);
+}
+
 /*
  * Returns the floating point frequency of the oscillator
  */
@@ -326,23 +962,69 @@ float Oscillator::GetFrequency(){
   return _frequency;
 }
 
+/*
+ * Returns the number of wavetables (the waveform after the last table is noise)
+ */
+int Oscillator::GetWaveformCount(){
+  return WAVETABLECOUNT;
+}
+
+/*
+ * Returns the Q48 reciprocal of a phase step (refreshed whenever the step is set)
+ */
+uint32_t Oscillator::BlepReciprocal(uint32_t ulstep){
+  return ulstep > BLEPMINSTEP ? (uint32_t)(((uint64_t)1 << 48) / ulstep) : 0;
+}
+
+/*
+ * Returns distance / ulstep as Q16 (distance < ulstep), from the reciprocal if there is one
+ */
+uint32_t Oscillator::StepFraction(uint32_t distance, uint32_t ulstep, uint32_t recip){
+  if (recip)
+    return ((uint64_t)distance * recip) >> 32;
+  return ((uint64_t)distance << 16) / ulstep;
+}
+
 /*
  * PolyBLEP by Tale (slightly modified several times)
  * http://www.kvraudio.com/forum/viewtopic.php?t=375517
  * http://www.martin-finke.de/blog/articles/audio-plugins-018-polyblep-oscillator/
  * http://research.spa.aalto.fi/publications/papers/smc2010-phaseshaping/phaseshapers.py
+ *
+ * in Q16 integer math; the correction for a rising edge of 65534 at phase zero
 */ 
-double Oscillator::PolyBlepFixed(unsigned long ulT){
-    // 0 <= t < 1
-    if (ulT < _ulstep) {
-        t = (double)ulT / _ulstep;
-        return (t+t - t*t - 1.0) * 32767;
+int Oscillator::PolyBlep(uint32_t ulT, uint32_t ulstep, uint32_t recip){
+    uint32_t x;
+    if (ulstep < BLEPMINSTEP)
+        return 0;
+    // 0 <= t < 1: -(1 - t)^2
+    if (ulT < ulstep) {
+        x = 65536 - StepFraction(ulT, ulstep, recip);
+        return -(int)(((uint64_t)x * x * 32767) >> 32);
     }
-    // -1 < t < 0
-    else if (ulT > FULLPHASE - _ulstep) {
-        t = ((double)ulT - FULLPHASE) / _ulstep;
-        return (t*t + t+t + 1.0) * 32767;
+    // -1 < t < 0: (1 + t)^2
+    if (ulT > 0 - ulstep) {
+        x = 65536 - StepFraction(0 - ulT, ulstep, recip);
+        return (int)(((uint64_t)x * x * 32767) >> 32);
     }
     // 0 otherwise
-    else return 0.0;
+    return 0;
+}
+
+/*
+ * PolyBLAMP (the integrated PolyBLEP) in Q16 integer math; the correction for a
+ * triangle corner at phase zero where the slope turns by 65534 per half cycle
+ */
+int Oscillator::PolyBlamp(uint32_t ulT, uint32_t ulstep, uint32_t recip){
+    uint64_t x;
+    if (ulstep < BLEPMINSTEP)
+        return 0;
+    // |t| < 1: (1 - |t|)^3 / 6 (PolyBlep's integral), scaled by the slope change per sample
+    if (ulT < ulstep)
+        x = 65536 - StepFraction(ulT, ulstep, recip);
+    else if (ulT > 0 - ulstep)
+        x = 65536 - StepFraction(0 - ulT, ulstep, recip);
+    else
+        return 0;
+    return (int)((((x * x * x >> 32) * ulstep >> 16) * 10923) >> 30);
 }
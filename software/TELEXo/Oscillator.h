@@ -15,22 +15,68 @@
 
 #define MORPHRANGE 100
 
+// largest block rendered in one pass (Render splits longer requests)
+#define RENDERBLOCK 32
+
+// waveform families the block kernels are specialised for
+#define FAMILY_NONE 0     // no morph target
+#define FAMILY_PULSE 1    // primary square (pulse width)
+#define FAMILY_SQUARE 2   // morph target square (fixed width)
+#define FAMILY_SAW 3
+#define FAMILY_TRIANGLE 4
+#define FAMILY_TABLE 5
+#define FAMILY_NOISE 6
+#define FAMILY_SCAN 7     // wavetable scan (see SetScan)
+
 #define PHASEBITS 18
 #define TABLEBITS 9
 #define REDUCEBITS 23 // 32 - TABLEBITS
 #define PHASEMASK 8388607 // ( 1 << REDUCEBITS ) - 1
-// #define PHASESCALE = 1.1920928955078125e-7 // 1.0 / ( 1 << REDUCEBITS )
 
 #define FULLPHASE 4294967296.
 #define FULLPHASEL 4294967295
 #define HALFPHASE 2147483648
 
+// steps below this (about 0.4 Hz) are not band-limited
+#define BLEPMINSTEP 65536
+
+// steps below this (about 1.5 Hz) carry 32 fractional bits, as do slides
+// whose per-sample delta is below PRECISEDELTA (see StepPrecise)
+#define PRECISESTEP 262144
+#define PRECISEDELTA 4096
+
+// steps below this (about 6 Hz; 256 or more control points a cycle) can be
+// rendered at the control rate (see RenderControl)
+#define CONTROLSTEP 1048576
+
+// the scan position runs from the start of the scan range (0) to its end
+#define SCANRANGE 16384
+// no scan levels selected yet (see ReadScan)
+#define SCANNOTABLE 0xFFFFFFFF
+
+/*
+ * A band-limited level of a wavetable: level k keeps the harmonics below
+ * TABLERANGEDIV2 >> k in (TABLERANGE >> Shift) + 1 samples, so it is read at
+ * the phase shifted down by Shift more bits
+ */
+struct TableLevel {
+  const int16_t *Table;
+  uint8_t Level;
+  uint8_t Shift;
+};
+
 class Oscillator
 {
+  // renders table oscillators four at a time from the same state
+  friend class OscillatorBank;
+
   public:
   
     Oscillator();
-    float Oscillate();
+    int Oscillate();
+    void Render(int16_t *out, size_t n);
+    int RenderControl(size_t n);
+    bool ControlRate();
     
     void SetFrequency(int freq);
     void TargetFrequency(int freq);
@@ -47,7 +93,18 @@ class Oscillator
 
     void SetPortamentoMs(unsigned long milliseconds);
 
+    // wavetable scan: a position across a range of tables (SetWaveform leaves it)
+    void SetScan(int position);
+    void TargetScan(int position);
+    void SetScanFrom(int wave);
+    void SetScanTo(int wave);
+    void SetScanSlewMs(unsigned long milliseconds);
+
     float GetFrequency();
+
+    static int GetWaveformCount();
+    // wavetables read the band-limited level for their frequency unless this is turned off
+    static void SetBandLimit(bool bandLimit);
     
   protected:
 
@@ -55,54 +112,123 @@ class Oscillator
     void SetFreq(float freq);
     void TargetFreq(float freq);
 
-    double PolyBlepFixed(unsigned long ulT);
+    static uint64_t PreciseStep(float freq);
+    void PreciseSlide();
+    bool StepPrecise();
+
+    static uint32_t BlepReciprocal(uint32_t ulstep);
+    static uint32_t StepFraction(uint32_t distance, uint32_t ulstep, uint32_t recip);
+    static int PolyBlep(uint32_t ulT, uint32_t ulstep, uint32_t recip);
+    static int PolyBlamp(uint32_t ulT, uint32_t ulstep, uint32_t recip);
+
+    typedef void (Oscillator::*BlockKernel)(size_t n, size_t porta);
+    typedef void (Oscillator::*BlockRectifier)(int *value, size_t n);
+
+    void RenderBlock(int16_t *out, size_t n);
+    size_t AdvanceBlock(size_t n);
+
+    static uint8_t GetFamily(uint16_t wave, bool primary);
+    static TableLevel GetLevel(uint16_t wave, uint32_t ulstep);
+    static int ReadLevel(const TableLevel& level, uint32_t phase, uint32_t mask);
+    void SelectLevels();
+
+    uint64_t ScanPosition(int position);
+    void StartScan();
+    void StepScan();
+    int ReadScan(uint32_t phase, bool slide);
+    void RenderScan(int *value, size_t n, size_t porta);
+    void SelectScanLevels(uint32_t table, bool slide);
+    void SelectKernel();
+    void SelectRectifier();
+
+    template <uint8_t Wave, uint8_t Morph> void RenderKernel(size_t n, size_t porta);
+    template <uint8_t Family, bool Primary> void RenderFamily(int *value, size_t n, size_t porta);
+    template <uint8_t Morph> void RenderHeldNoise(size_t n, size_t porta);
+    template <int8_t Rect> void RectifyBlock(int *value, size_t n);
 
     const int peaks[2] = { 128, 256 };
   
   private:
 
   uint16_t _wave = 0;
-  uint8_t _morphWave = 1;
+  uint16_t _morphWave = 1;
   int _morph = 0;
   int _invMorph = MORPHRANGE;
   bool _morphing = false;
   int _morphValue = 0;
 
   float _frequency = 0;
-  unsigned long _ulstep = 0;
-  unsigned long _oldPhase = 0;
+  uint32_t _ulstep = 0;
+  uint32_t _oldPhase = 0;
   int _phaseOffset = 0;
-  unsigned long _actualPhase = 0;
+  uint32_t _actualPhase = 0;
   int _phaseDelta = 0;
   
   int _location;
-  float _remainder;
   
-  int _lastValue;
+  int _lastValue = 0;
   
   int _width = TABLERANGEDIV2;
   float _fWidth = .5;
-  unsigned long _ulWidth = FULLPHASEL >> 1;
+  uint32_t _ulWidth = FULLPHASEL >> 1;
 
   int8_t _rectify = 0;
   bool _doRect = false;
 
-  double _phasescale = 1.0 / ( 1 << REDUCEBITS );
-
   // portamento
-  unsigned long _targetUlstep = 0;
+  uint32_t _targetUlstep = 0;
   unsigned long _stepsCalculated = 0;
   unsigned long _steps = 0;
-  unsigned long _delta = 0;
+  uint32_t _delta = 0;
   bool _portamento = false;
   bool _sign = true;
 
+  // extended precision (slow LFOs and long slides): 32.32 step and phase
+  bool _precise = false;
+  uint32_t _stepFraction = 0;
+  uint32_t _phaseFraction = 0;
+  uint64_t _preciseTarget = 0;
+  uint64_t _preciseDelta = 0;
+
+  // band-limited levels: the slide's (for its higher end) until it lands, then the steady ones
+  static bool _bandLimit;
+  TableLevel _level;
+  TableLevel _morphLevel;
+  TableLevel _slideLevel;
+  TableLevel _slideMorphLevel;
+  uint32_t _levelStep = 0;
+  uint32_t _slideLevelStep = 0;
+
+  // wavetable scan: the position is Q32 in tables (the table below it in the
+  // top bits) and slides like the frequency; the range is in SetWaveform units
+  bool _scanning = false;
+  int _scanFrom = 0;
+  int _scanTo = 0;
+  int _scanValue = 0;
+  uint64_t _scanPosition = 0;
+  uint64_t _scanTarget = 0;
+  int64_t _scanDelta = 0;
+  unsigned long _scanSteps = 0;
+  unsigned long _scanStepsCalculated = 0;
+  // the levels of the two tables around the position (for the steady or the sliding step)
+  uint32_t _scanTable = SCANNOTABLE;
+  bool _scanSlide = false;
+  TableLevel _scanLevel;
+  TableLevel _scanNextLevel;
+
   // polyblep
-  double t = 0.0;
-  bool _blepItOne = false;
-  bool _blepItTwo = false;
-  int _blepOne = 0.0;
-  int _blepTwo = 0.0;
+  bool _blepIt = false;
+  uint32_t _blepRecip = 0;
+
+  // block rendering (kernels are swapped by SetWaveform and SetRectify)
+  BlockKernel _kernel;
+  BlockRectifier _rectifier;
+  uint32_t _blockPhase[RENDERBLOCK];
+  uint32_t _blockStep[RENDERBLOCK];
+  int _blockBlep[RENDERBLOCK];
+  int _blockEdge[RENDERBLOCK];
+  int _blockValue[RENDERBLOCK];
+  int _blockMorph[RENDERBLOCK];
 
 };
 
@@ -0,0 +1,208 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "defines.h"
+#include "Arduino.h"
+#include "OscillatorBank.h"
+#include "FixedPoint.h"
+
+#if defined(__SSE2__)
+
+#include "sse.h"
+
+/*
+ * The table interpolation of FixedPoint.h four lanes at once: pmaddwd
+ * multiplies each (a, b) pair by (-w, w) and adds the halves
+ */
+static inline v4si Lerp(v4si pairs, v4si frac) {
+  const v4si zero = _mm_setzero_si128();
+  v4si hi = _mm_srli_epi32(frac, LERPLOBITS);
+  v4si lo = _mm_and_si128(frac, v4sil(LERPLOMASK));
+  // (-w, w) in 16-bit halves (w is never more than 14 bits)
+  v4si p = _mm_madd_epi16(pairs, _mm_or_si128(_mm_sub_epi16(zero, hi), _mm_slli_epi32(hi, 16)));
+  v4si q = _mm_madd_epi16(pairs, _mm_or_si128(_mm_sub_epi16(zero, lo), _mm_slli_epi32(lo, 16)));
+  v4si x = _mm_add_epi32(p, _mm_srai_epi32(q, LERPLOBITS));
+  v4si down = _mm_add_epi32(_mm_srai_epi32(_mm_slli_epi32(pairs, 16), 16), _mm_srai_epi32(x, LERPHIBITS));
+  // negative values with a remainder round up (towards zero)
+  v4si rem = _mm_or_si128(_mm_and_si128(x, v4sil((1 << LERPHIBITS) - 1)), _mm_and_si128(q, v4sil(LERPLOMASK)));
+  v4si up = _mm_andnot_si128(_mm_cmpeq_epi32(rem, zero), _mm_cmplt_epi32(down, zero));
+  return _mm_sub_epi32(down, up);
+}
+
+#endif
+
+/*
+ * Constructor
+ */
+OscillatorBank::OscillatorBank() {
+}
+
+/*
+ * Whether an oscillator can join the lockstep pass: a wavetable (morphing into
+ * another wavetable or not, but not scanning) at a fixed, 32-bit step
+ */
+bool OscillatorBank::Lockstep(const Oscillator *osc) {
+  return !osc->_portamento && !osc->_precise && !osc->_scanning
+    && Oscillator::GetFamily(osc->_wave, true) == FAMILY_TABLE
+    && (!osc->_morphing || Oscillator::GetFamily(osc->_morphWave, false) == FAMILY_TABLE);
+}
+
+/*
+ * Renders n samples for each oscillator (NULL lanes are skipped); the same
+ * samples as calling Render on each of them
+ */
+void OscillatorBank::Render(Oscillator * const osc[BANKLANES], int16_t * const out[BANKLANES], size_t n) {
+
+  int16_t *lane[BANKLANES];
+  size_t l;
+  size_t count;
+  Oscillator *o;
+
+  _lanes = 0;
+  _morphing = false;
+
+  for (l = 0; l < BANKLANES; l++) {
+    o = osc[l];
+    if (!o) continue;
+    if (!Lockstep(o)) {
+      o->Render(out[l], n);
+      continue;
+    }
+    _osc[_lanes] = o;
+    lane[_lanes] = out[l];
+    _level[_lanes] = o->_level;
+    _morphLevel[_lanes] = o->_morphing ? o->_morphLevel : o->_level;
+  #ifdef BASIC
+    // the 3.2 skips interpolation while morphing or rectifying, and on every morph target
+    _mask[_lanes] = o->_morphing || o->_doRect ? 0 : PHASEMASK;
+    _morphMask[_lanes] = 0;
+  #else
+    _mask[_lanes] = PHASEMASK;
+    _morphMask[_lanes] = PHASEMASK;
+  #endif
+    _phase[_lanes] = o->_actualPhase;
+    _step[_lanes] = o->_ulstep;
+    _morphing = _morphing || o->_morphing;
+    _lanes++;
+  }
+
+  // too few tables to pay for the padded lanes
+  if (_lanes < BANKMINLANES) {
+    for (l = 0; l < _lanes; l++)
+      _osc[l]->Render(lane[l], n);
+    return;
+  }
+
+  // the unused lanes shadow the first one (their samples are dropped)
+  for (l = _lanes; l < BANKLANES; l++) {
+    _level[l] = _level[0];
+    _morphLevel[l] = _morphLevel[0];
+    _mask[l] = _mask[0];
+    _morphMask[l] = _morphMask[0];
+    _phase[l] = _phase[0];
+    _step[l] = _step[0];
+  }
+
+  while (n > 0) {
+    count = n < RENDERBLOCK ? n : RENDERBLOCK;
+    RenderBlock(lane, count);
+    for (l = 0; l < _lanes; l++)
+      lane[l] += count;
+    n -= count;
+  }
+}
+
+/*
+ * Renders up to RENDERBLOCK samples for the lockstep lanes
+ */
+void OscillatorBank::RenderBlock(int16_t * const out[BANKLANES], size_t n) {
+
+  size_t i;
+  size_t l;
+  int *value;
+  int *morph;
+  Oscillator *o;
+
+  // step the four phases together (the 32-bit accumulators wrap on their own)
+#if defined(__SSE2__)
+  v4si phase = _mm_loadu_si128((const v4si *)_phase);
+  v4si step = _mm_loadu_si128((const v4si *)_step);
+  for (i = 0; i < n; i++) {
+    phase = _mm_add_epi32(phase, step);
+    _mm_storeu_si128((v4si *)_blockPhase[i], phase);
+  }
+  _mm_storeu_si128((v4si *)_phase, phase);
+#else
+  for (i = 0; i < n; i++) {
+    for (l = 0; l < BANKLANES; l++) {
+      _phase[l] += _step[l];
+      _blockPhase[i][l] = _phase[l];
+    }
+  }
+#endif
+
+  Interpolate(_level, _mask, _value, n);
+  if (_morphing)
+    Interpolate(_morphLevel, _morphMask, _morph, n);
+
+  // the morph mix, rectifier and state are per oscillator (as in RenderKernel and RenderBlock)
+  for (l = 0; l < _lanes; l++) {
+    o = _osc[l];
+    value = _value[l];
+    if (o->_morphing) {
+      morph = _morph[l];
+      for (i = 0; i < n; i++)
+        value[i] = (value[i] * o->_invMorph + morph[i] * o->_morph) / MORPHRANGE;
+      o->_morphValue = morph[n - 1];
+    }
+    (o->*(o->_rectifier))(value, n);
+
+    o->_actualPhase = _phase[l];
+    o->_location = _phase[l] >> REDUCEBITS;
+    o->_lastValue = value[n - 1];
+
+    for (i = 0; i < n; i++)
+      out[l][i] = constrain(value[i], -32768, 32767);
+  }
+}
+
+/*
+ * Reads the levels at the block's phases, interpolating where the mask keeps the fraction
+ */
+void OscillatorBank::Interpolate(const TableLevel level[BANKLANES], const uint32_t mask[BANKLANES], int value[BANKLANES][RENDERBLOCK], size_t n) {
+
+  size_t i;
+  size_t l;
+  uint32_t phase;
+
+#if defined(__SSE2__)
+  // the table reads and the per-lane level shifts are scalar (SSE2 has no
+  // gather or per-lane shift); the arithmetic is not
+  uint32_t pair[BANKLANES];
+  uint32_t frac[BANKLANES];
+  int result[BANKLANES];
+  v4si masks = _mm_loadu_si128((const v4si *)mask);
+  for (i = 0; i < n; i++) {
+    for (l = 0; l < BANKLANES; l++) {
+      phase = _blockPhase[i][l] >> level[l].Shift;
+      pair[l] = TablePair(level[l].Table, phase >> REDUCEBITS);
+      frac[l] = phase;
+    }
+    v4si pairs = _mm_loadu_si128((const v4si *)pair);
+    v4si fracs = _mm_and_si128(_mm_loadu_si128((const v4si *)frac), masks);
+    _mm_storeu_si128((v4si *)result, Lerp(pairs, fracs));
+    for (l = 0; l < BANKLANES; l++)
+      value[l][i] = result[l];
+  }
+#else
+  for (i = 0; i < n; i++) {
+    for (l = 0; l < BANKLANES; l++) {
+      phase = _blockPhase[i][l] >> level[l].Shift;
+      value[l][i] = PairLerp(TablePair(level[l].Table, phase >> REDUCEBITS), phase & mask[l]);
+    }
+  }
+#endif
+}
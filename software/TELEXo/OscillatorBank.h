@@ -0,0 +1,62 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef OscillatorBank_h
+#define OscillatorBank_h
+
+#include "Arduino.h"
+#include "Oscillator.h"
+
+// oscillators rendered side by side (one per CV output)
+#define BANKLANES 4
+// fewer table oscillators than this are rendered one at a time
+#define BANKMINLANES 3
+
+/*
+ * Renders up to four oscillators in lockstep: the table oscillators share one
+ * pass that steps their phases and interpolates four lanes at a time (SSE2 on
+ * the host, the M4's dual 16-bit multiplies on the Teensy); the rest fall back
+ * to Oscillator::Render. The samples and the oscillator state afterwards are
+ * the same as rendering each one on its own.
+ */
+class OscillatorBank
+{
+  public:
+
+    OscillatorBank();
+    void Render(Oscillator * const osc[BANKLANES], int16_t * const out[BANKLANES], size_t n);
+
+    static bool Lockstep(const Oscillator *osc);
+
+  protected:
+
+    void RenderBlock(int16_t * const out[BANKLANES], size_t n);
+    void Interpolate(const TableLevel level[BANKLANES], const uint32_t mask[BANKLANES], int value[BANKLANES][RENDERBLOCK], size_t n);
+
+  private:
+
+    // the lanes in the lockstep pass (packed; unused lanes repeat the first)
+    Oscillator *_osc[BANKLANES];
+    uint8_t _lanes = 0;
+    bool _morphing = false;
+
+    // each lane's band-limited level (its table and how far its phase shifts down)
+    TableLevel _level[BANKLANES];
+    TableLevel _morphLevel[BANKLANES];
+    // PHASEMASK where a lane interpolates, zero where it reads the table as is
+    uint32_t _mask[BANKLANES];
+    uint32_t _morphMask[BANKLANES];
+
+    uint32_t _phase[BANKLANES];
+    uint32_t _step[BANKLANES];
+    uint32_t _blockPhase[RENDERBLOCK][BANKLANES];
+
+    int _value[BANKLANES][RENDERBLOCK];
+    int _morph[BANKLANES][RENDERBLOCK];
+
+};
+
+#endif
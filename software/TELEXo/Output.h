@@ -17,6 +17,7 @@ class Output
   
     Output(int output);
     Output(int output, int led);
+    virtual ~Output() {}
 
     // virtual functions
     virtual void Kill() = 0;   
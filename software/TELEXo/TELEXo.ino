@@ -16,12 +16,18 @@
 // DAC stuff
 #include <SPI.h>
 #include "DAC7565.h"
+#include "DacQueue.h"
+#include "DacDmaTransport.h"
 
 // support libraries
 #include "telex.h"
 #include "TriggerOutput.h"
+#include "TriggerQueue.h"
 #include "CVOutput.h"
+#include "OscillatorBank.h"
 #include "TxHelper.h"
+#include "TxQueue.h"
+#include "UserTables.h"
 
 /*
  * Ugly Globals
@@ -41,19 +47,33 @@ int p = 0;
 
 // CV Outputs
 DAC dac(-1, 10, -1, 11, 13);
+// frames leave through DMA while the ISR computes the next tick
+DacDmaTransport dacTransport;
+DacQueue dacQueue(&dacTransport);
 int dacOutputs[] = { DAC_CHANNEL_D, DAC_CHANNEL_C, DAC_CHANNEL_B, DAC_CHANNEL_A };
 int pwmLedPins[] = { 3, 4, 5, 6 };
 CVOutput *cvOutputs[4];
+// renders the four oscillators side by side
+OscillatorBank oscillatorBank;
 int writeRate = 100;
 
 // Trigger Outputs
 int trLedPins[] = { 0, 1, 2, 7 };
 int trPins[] = { 23, 22, 21, 20 };
 TriggerOutput *triggerOutputs[4];
+// pulse ends and metro beats, in time order on the sample clock
+TriggerQueue triggerQueue;
+// the tempo the TO.M commands share between the metros
+TempoClock tempoClock;
 
 // target output
 int targetOutput = 0;
 
+// commands parsed by the i2c callback, applied by the write ISR
+TxQueue commandQueue;
+// samples written since power-up (the clock commands are scheduled on)
+volatile uint32_t sampleClock = 0;
+
 // iterator values
 int i = 0;
 int q = 0;
@@ -96,7 +116,7 @@ void setup() {
   }
   configID += cfg;  
   
-  writeRate = 1000000 / SAMPLINGRATE;
+  writeRate = SAMPLEUS;
 
 #ifdef DEBUG
   delay(225);
@@ -117,12 +137,16 @@ void setup() {
     dac.init();
     dac.setReference(DAC_REFERENCE_ALWAYS_POWERED_UP);
     dac.writeChannel(DAC_CHANNEL_ALL, DAC_MAX_SCALE / 2);  
+    // the blocking writes are done - hand the frames to the DMA queue
+    dacTransport.Begin();
+    dac.setQueue(&dacQueue);
   }
   
   // initialize the outputs
   for (i=0; i < 4; i++) {
     // set up the trigger and cv outputs
     triggerOutputs[i] = new TriggerOutput(trPins[i], trLedPins[i]);
+    triggerOutputs[i]->ReferenceQueue(&triggerQueue);
     cvOutputs[i] = new CVOutput(dacOutputs[i], pwmLedPins[i], dac);
     cvOutputs[i]->ReferenceTriggers(triggerOutputs, sizeof(triggerOutputs));
   }
@@ -147,12 +171,6 @@ void loop() {
 
   currentTime = millis();
 
-  // update the TRIGGERS
-  for (i=0; i< 4; i++){
-    // update the triggers
-    triggerOutputs[i]->Update(currentTime);
-  } 
-
   // update the CV LEDs
   if (currentTime >= kTime){
     for (i = 0; i < 4; i++)
@@ -190,6 +208,17 @@ void writeOutputs() {
   n++;
 #endif
   
+  // end the pulses and beat the metros due on this sample
+  triggerQueue.Tick();
+
+  // apply the commands due on this sample (so they land between samples)
+  TxResponse command;
+  for (int c = 0; commandQueue.Pop(command, sampleClock, c); c++)
+    actOnCommand(command.Command, command.Output, command.Value);
+
+  // render the next slice of the oscillator buffers (every OSCSLICE ticks)
+  CVOutput::RenderOscillators(cvOutputs, oscillatorBank);
+
   // iterate through the values  
   for (p=0; p< 4; p++){
   
@@ -197,6 +226,11 @@ void writeOutputs() {
     cvOutputs[p]->Update();
 
   } 
+
+  // send the changed channels and latch them together
+  dac.writeFrame();
+
+  sampleClock++;
 }
 
 
@@ -213,11 +247,47 @@ void receiveEvent(size_t len) {
   ledInterval = millis() + LEDINTERVAL;
 #endif
 
-  // parse the response
-  TxResponse response = TxHelper::Parse(len);
+  // parse the response (and any samples after it)
+  TxPayload payload;
+  TxResponse response = TxHelper::Parse(len, &payload);
+
+  // a frame: its commands in the order they were sent (published together,
+  // so they land on the same tick), queued whole or not at all
+  if (response.Command == TO_FRAME) {
+    int count = (len - 1) / 4;
+    if (!commandQueue.Reserve(count))
+      return;
+    while (TxHelper::ParseNext(response))
+      receiveCommand(response, NULL, count--);
+    commandQueue.Publish();
+    return;
+  }
 
-  // act on the command
-  actOnCommand(response.Command, response.Output, response.Value);
+  receiveCommand(response, &payload, 1);
+  
+}
+
+/*
+ * Takes a command from the bus, `run` being the commands from it to the end
+ * of its frame (the samples of a wavetable upload are not carried in a frame)
+ */
+void receiveCommand(TxResponse& response, TxPayload *payload, int run) {
+
+  // wavetable uploads go straight into the table's back buffer
+  if (response.Command == TO_OSC_TABLE) {
+    if (payload)
+      UserTables::Write(response.Output, response.Value, payload->Samples, payload->Length);
+    return;
+  }
+
+  // the swap holds the back buffer until the write ISR has copied it
+  if (response.Command == TO_OSC_TABLE_SWAP && !UserTables::Close(response.Output))
+    return;
+
+  // schedule the command and queue it for the write ISR
+  commandQueue.Stamp(response, sampleClock);
+  if (!commandQueue.Push(response, run) && response.Command == TO_OSC_TABLE_SWAP)
+    UserTables::Reopen(response.Output);
   
 }
 
@@ -236,7 +306,8 @@ void actOnCommand(byte cmd, byte out, int value){
   Serial.printf("Action: %d, Output: %d, Value: %d\n", cmd, targetOutput, value);
 #endif
 
-  unsigned long ms = millis();
+  // the metros started or synced together share this tick's time
+  uint64_t now = triggerQueue.Now();
   
   switch(cmd) {
     
@@ -424,6 +495,46 @@ void actOnCommand(byte cmd, byte out, int value){
       cvOutputs[targetOutput]->SetCenter(value << 1);
       break;
 
+    case TO_OSC_SCAN:
+      //
+      cvOutputs[targetOutput]->TargetScan(value);
+      break;
+
+    case TO_OSC_SCAN_SET:
+      //
+      cvOutputs[targetOutput]->SetScan(value);
+      break;
+
+    case TO_OSC_SCAN_SLEW:
+      //
+      cvOutputs[targetOutput]->SetScanSlew(value, 0);
+      break;
+
+    case TO_OSC_SCAN_SLEW_S:
+      //
+      cvOutputs[targetOutput]->SetScanSlew(value, 1);
+      break;
+
+    case TO_OSC_SCAN_SLEW_M:
+      //
+      cvOutputs[targetOutput]->SetScanSlew(value, 2);
+      break;
+
+    case TO_OSC_SCAN_FROM:
+      //
+      cvOutputs[targetOutput]->SetScanFrom(value);
+      break;
+
+    case TO_OSC_SCAN_TO:
+      //
+      cvOutputs[targetOutput]->SetScanTo(value);
+      break;
+
+    case TO_OSC_TABLE_SWAP:
+      // the output is the user table
+      UserTables::Swap(targetOutput);
+      break;
+
     case TO_ENV_ACT:
       // 
       cvOutputs[targetOutput]->SetEnvelopeMode(value);
@@ -526,7 +637,7 @@ void actOnCommand(byte cmd, byte out, int value){
 
     case TO_TR_M_ACT:
       // Set Clock Divider
-      triggerOutputs[targetOutput]->SetMetro(value, ms);
+      triggerOutputs[targetOutput]->SetMetro(value, now);
       break;
 
     case TO_TR_M:
@@ -549,6 +660,11 @@ void actOnCommand(byte cmd, byte out, int value){
       triggerOutputs[targetOutput]->SetMetroTime(value, 3);    
       break;
               
+    case TO_TR_M_BPM_F:
+       // Set Pulse Time for TR Metro (hundredths of a BPM)
+      triggerOutputs[targetOutput]->SetMetroTime((uint16_t)value, 4);
+      break;
+
     case TO_TR_M_SYNC:
        // Sync Pulse Time for TR Metro
       triggerOutputs[targetOutput]->Sync();    
@@ -557,31 +673,42 @@ void actOnCommand(byte cmd, byte out, int value){
     case TO_M_ACT:
       // Set Clock Divider
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->SetMetro(value, ms);
+        triggerOutputs[w]->SetMetro(value, now);
       break;
 
     case TO_M:
-       // Set Pulse Time for TR Metro
+       // Set the Shared Tempo for All TR Metros
+      tempoClock.SetTime(value, 0);
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->SetMetroTime(value, 0);    
+        triggerOutputs[w]->SetTempo(&tempoClock);
       break;
       
     case TO_M_S:
-       // Set Pulse Time for TR Metro
+       // Set the Shared Tempo for All TR Metros
+      tempoClock.SetTime(value, 1);
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->SetMetroTime(value, 1);    
+        triggerOutputs[w]->SetTempo(&tempoClock);
       break;
       
     case TO_M_M:
-       // Set Pulse Time for TR Metro
+       // Set the Shared Tempo for All TR Metros
+      tempoClock.SetTime(value, 2);
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->SetMetroTime(value, 2);    
+        triggerOutputs[w]->SetTempo(&tempoClock);
       break;
         
     case TO_M_BPM:
-       // Set Pulse Time for TR Metro
+       // Set the Shared Tempo for All TR Metros
+      tempoClock.SetTime(value, 3);
+      for (int w = 0; w < 4; w++)
+        triggerOutputs[w]->SetTempo(&tempoClock);
+      break;
+
+    case TO_M_BPM_F:
+       // Set the Shared Tempo for All TR Metros (hundredths of a BPM)
+      tempoClock.SetTime((uint16_t)value, 4);
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->SetMetroTime(value, 3);    
+        triggerOutputs[w]->SetTempo(&tempoClock);
       break;
 
     case TO_M_COUNT:
@@ -593,7 +720,7 @@ void actOnCommand(byte cmd, byte out, int value){
     case TO_M_SYNC:
        // Sync Pulse Time for TR Metro
       for (int w = 0; w < 4; w++)
-        triggerOutputs[w]->Sync(ms);
+        triggerOutputs[w]->Sync(now);
       break;
         
     case TO_TR_WIDTH:
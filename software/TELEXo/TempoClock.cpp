@@ -0,0 +1,58 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "TempoClock.h"
+#include "TxHelper.h"
+
+/*
+ * Sets the beat in the ConvertMs formats (ms, sec, min, bpm) or in
+ * hundredths of a BPM (format 4)
+ */
+void TempoClock::SetTime(unsigned long value, short format){
+
+  switch(format){
+
+    // bpm
+    case 3:
+      _numerator = 60000000ULL;
+      _denominator = value;
+      break;
+
+    // hundredths of a bpm
+    case 4:
+      _numerator = 6000000000ULL;
+      _denominator = value;
+      break;
+
+    default:
+      _numerator = TxHelper::ConvertUs(value, format);
+      _denominator = 1;
+
+  }
+
+  // a tempo of zero beats on every tick (as an interval of zero did)
+  if (_denominator == 0) {
+    _numerator = 0;
+    _denominator = 1;
+  }
+
+}
+
+uint64_t TempoClock::Numerator(){
+  return _numerator;
+}
+
+uint32_t TempoClock::Denominator(){
+  return _denominator;
+}
+
+/*
+ * The beat in whole microseconds
+ */
+uint64_t TempoClock::Interval(){
+  return _numerator / _denominator;
+}
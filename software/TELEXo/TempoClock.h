@@ -0,0 +1,40 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef TempoClock_h
+#define TempoClock_h
+
+#include "Arduino.h"
+
+/*
+ * A metro tempo held as an exact fraction: a beat lasts Numerator /
+ * Denominator microseconds (60000000 / BPM, or 6000000000 / hundredths of
+ * a BPM), so no part of a microsecond is lost
+ *
+ * Each trigger output keeps its own tempo (TO.TR.M) or follows the one the
+ * TO.M commands set; the outputs step their beats from it with a phase
+ * accumulator (see TriggerOutput::Advance), so outputs on the same tempo
+ * and synced together land every shared beat on the same microsecond
+ */
+class TempoClock
+{
+  public:
+
+    void SetTime(unsigned long value, short format);
+
+    uint64_t Numerator();
+    uint32_t Denominator();
+    uint64_t Interval();
+
+  private:
+
+    // one second, as TriggerOutput used to start
+    uint64_t _numerator = 1000000;
+    uint32_t _denominator = 1;
+
+};
+
+#endif
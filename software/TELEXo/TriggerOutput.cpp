@@ -18,6 +18,33 @@ TriggerOutput::TriggerOutput(int output, int led) : Output(output, led) {
   pinMode(_led, OUTPUT);
 }
 
+/*
+ * Runs the output's pulses and metro from a trigger queue (the write ISR's clock)
+ * instead of polling Update()
+ */
+void TriggerOutput::ReferenceQueue(TriggerQueue *queue){
+  _queue = queue;
+  Schedule();
+}
+
+/*
+ * The current time in microseconds
+ */
+uint64_t TriggerOutput::Now(){
+  return _queue ? _queue->Now() : (uint64_t)micros();
+}
+
+/*
+ * Places the output in its queue at its next event: the end of the pulse or
+ * the next metro beat, whichever is first
+ */
+void TriggerOutput::Schedule(){
+  if (!_queue) return;
+  uint64_t due = _toggle;
+  if (_metro && _nextEvent < due) due = _nextEvent;
+  _queue->Schedule(this, due);
+}
+
 /*
  * Set the State of the Trigger Output and Write it To the Output Pins
  */
@@ -32,7 +59,7 @@ void TriggerOutput::SetState(bool state){
  */
 void TriggerOutput::SetTime(int value, short format){
   _widthMode = false;
-  _pulseTime = TxHelper::ConvertMs(value, format);
+  _pulseTime = TxHelper::ConvertUs(value, format);
 }
 
 /*
@@ -41,15 +68,16 @@ void TriggerOutput::SetTime(int value, short format){
 void TriggerOutput::SetWidth(int value){
   _widthMode = true;
   _width = constrain(value, 0, 100);
-  _pulseTime = _metroInterval * _width / 100.;
+  _pulseTime = _tempo->Interval() * _width / 100;
 }
 
 /*
  * Toggle the State of the Trigger Output
  */
 void TriggerOutput::ToggleState(){
-  _toggle = MAXTIME;
+  _toggle = NEVERUS;
   SetState(!_state);
+  Schedule();
 }
 
 /*
@@ -70,7 +98,8 @@ void TriggerOutput::Pulse() {
   
   if (_state != _polarity)
     SetState(_polarity);
-  _toggle = millis() + _pulseTime;
+  _toggle = Now() + _pulseTime;
+  Schedule();
 }
 
 /*
@@ -94,43 +123,55 @@ void TriggerOutput::SetDivision(int division){
  */
 void TriggerOutput::SetMultiplier(int multiplier){
    _tempMultiplication = max(multiplier, 1);
-   _tempMultiplyInterval = _metroInterval / _tempMultiplication;
-   _multiply = _tempMultiplication > 1;
-   // if turning off multiply during metro - schedule the next beat
-   if (!_multiply && _metro) _nextEvent = _nextNormal;
+   _retune = true;
+   // if turning off multiply during metro - skip to the next reference beat
+   if (_tempMultiplication == 1 && _metro) {
+     while (_multiplyCount != 0) {
+       Advance();
+       if (++_multiplyCount >= _multiplication) _multiplyCount = 0;
+     }
+   }
+   Schedule();
 }
 
 /*
  * Activates or Deactivates the Metro for this Trigger at this Moment
  */
 void TriggerOutput::SetMetro(int state) {
-  SetMetro(state, millis());
+  SetMetro(state, Now());
 }
 
 
 /**
  * Activates or Deactivates the Metro for this Trigger
  */
-void TriggerOutput::SetMetro(int state, unsigned long ms){
+void TriggerOutput::SetMetro(int state, uint64_t syncTime){
   bool m = state != 0;
   if (m){  
     _actualCount = _metroCount;
-    if (!_metro) {
-      Sync(ms);
-      _multiplyInterval = _tempMultiplyInterval;
-      _multiplication = _tempMultiplication;
-      _multiplyCount = 0;
-    }
+    if (!_metro)
+      Sync(syncTime);
   }
   _metro = m;
+  Schedule();
 }
 
 /**
- * Sets the time for the metro pulse (in ms, sec, min, and bpm)
+ * Sets the time for the metro pulse (in ms, sec, min, bpm and hundredths of a bpm)
+ * on the output's own tempo
  */
 void TriggerOutput::SetMetroTime(int value, short format){
-  _metroInterval = TxHelper::ConvertMs(value, format);
-  _tempMultiplyInterval = _metroInterval / _multiplication;
+  _ownTempo.SetTime(value, format);
+  SetTempo(&_ownTempo);
+}
+
+/**
+ * Follows a tempo (its own or the one shared by the TO.M commands)
+ * from the next reference beat
+ */
+void TriggerOutput::SetTempo(TempoClock *tempo){
+  _tempo = tempo;
+  _retune = true;
   if (_widthMode) SetWidth(_width);
 }
 
@@ -153,16 +194,46 @@ void TriggerOutput::SetMute(bool state){
  * Syncs the metro pulse to now
  */
 void TriggerOutput::Sync(){
-  Sync(millis());
+  Sync(Now());
 }
 
 /**
  * Syncs the metro pulse to a specified time
  */
-void TriggerOutput::Sync(unsigned long syncTime){
+void TriggerOutput::Sync(uint64_t syncTime){
   _nextEvent = syncTime;
-  _nextNormal = syncTime;
+  _multiplyCount = 0;
   _counter = 0;
+  Retune();
+  Schedule();
+}
+
+/*
+ * Takes up the tempo and multiplier from the current beat: each step is
+ * the tempo's fraction divided by the multiplier, whole microseconds plus
+ * a remainder for the accumulator
+ */
+void TriggerOutput::Retune(){
+  _multiplication = _tempMultiplication;
+  _stepDenominator = (uint64_t)_tempo->Denominator() * _multiplication;
+  _step = _tempo->Numerator() / _stepDenominator;
+  _stepRemainder = _tempo->Numerator() % _stepDenominator;
+  _phase = 0;
+  _retune = false;
+}
+
+/*
+ * Moves the metro on a step, carrying the fractions of a microsecond
+ * (beat n of a tempo lands on floor(n * Numerator / Denominator) however
+ * long it runs)
+ */
+void FASTRUN TriggerOutput::Advance(){
+  _nextEvent += _step;
+  _phase += _stepRemainder;
+  if (_phase >= _stepDenominator) {
+    _phase -= _stepDenominator;
+    _nextEvent++;
+  }
 }
 
 
@@ -186,72 +257,45 @@ void TriggerOutput::Reset(){
  * Stop All Pulses
  */
 void TriggerOutput::Kill(){
-  _toggle = MAXTIME;
+  _toggle = NEVERUS;
   _metro = false;
+  Schedule();
 }
 
 /*
- * Update Function (Call This a Lot)
+ * Update Function (the trigger queue calls it when an event is due;
+ * without a queue, call this a lot)
  */
-void FASTRUN TriggerOutput::Update(unsigned long currentTime){
-
-  /*
-   * _multiplication = number of dongises
-   * _multiply = bool ON or OFF
-   * _multiplyInterval
-    unsigned long _nextNormal = 0;
-    int _multiplyCount = 0;
-   */
+void FASTRUN TriggerOutput::Update(uint64_t currentTime){
 
   // turn off the pulse
   if (currentTime >= _toggle) {
     if (_state == _polarity)
       SetState(!_polarity);
-    _toggle = MAXTIME;
+    _toggle = NEVERUS;
   }
 
   // evaluate pinging the metro event
   if (_metro && currentTime >= _nextEvent){
 
-    if (_multiply){
-
-      if (_multiplyCount == 0){
-        if (_metroCount == 0 || (_metroCount > 0 && --_actualCount > 0)){
-          // set the next reference beat (avoids divisionn drift)
-          _nextNormal = _nextNormal + _metroInterval;
-          // copy over any new values
-          _multiplyInterval = _tempMultiplyInterval;
-          _multiplication = _tempMultiplication;
-          // reset multiplication counter
-          _multiplyCount = 0;
-        } else {
-          // we have beat for the expected count - disable the metro
-          _metro = false;
-        }
-      }
-      
-      if (++_multiplyCount < _multiplication) {
-        // set the next event to the multiply interval
-        _nextEvent = _nextEvent + _multiplyInterval;
-      } else {
-        // set the next event to the metro interval (normal) and reset count
-        _nextEvent = _nextNormal;
-        _multiplyCount = 0;
-      }
-      
-    } else {
-
-      // we are just doing basic metronomes
+    // a reference beat counts down the repeats and takes up a new tempo or multiplier
+    if (_multiplyCount == 0){
       if (_metroCount == 0 || (_metroCount > 0 && --_actualCount > 0)){
-        _nextEvent = _nextNormal + _metroInterval;
-        _nextNormal = _nextEvent;
-      } else
+        if (_retune) Retune();
+      } else {
+        // we have beat for the expected count - disable the metro
         _metro = false;
-      
+      }
     }
-      
+
+    Advance();
+    if (++_multiplyCount >= _multiplication)
+      _multiplyCount = 0;
+
     Pulse();
   }
+
+  Schedule();
   
 }
 
@@ -9,6 +9,8 @@
 
 #include "Arduino.h"
 #include "Output.h"
+#include "TempoClock.h"
+#include "TriggerQueue.h"
 
 #define MAXTIME 4294967295
 
@@ -18,8 +20,10 @@ class TriggerOutput : public Output
   
     TriggerOutput(int output);
     TriggerOutput(int output, int led);
-    
-    void Update(unsigned long currentTime);
+
+    // times are in microseconds on the queue's clock (or micros() without one)
+    void ReferenceQueue(TriggerQueue *queue);
+    void Update(uint64_t currentTime);
     
     void SetState(bool state);
     void ToggleState();
@@ -32,13 +36,14 @@ class TriggerOutput : public Output
     void SetMultiplier(int multiplier);
 
     void SetMetro(int state);
-    void SetMetro(int state, unsigned long syncTime);
+    void SetMetro(int state, uint64_t syncTime);
     void SetMetroTime(int value, short format);
+    void SetTempo(TempoClock *tempo);
     void SetMetroCount(int value);
 
     void SetMute(bool state);
     
-    void Sync(unsigned long syncTime);
+    void Sync(uint64_t syncTime);
     void Sync();
     void Reset();
 
@@ -46,28 +51,41 @@ class TriggerOutput : public Output
     void Kill();
     
   protected:
+
+    uint64_t Now();
+    void Schedule();
+    void Retune();
+    void Advance();
     
   private:
+
+    TriggerQueue *_queue = NULL;
     
     bool _state = false;
     bool _polarity = true;
-    unsigned long _toggle = MAXTIME;
+    uint64_t _toggle = NEVERUS;
 
     bool _divide = false;
     unsigned short _division = 0;
     unsigned short _counter = 0;
 
-    bool _multiply = false;
     unsigned short _multiplication = 1;
     unsigned short _tempMultiplication = 1;
-    unsigned long _multiplyInterval = 1000;
-    unsigned long _tempMultiplyInterval = 1000;
-    unsigned long _nextNormal = 0;
     int _multiplyCount = 0;
 
     bool _metro = false;
-    unsigned long _metroInterval = 1000;
-    unsigned long _nextEvent = 0;
+    TempoClock _ownTempo;
+    TempoClock *_tempo = &_ownTempo;
+    // a new tempo or multiplier waits for the next reference beat
+    bool _retune = false;
+
+    // the next beat (or multiplied beat) in whole microseconds, and the
+    // part of one left over in 1/_stepDenominator (the phase accumulator)
+    uint64_t _nextEvent = 0;
+    uint64_t _phase = 0;
+    uint64_t _step = 1000000;
+    uint64_t _stepRemainder = 0;
+    uint64_t _stepDenominator = 1;
 
     int _metroCount = 0;
     int _actualCount = -1;
@@ -76,7 +94,7 @@ class TriggerOutput : public Output
     int _width = 0;
     
     // 100ms is the teletype's default value for the pulse time
-    unsigned long _pulseTime = 100;    
+    uint64_t _pulseTime = 100000;
 
     bool _mutePulse = false;
 };
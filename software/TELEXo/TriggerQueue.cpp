@@ -0,0 +1,90 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "TriggerQueue.h"
+#include "TriggerOutput.h"
+
+/*
+ * Moves the clock on a sample and updates the outputs that are due
+ * They are taken off the queue first, so each is updated once a tick
+ * (a metro with no interval beats every tick instead of stalling it)
+ */
+void FASTRUN TriggerQueue::Tick(){
+
+  _now += SAMPLEUS;
+
+  if (_count == 0 || _due[0] > _now)
+    return;
+
+  TriggerOutput *due[TRIGGERQUEUESIZE];
+  int n = 0;
+  int i;
+
+  while (n < _count && _due[n] <= _now)
+    n++;
+  for (i = 0; i < n; i++)
+    due[i] = _triggers[i];
+  for (i = n; i < _count; i++) {
+    _triggers[i - n] = _triggers[i];
+    _due[i - n] = _due[i];
+  }
+  _count -= n;
+
+  for (i = 0; i < n; i++)
+    due[i]->Update(_now);
+
+  _fired += n;
+
+}
+
+/*
+ * Places an output at the time of its next event (NEVERUS takes it off)
+ */
+void TriggerQueue::Schedule(TriggerOutput *trigger, uint64_t due){
+
+  Remove(trigger);
+
+  if (due == NEVERUS || _count == TRIGGERQUEUESIZE)
+    return;
+
+  // behind everything due at the same time
+  int i = _count;
+  while (i > 0 && _due[i - 1] > due) {
+    _triggers[i] = _triggers[i - 1];
+    _due[i] = _due[i - 1];
+    i--;
+  }
+  _triggers[i] = trigger;
+  _due[i] = due;
+  _count++;
+
+}
+
+void TriggerQueue::Remove(TriggerOutput *trigger){
+  for (int i = 0; i < _count; i++) {
+    if (_triggers[i] != trigger) continue;
+    for (_count--; i < _count; i++) {
+      _triggers[i] = _triggers[i + 1];
+      _due[i] = _due[i + 1];
+    }
+    return;
+  }
+}
+
+/*
+ * The time of the current tick in microseconds
+ */
+uint64_t TriggerQueue::Now(){
+  return _now;
+}
+
+/*
+ * Outputs updated so far
+ */
+unsigned long TriggerQueue::Fired(){
+  return _fired;
+}
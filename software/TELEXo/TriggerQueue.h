@@ -0,0 +1,52 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef TriggerQueue_h
+#define TriggerQueue_h
+
+#include "Arduino.h"
+#include "defines.h"
+
+class TriggerOutput;
+
+// trigger outputs the queue holds (one entry each)
+#define TRIGGERQUEUESIZE 8
+
+// no event scheduled
+#define NEVERUS 0xFFFFFFFFFFFFFFFFULL
+
+/*
+ * Time-ordered queue of the trigger outputs waiting on an event (the end of
+ * a pulse or the next metro beat), run by the write ISR on the sample clock
+ * Only the head is compared on a tick with nothing due; an output takes its
+ * place again whenever its times change (see TriggerOutput::Schedule)
+ */
+class TriggerQueue
+{
+  public:
+
+    void Tick();
+    void Schedule(TriggerOutput *trigger, uint64_t due);
+
+    uint64_t Now();
+    unsigned long Fired();
+
+  private:
+
+    void Remove(TriggerOutput *trigger);
+
+    TriggerOutput *_triggers[TRIGGERQUEUESIZE];
+    uint64_t _due[TRIGGERQUEUESIZE];
+    int _count = 0;
+
+    // microseconds at the current tick (a whole number of them per sample)
+    uint64_t _now = 0;
+
+    unsigned long _fired = 0;
+
+};
+
+#endif
@@ -6,12 +6,13 @@
  
 #include "TxHelper.h"
 #include "fastexp.h"
+#include "telex.h"
 #include "Arduino.h"
 
 // i2c
 #include <i2c_t3.h>
 
-TxResponse TxHelper::Parse(size_t len){
+TxResponse TxHelper::Parse(size_t, TxPayload *payload){
 
   TxResponse response;
 
@@ -21,14 +22,24 @@ TxResponse TxHelper::Parse(size_t len){
   int counterPal = 0;
   memset(buffer, 0, sizeof(buffer));
 
-  // read the data
-  while (1 < Wire.available()) {
-    if (counterPal < 4) {
-      buffer[counterPal++] = Wire.read();
-    }
+  // read the header (a frame's marker stands alone; ParseNext reads its commands)
+  while (counterPal < 4 && Wire.available()) {
+    buffer[counterPal++] = Wire.read();
+    if (buffer[0] == TO_FRAME) break;
+  }
+
+  // anything after it is read as big-endian samples (or dropped)
+  if (payload) payload->Length = 0;
+  while (buffer[0] != TO_FRAME && 1 < Wire.available()) {
+    int high = Wire.read();
+    int low = Wire.read();
+    if (payload && payload->Length < TXPAYLOADSIZE)
+      payload->Samples[payload->Length++] = (int16_t)((high << 8) + low);
+  }
+  // an odd byte left over is not a sample
+  while (buffer[0] != TO_FRAME && Wire.available()) {
+    Wire.read();
   }
-  // get the last byte
-  buffer[counterPal] = Wire.read();
 
   uint16_t temp = (uint16_t)((buffer[2] << 8) + (buffer[3]));
   int16_t temp2 = (int16_t)temp;
@@ -36,11 +47,36 @@ TxResponse TxHelper::Parse(size_t len){
   response.Command = buffer[0];
   response.Output = buffer[1];
   response.Value = (int)temp2;
+  response.Sample = 0;
 
   return response;
   
 }
 
+/*
+ * Reads the next command of a frame, in the order it was sent: each takes
+ * the same four bytes as a write of its own (command, output, value)
+ * Returns false at the end of the frame; a partial command there is dropped
+ */
+bool TxHelper::ParseNext(TxResponse& response){
+
+  if (Wire.available() < 4) {
+    while (Wire.available())
+      Wire.read();
+    return false;
+  }
+
+  response.Command = Wire.read();
+  response.Output = Wire.read();
+  int high = Wire.read();
+  int low = Wire.read();
+  response.Value = (int)(int16_t)((high << 8) + low);
+  response.Sample = 0;
+
+  return true;
+
+}
+
 TxIO TxHelper::DecodeIO(int io) {
   
   TxIO decoded;
@@ -86,3 +122,28 @@ unsigned long TxHelper::ConvertMs(unsigned long ms, short format){
   
 }
 
+/*
+ * Converts a time in the same formats as ConvertMs to microseconds
+ * (so a tempo keeps the fraction of a millisecond its beat lasts)
+ */
+uint64_t TxHelper::ConvertUs(unsigned long value, short format){
+
+  switch(format){
+
+    // seconds
+    case 1:
+      return value * 1000000ULL;
+
+    // minutes
+    case 2:
+      return value * 60000000ULL;
+
+    // bpm
+    case 3:
+      return value ? 60000000ULL / value : 0;
+
+  }
+
+  return value * 1000ULL;
+
+}
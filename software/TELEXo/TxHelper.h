@@ -16,6 +16,16 @@ struct TxResponse {
   byte Command;
   byte Output;
   int Value;
+  // sample clock tick the command takes effect on
+  uint32_t Sample;
+};
+
+// 16-bit samples carried after the four-byte header (a wavetable upload)
+#define TXPAYLOADSIZE 64
+
+struct TxPayload {
+  int16_t Samples[TXPAYLOADSIZE];
+  size_t Length;
 };
 
 struct TxIO {
@@ -27,10 +37,12 @@ class TxHelper
 {
   public:
 
-    static TxResponse Parse(size_t len);
+    static TxResponse Parse(size_t len, TxPayload *payload = NULL);
+    static bool ParseNext(TxResponse& response);
     static TxIO DecodeIO(int io);
     static float VOct2Frequency(int value);
     static unsigned long ConvertMs(unsigned long ms, short format);
+    static uint64_t ConvertUs(unsigned long value, short format);
 
   protected:
     
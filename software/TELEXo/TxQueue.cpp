@@ -0,0 +1,122 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "Arduino.h"
+#include "TxQueue.h"
+
+/*
+ * Assign the sample a command takes effect on (producer side): the one the
+ * next tick renders, so a command goes out as soon as it can; a frame's
+ * commands are published together (see Publish), so they land on one tick
+ */
+void TxQueue::Stamp(TxResponse& response, uint32_t now){
+  response.Sample = now;
+}
+
+/*
+ * Make sure a frame of `count` commands fits before pushing it (producer side)
+ * Returns false and counts them all as dropped if it doesn't, or if it is
+ * longer than a tick applies; otherwise holds its commands back until
+ * Publish, so the write ISR takes it whole or not at all
+ */
+bool TxQueue::Reserve(int count){
+
+  if (count > TXQUEUEDRAIN || count > TXQUEUESIZE - (int)(_write - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE))){
+    _dropped += count;
+    return false;
+  }
+
+  _framing = true;
+  return true;
+
+}
+
+/*
+ * Add a command (producer side), `run` being the commands from it to the end
+ * of its frame
+ * Returns false and drops it if the consumer has fallen a whole ring behind
+ */
+bool TxQueue::Push(const TxResponse& response, uint8_t run){
+
+  uint32_t write = _write;
+
+  if (write - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == TXQUEUESIZE){
+    _dropped++;
+    return false;
+  }
+
+  _items[write & TXQUEUEMASK] = response;
+  _runs[write & TXQUEUEMASK] = run;
+  _write = write + 1;
+
+  // publish the item after it is written (a frame's once it is complete)
+  if (!_framing)
+    __atomic_store_n(&_head, _write, __ATOMIC_RELEASE);
+
+  return true;
+
+}
+
+/*
+ * Hand the frame's commands to the write ISR together (producer side)
+ */
+void TxQueue::Publish(){
+  _framing = false;
+  __atomic_store_n(&_head, _write, __ATOMIC_RELEASE);
+}
+
+/*
+ * Take the oldest command (consumer side)
+ */
+bool FASTRUN TxQueue::Pop(TxResponse& response){
+
+  uint32_t tail = _tail;
+
+  if (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail)
+    return false;
+
+  response = _items[tail & TXQUEUEMASK];
+
+  // hand the slot back after it is read
+  __atomic_store_n(&_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return true;
+
+}
+
+/*
+ * Take the oldest command if it is due on sample `now` (consumer side),
+ * `applied` being the commands already taken this tick: no more than
+ * TXQUEUEDRAIN, and a frame only if all of it fits under them
+ * The stamps never go backwards, so nothing behind it is due either
+ */
+bool FASTRUN TxQueue::Pop(TxResponse& response, uint32_t now, int applied){
+
+  uint32_t tail = _tail;
+
+  if (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail)
+    return false;
+
+  uint32_t sample = _items[tail & TXQUEUEMASK].Sample;
+  if ((int32_t)(sample - now) > 0)
+    return false;
+  if (applied + _runs[tail & TXQUEUEMASK] > TXQUEUEDRAIN)
+    return false;
+
+  response = _items[tail & TXQUEUEMASK];
+
+  __atomic_store_n(&_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return true;
+
+}
+
+/*
+ * Commands lost to a full ring
+ */
+unsigned long TxQueue::Dropped(){
+  return _dropped;
+}
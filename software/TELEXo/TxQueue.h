@@ -0,0 +1,57 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef TxQueue_h
+#define TxQueue_h
+
+#include "Arduino.h"
+#include "TxHelper.h"
+
+// commands held between ticks (a power of two)
+#define TXQUEUESIZE 64
+#define TXQUEUEMASK (TXQUEUESIZE - 1)
+
+// commands applied per tick at most (keeps an i2c burst from stretching one tick);
+// a frame carries no more than this, so it is never split across ticks
+#define TXQUEUEDRAIN 8
+
+/*
+ * Lock-free single-producer/single-consumer ring of parsed commands
+ * The i2c receive callback stamps and pushes, the write ISR pops
+ * each command on the sample it is stamped with
+ */
+class TxQueue
+{
+  public:
+
+    void Stamp(TxResponse& response, uint32_t now);
+    bool Reserve(int count);
+    bool Push(const TxResponse& response, uint8_t run = 1);
+    void Publish();
+    bool Pop(TxResponse& response);
+    bool Pop(TxResponse& response, uint32_t now, int applied);
+
+    unsigned long Dropped();
+
+  private:
+
+    TxResponse _items[TXQUEUESIZE];
+    // the commands from each one to the end of its frame (1 outside a frame)
+    uint8_t _runs[TXQUEUESIZE];
+
+    // free-running counts - each side only writes its own
+    uint32_t _head = 0;
+    uint32_t _tail = 0;
+
+    unsigned long _dropped = 0;
+
+    // written but held back until the frame is complete (producer side)
+    uint32_t _write = 0;
+    bool _framing = false;
+
+};
+
+#endif
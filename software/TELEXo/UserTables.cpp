@@ -0,0 +1,85 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include <string.h>
+
+#include "Arduino.h"
+#include "UserTables.h"
+
+int16_t UserTables::_front[USERTABLES][TABLESIZE];
+int16_t UserTables::_back[USERTABLES][TABLESIZE];
+volatile bool UserTables::_pending[USERTABLES];
+unsigned long UserTables::_refused = 0;
+
+/*
+ * Writes samples into a table's back buffer from an offset (receive side)
+ * Refuses writes past the end of the table or to a table waiting for its swap
+ */
+bool UserTables::Write(int table, int offset, const int16_t *samples, size_t n){
+
+  if (table < 0 || table >= USERTABLES || _pending[table] || offset < 0 || offset + n > TABLERANGE){
+    _refused++;
+    return false;
+  }
+
+  memcpy(&_back[table][offset], samples, n * sizeof(int16_t));
+
+  return true;
+
+}
+
+/*
+ * Closes a table's back buffer for its swap (receive side)
+ * The extra sample at the end repeats the first, for the interpolation
+ */
+bool UserTables::Close(int table){
+
+  if (table < 0 || table >= USERTABLES || _pending[table]){
+    _refused++;
+    return false;
+  }
+
+  _back[table][TABLERANGE] = _back[table][0];
+  _pending[table] = true;
+
+  return true;
+
+}
+
+/*
+ * Opens a closed table again when its swap could not be queued (receive side)
+ */
+void UserTables::Reopen(int table){
+  if (table >= 0 && table < USERTABLES)
+    _pending[table] = false;
+}
+
+/*
+ * Copies a closed table in front of the oscillators (write side)
+ */
+void FASTRUN UserTables::Swap(int table){
+
+  if (table < 0 || table >= USERTABLES || !_pending[table])
+    return;
+
+  memcpy(_front[table], _back[table], sizeof(_front[table]));
+  _pending[table] = false;
+
+}
+
+/*
+ * The table the oscillators read
+ */
+const int16_t *UserTables::Table(int table){
+  return _front[table];
+}
+
+/*
+ * Writes and swaps refused so far
+ */
+unsigned long UserTables::Refused(){
+  return _refused;
+}
@@ -0,0 +1,58 @@
+/*
+ * TELEXo Eurorack Module
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef UserTables_h
+#define UserTables_h
+
+#include "Arduino.h"
+#include "defines.h"
+#include "Oscillator.h"
+
+// wavetables that can be uploaded over i2c (each takes two 513-sample buffers)
+#ifdef TURBO
+#define USERTABLES 8
+#else
+#define USERTABLES 2
+#endif
+
+/*
+ * A bank of wavetables in RAM, uploaded over i2c and selected with a
+ * negative waveform (-100 is the first, see Oscillator::SetWaveform)
+ *
+ * Uploads are written into a back buffer by the i2c receive callback; the
+ * swap closes it and is queued like any other command, and the write ISR
+ * copies it to the front buffer the oscillators read between two renders.
+ * The back buffer keeps what was uploaded, so part of a table can be sent
+ * again on its own. A table is not written again until its swap is done.
+ */
+class UserTables
+{
+  public:
+
+    // receive side (the i2c callback)
+    static bool Write(int table, int offset, const int16_t *samples, size_t n);
+    static bool Close(int table);
+    static void Reopen(int table);
+
+    // write side (the ISR)
+    static void Swap(int table);
+    static const int16_t *Table(int table);
+
+    static unsigned long Refused();
+
+  private:
+
+    static int16_t _front[USERTABLES][TABLESIZE];
+    static int16_t _back[USERTABLES][TABLESIZE];
+
+    // closed and waiting for its swap
+    static volatile bool _pending[USERTABLES];
+
+    static unsigned long _refused;
+
+};
+
+#endif
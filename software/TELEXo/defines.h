@@ -38,6 +38,9 @@
 #define KRATE 15.625
 #endif
 
+// one sample in microseconds (a whole number in both builds)
+#define SAMPLEUS (1000000 / SAMPLINGRATE)
+
 #define LEDRATE 50
 
 #endif
@@ -119,6 +119,23 @@
 #define TO_CV_CALIB 0x6E
 #define TO_CV_RESET 0x6F
 
+#define TO_OSC_SCAN 0x70
+#define TO_OSC_SCAN_SET 0x71
+#define TO_OSC_SCAN_SLEW 0x72
+#define TO_OSC_SCAN_SLEW_S 0x73
+#define TO_OSC_SCAN_SLEW_M 0x74
+#define TO_OSC_SCAN_FROM 0x75
+#define TO_OSC_SCAN_TO 0x76
+
+#define TO_OSC_TABLE 0x77
+#define TO_OSC_TABLE_SWAP 0x78
+
+#define TO_TR_M_BPM_F 0x79
+#define TO_M_BPM_F 0x7A
+
+// a frame of four-byte commands sent in one write (see TxHelper::ParseNext)
+#define TO_FRAME 0x7B
+
 // TELEXi
 
 #define TI 0x68
@@ -140,6 +157,7 @@
 #define TI_IN_TOP 0x04
 #define TI_IN_BOT 0x05
 #define TI_IN_MAP 0x06
+#define TI_IN_DELTA 0x07
 
 #define TI_PARAM 0x10
 #define TI_PARAM_QT 0x11
@@ -148,10 +166,25 @@
 #define TI_PARAM_TOP 0x14
 #define TI_PARAM_BOT 0x15
 #define TI_PARAM_MAP 0x16
+#define TI_PARAM_DELTA 0x17
+
+// one-byte selects for a bulk read of all eight inputs (16 bytes):
+// normal, quantized and note number values
+#define TI_BULK 0x18
+#define TI_BULK_QT 0x19
+#define TI_BULK_N 0x1A
+// one-byte selects for a delta read: a byte with a bit for each input that
+// changed since the last delta read, then a read of just their values
+#define TI_DELTA 0x1B
+#define TI_DELTA_QT 0x1C
+#define TI_DELTA_N 0x1D
 
 #define TI_IN_CALIB 0x20
 #define TI_PARAM_CALIB 0x21
 #define TI_STORE 0x22
 #define TI_RESET 0x23
 
+#define TI_IN_MAP_PT 0x24
+#define TI_PARAM_MAP_PT 0x25
+
 #endif
@@ -0,0 +1,72 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include <math.h>
+
+#include "AdcSim.h"
+
+AdcSim::AdcSim(double conversionUs, Signal signal, int noise) {
+  _conversionUs = conversionUs;
+  _signal = signal;
+  _noise = noise;
+  _random = 1;
+  for (int adc = 0; adc < ADCCOUNT; adc++) {
+    _count[adc] = 0;
+    _ring[adc] = NULL;
+    _length[adc] = 0;
+    _next[adc] = 0;
+  }
+}
+
+void AdcSim::Start(uint8_t adc, const uint8_t *channels, uint8_t count, volatile uint16_t *ring, uint16_t length) {
+  for (uint8_t i = 0; i < count; i++)
+    _channels[adc][i] = channels[i];
+  _count[adc] = count;
+  _ring[adc] = ring;
+  _length[adc] = length;
+  _samples[adc].clear();
+  _clean[adc].clear();
+  // the first result is ready a conversion after the start
+  _next[adc] = _conversionUs;
+}
+
+uint32_t AdcSim::Written(uint8_t adc) {
+  return (uint32_t)_samples[adc].size();
+}
+
+/*
+ * runs each ADC's conversions up to a time
+ */
+void AdcSim::Advance(double us) {
+  for (uint8_t adc = 0; adc < ADCCOUNT; adc++) {
+    if (!_count[adc]) continue;
+    while (_next[adc] <= us) {
+      size_t n = _samples[adc].size();
+      double clean = _signal(adc, _channels[adc][n % _count[adc]], _next[adc]);
+      _random = _random * 1664525 + 1013904223;
+      int noise = _noise ? (int)((_random >> 8) % (2 * _noise + 1)) - _noise : 0;
+      long value = lround(clean) + noise;
+      if (value < 0) value = 0;
+      if (value > 65535) value = 65535;
+      _ring[adc][n % _length[adc]] = (uint16_t)value;
+      _samples[adc].push_back((uint16_t)value);
+      _clean[adc].push_back(clean);
+      _next[adc] += _conversionUs;
+    }
+  }
+}
+
+uint8_t AdcSim::Channels(uint8_t adc) {
+  return _count[adc];
+}
+
+const std::vector<uint16_t>& AdcSim::Samples(uint8_t adc) {
+  return _samples[adc];
+}
+
+const std::vector<double>& AdcSim::Clean(uint8_t adc) {
+  return _clean[adc];
+}
@@ -0,0 +1,57 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef AdcSim_h
+#define AdcSim_h
+
+#include <vector>
+
+#include "AdcScanner.h"
+
+/*
+ * the two DMA-fed ADCs in simulated time: each sweeps its channels, one
+ * conversion every conversionUs, writing 16-bit results into its ring;
+ * the values come from a signal (plus uniform noise) and every sample
+ * written is logged, noisy and clean, for checking
+ */
+class AdcSim : public AdcSource
+{
+  public:
+
+    // the clean value of a channel at a time (16-bit ADC units)
+    typedef double (*Signal)(uint8_t adc, uint8_t channel, double us);
+
+    AdcSim(double conversionUs, Signal signal, int noise);
+
+    void Start(uint8_t adc, const uint8_t *channels, uint8_t count, volatile uint16_t *ring, uint16_t length);
+    uint32_t Written(uint8_t adc);
+
+    // moves simulated time forward to us
+    void Advance(double us);
+
+    uint8_t Channels(uint8_t adc);
+    const std::vector<uint16_t>& Samples(uint8_t adc);
+    const std::vector<double>& Clean(uint8_t adc);
+
+  private:
+
+    double _conversionUs;
+    Signal _signal;
+    int _noise;
+    uint32_t _random;
+
+    uint8_t _channels[ADCCOUNT][ADCINPUTS];
+    uint8_t _count[ADCCOUNT];
+    volatile uint16_t *_ring[ADCCOUNT];
+    uint16_t _length[ADCCOUNT];
+    double _next[ADCCOUNT];
+
+    std::vector<uint16_t> _samples[ADCCOUNT];
+    std::vector<double> _clean[ADCCOUNT];
+
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * cost of four oscillators per sample: four Oscillator::Oscillate() calls,
+ * four Oscillator::Render() calls and one OscillatorBank::Render(), in
+ * OSCSLICE blocks as CVOutput refills them; checks that all three produce
+ * the same samples; results are written as JSON
+ *
+ * usage: telexo_bank_bench [--samples N] [--out FILE]
+ *   --samples  samples rendered per scenario and path (default: four seconds)
+ *   --out      write the JSON to FILE instead of stdout
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "Oscillator.h"
+#include "OscillatorBank.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+#define PATH_SCALAR 0
+#define PATH_RENDER 1
+#define PATH_BANK 2
+#define PATHCOUNT 3
+
+static const char *pathNames[] = { "scalar", "render", "bank" };
+
+struct Lane {
+  int Wave;
+  int Frequency;
+  int Rectify;
+  bool Portamento;
+};
+
+struct Scenario {
+  const char *Name;
+  Lane Lanes[BANKLANES];
+};
+
+static const Scenario scenarios[] = {
+  { "sines", { { 0, 110, 0, false }, { 0, 220, 0, false }, { 0, 440, 0, false }, { 0, 880, 0, false } } },
+  { "tables", { { 4 * MORPHRANGE, 110, 0, false }, { 40 * MORPHRANGE, 220, 0, false }, { 90 * MORPHRANGE, 330, 0, false }, { 120 * MORPHRANGE, 440, 0, false } } },
+  { "tables+morph", { { 4 * MORPHRANGE + 25, 110, 0, false }, { 40 * MORPHRANGE + 50, 220, 0, false }, { 90 * MORPHRANGE + 75, 330, 0, false }, { 120 * MORPHRANGE + 10, 440, 0, false } } },
+  { "tables/rect", { { 4 * MORPHRANGE, 110, -2, false }, { 40 * MORPHRANGE, 220, -1, false }, { 90 * MORPHRANGE, 330, 1, false }, { 120 * MORPHRANGE, 440, 2, false } } },
+  { "tables+lfo", { { 0, 1, 0, false }, { 4 * MORPHRANGE, 3, 0, false }, { 40 * MORPHRANGE + 50, 2000, 0, false }, { 90 * MORPHRANGE, 9000, 0, false } } },
+  { "mixed", { { 0, 110, 0, false }, { 2 * MORPHRANGE, 220, 0, false }, { 40 * MORPHRANGE, 330, 0, false }, { 3 * MORPHRANGE, 440, 0, false } } },
+  { "tables/porta", { { 0, 110, 0, true }, { 4 * MORPHRANGE, 220, 0, false }, { 40 * MORPHRANGE, 330, 0, false }, { 90 * MORPHRANGE, 440, 0, false } } },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static void Apply(Oscillator& osc, const Lane& lane) {
+  osc.SetWaveform(lane.Wave);
+  osc.SetRectify(lane.Rectify);
+  if (lane.Portamento) osc.SetPortamentoMs(50);
+  osc.SetFrequency(lane.Frequency);
+  if (lane.Portamento) osc.TargetFrequency(lane.Frequency * 4);
+  osc.ResetPhase(0);
+}
+
+static double Elapsed(BenchClock::time_point start) {
+  return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+/*
+ * renders every lane with one path; returns ns per sample (all four lanes)
+ */
+static double Run(int path, const Scenario& s, std::vector<int16_t> out[BANKLANES]) {
+
+  Oscillator lanes[BANKLANES];
+  Oscillator *osc[BANKLANES];
+  int16_t *block[BANKLANES];
+  OscillatorBank bank;
+  size_t samples = out[0].size();
+  size_t i, count;
+  int l, value;
+
+  for (l = 0; l < BANKLANES; l++) {
+    Apply(lanes[l], s.Lanes[l]);
+    osc[l] = &lanes[l];
+  }
+
+  BenchClock::time_point start = BenchClock::now();
+  if (path == PATH_SCALAR) {
+    for (i = 0; i < samples; i++) {
+      for (l = 0; l < BANKLANES; l++) {
+        value = lanes[l].Oscillate();
+        out[l][i] = constrain(value, -32768, 32767);
+      }
+    }
+  } else {
+    for (i = 0; i < samples; i += count) {
+      count = samples - i < OSCSLICE ? samples - i : OSCSLICE;
+      for (l = 0; l < BANKLANES; l++)
+        block[l] = &out[l][i];
+      if (path == PATH_BANK) {
+        bank.Render(osc, block, count);
+      } else {
+        for (l = 0; l < BANKLANES; l++)
+          lanes[l].Render(block[l], count);
+      }
+    }
+  }
+  return Elapsed(start) / samples;
+}
+
+int main(int argc, char *argv[]) {
+
+  size_t samples = SAMPLINGRATE * 4;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--samples") && a + 1 < argc)
+      samples = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--samples N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (samples == 0) samples = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  std::vector<int16_t> reference[BANKLANES];
+  std::vector<int16_t> rendered[BANKLANES];
+  for (int l = 0; l < BANKLANES; l++) {
+    reference[l].resize(samples);
+    rendered[l].resize(samples);
+  }
+  bool identical = true;
+  double total[PATHCOUNT] = { 0 };
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("samples", (long)samples);
+  json.Field("block", (long)OSCSLICE);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    double ns[PATHCOUNT];
+
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.BeginArray("paths");
+
+    for (int path = PATH_SCALAR; path < PATHCOUNT; path++) {
+      ns[path] = Run(path, scenarios[s], path == PATH_SCALAR ? reference : rendered);
+      total[path] += ns[path];
+
+      size_t mismatches = 0;
+      if (path != PATH_SCALAR)
+        for (int l = 0; l < BANKLANES; l++)
+          for (size_t k = 0; k < samples; k++)
+            if (reference[l][k] != rendered[l][k]) mismatches++;
+      if (mismatches) identical = false;
+
+      json.BeginObject();
+      json.Field("path", pathNames[path]);
+      json.Field("ns_per_sample", ns[path]);
+      json.Field("speedup", ns[path] > 0 ? ns[PATH_SCALAR] / ns[path] : 0.);
+      json.Field("mismatches", (long)mismatches);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.Field("bank_over_render", ns[PATH_BANK] > 0 ? ns[PATH_RENDER] / ns[PATH_BANK] : 0.);
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.BeginObject("summary");
+  json.Field("scenarios", (long)SCENARIOCOUNT);
+  for (int path = PATH_SCALAR; path < PATHCOUNT; path++) {
+    char name[48];
+    snprintf(name, sizeof(name), "%s_ns_per_sample", pathNames[path]);
+    json.Field(name, total[path] / SCENARIOCOUNT);
+  }
+  json.Field("bank_over_scalar", total[PATH_BANK] > 0 ? total[PATH_SCALAR] / total[PATH_BANK] : 0.);
+  json.Field("bank_over_render", total[PATH_BANK] > 0 ? total[PATH_RENDER] / total[PATH_BANK] : 0.);
+  json.Field("identical", identical);
+  json.EndObject();
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include <algorithm>
+#include <chrono>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+int dacOutputs[] = { DAC_CHANNEL_D, DAC_CHANNEL_C, DAC_CHANNEL_B, DAC_CHANNEL_A };
+static int pwmLedPins[] = { 3, 4, 5, 6 };
+static int trLedPins[] = { 0, 1, 2, 7 };
+int trPins[] = { 23, 22, 21, 20 };
+
+/*
+ * builds the outputs and measures the cost of reading the clock
+ */
+BenchRig::BenchRig() : _dac(-1, 10, -1, 11, 13) {
+
+  _dac.init();
+  HostHal::RecordDac(false);
+
+  for (int i = 0; i < 4; i++) {
+    tr[i] = new TriggerOutput(trPins[i], trLedPins[i]);
+    tr[i]->ReferenceQueue(&triggers);
+    cv[i] = new CVOutput(dacOutputs[i], pwmLedPins[i], _dac);
+    cv[i]->ReferenceTriggers(tr, 4);
+  }
+
+  // the median cost of an empty timed region is subtracted from every sample
+  std::vector<double> empty(10001);
+  for (size_t i = 0; i < empty.size(); i++) {
+    BenchClock::time_point start = BenchClock::now();
+    BenchClock::time_point end = BenchClock::now();
+    empty[i] = std::chrono::duration<double, std::nano>(end - start).count();
+  }
+  std::nth_element(empty.begin(), empty.begin() + empty.size() / 2, empty.end());
+  _overhead = empty[empty.size() / 2];
+}
+
+/*
+ * same loop as writeOutputs() in TELEXo.ino
+ */
+void BenchRig::Tick() {
+  triggers.Tick();
+  CVOutput::RenderOscillators(cv, _bank);
+  for (int p = 0; p < 4; p++)
+    cv[p]->Update();
+  _dac.writeFrame();
+}
+
+/*
+ * the DAC shared by the four outputs
+ */
+DAC& BenchRig::Dac() {
+  return _dac;
+}
+
+/*
+ * restores every output to its power-on state
+ */
+void BenchRig::Reset() {
+  for (int i = 0; i < 4; i++) {
+    tr[i]->Reset();
+    cv[i]->Reset();
+  }
+  // let any pending set/slew settle so scenarios start from rest
+  for (int i = 0; i < 4; i++)
+    Tick();
+}
+
+/*
+ * runs and times the ISR; the callback is excluded from the timing
+ */
+BenchStats BenchRig::Run(unsigned long ticks, void (*between)(BenchRig& rig, unsigned long tick)) {
+
+  _samples.resize(ticks);
+  for (int p = 0; p < OSCBUFFER; p++)
+    _phase[p].clear();
+  double total = 0;
+
+  for (unsigned long t = 0; t < ticks; t++) {
+    if (between) between(*this, t);
+    BenchClock::time_point start = BenchClock::now();
+    Tick();
+    BenchClock::time_point end = BenchClock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() - _overhead;
+    _samples[t] = ns > 0 ? ns : 0;
+    total += _samples[t];
+    _phase[t % OSCBUFFER].push_back(_samples[t]);
+  }
+
+  BenchStats stats;
+  stats.Ticks = ticks;
+  stats.MeanNs = ticks ? total / ticks : 0;
+  stats.WorstNs = ticks ? *std::max_element(_samples.begin(), _samples.end()) : 0;
+  size_t p99 = ticks ? (size_t)(ticks * 0.99) : 0;
+  if (ticks) std::nth_element(_samples.begin(), _samples.begin() + p99, _samples.end());
+  stats.P99Ns = ticks ? _samples[p99] : 0;
+  stats.PeakNs = 0;
+  for (int p = 0; p < OSCBUFFER; p++) {
+    std::vector<double>& phase = _phase[p];
+    if (phase.empty()) continue;
+    std::nth_element(phase.begin(), phase.begin() + phase.size() / 2, phase.end());
+    if (phase[phase.size() / 2] > stats.PeakNs) stats.PeakNs = phase[phase.size() / 2];
+  }
+  stats.Headroom = 1. - stats.PeakNs / SAMPLEPERIODNS;
+  return stats;
+}
@@ -0,0 +1,57 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef BenchRig_h
+#define BenchRig_h
+
+#include <stdio.h>
+#include <vector>
+
+#include "defines.h"
+#include "DAC7565.h"
+#include "CVOutput.h"
+#include "OscillatorBank.h"
+#include "TriggerOutput.h"
+#include "TriggerQueue.h"
+#include "JsonWriter.h"
+
+#define SAMPLEPERIODNS (1000000000. / SAMPLINGRATE)
+
+// the DAC channel and trigger pin of each output (wired as in TELEXo.ino)
+extern int dacOutputs[4];
+extern int trPins[4];
+
+/*
+ * the TELEXo output section wired up the way TELEXo.ino does it
+ */
+class BenchRig
+{
+  public:
+
+    BenchRig();
+
+    // one pass of the writeOutputs() ISR
+    void Tick();
+    // times `ticks` ISR passes (callback runs untimed before each tick)
+    BenchStats Run(unsigned long ticks, void (*between)(BenchRig& rig, unsigned long tick) = NULL);
+    void Reset();
+    DAC& Dac();
+
+    CVOutput *cv[4];
+    TriggerOutput *tr[4];
+    TriggerQueue triggers;
+
+  private:
+
+    DAC _dac;
+    OscillatorBank _bank;
+    std::vector<double> _samples;
+    std::vector<double> _phase[OSCBUFFER];
+    double _overhead;
+
+};
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * aliasing and per-sample cost of the oscillator's integer polyBLEP/polyBLAMP
+ * against the double-precision polyBLEP it replaced and the naive waveforms;
+ * results are written as JSON
+ *
+ * usage: telexo_blep_bench [--calls N] [--out FILE]
+ *   --calls  polyBLEP evaluations timed per frequency (default: 2000000)
+ *   --out    write the JSON to FILE instead of stdout
+ *
+ * exits with an error if the integer version aliases more than 1 dB worse
+ * than the double-precision reference for any waveform, or if either
+ * band-limited version aliases no less than the naive waveform
+ */
+
+#include <chrono>
+#include <complex>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "Oscillator.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+// spectrum length (a power of two) and the bins around each harmonic counted as signal
+#define FFTSIZE 16384
+#define HARMONICBINS 6
+
+// allowed aliasing difference against the double-precision reference
+#define MAXDELTADB 1.
+
+#define SHAPE_SAW 0
+#define SHAPE_PULSE 1
+#define SHAPE_TRIANGLE 2
+
+static const float frequencies[] = { 1234.5, 3001.7, 5511.3 };
+#define FREQUENCYCOUNT (sizeof(frequencies) / sizeof(frequencies[0]))
+
+struct Shape {
+  const char *Name;
+  int Type;
+  int Wave;
+  int Width;
+};
+
+static const Shape shapes[] = {
+  { "saw", SHAPE_SAW, 2 * MORPHRANGE, 50 },
+  { "square", SHAPE_PULSE, 3 * MORPHRANGE, 50 },
+  { "pulse/25", SHAPE_PULSE, 3 * MORPHRANGE, 25 },
+  { "triangle", SHAPE_TRIANGLE, 1 * MORPHRANGE, 50 },
+};
+#define SHAPECOUNT (sizeof(shapes) / sizeof(shapes[0]))
+
+/*
+ * exposes the protected integer kernels
+ */
+class BlepProbe : public Oscillator
+{
+  public:
+    using Oscillator::BlepReciprocal;
+    using Oscillator::PolyBlep;
+    using Oscillator::PolyBlamp;
+};
+
+/*
+ * the double-precision polyBLEP the oscillator used before (same scale and sign)
+ */
+static double PolyBlepDouble(uint32_t ulT, uint32_t ulstep) {
+  double t;
+  if (ulT < ulstep) {
+    t = (double)ulT / ulstep;
+    return (t+t - t*t - 1.0) * 32767;
+  } else if (ulT > FULLPHASE - ulstep) {
+    t = ((double)ulT - FULLPHASE) / ulstep;
+    return (t*t + t+t + 1.0) * 32767;
+  }
+  return 0.0;
+}
+
+/*
+ * the double-precision polyBLAMP for a triangle corner (same scale as PolyBlamp)
+ */
+static double PolyBlampDouble(uint32_t ulT, uint32_t ulstep) {
+  double t;
+  if (ulT < ulstep)
+    t = 1. - (double)ulT / ulstep;
+  else if (ulT > FULLPHASE - ulstep)
+    t = 1. - (FULLPHASE - ulT) / ulstep;
+  else
+    return 0.0;
+  return t * t * t / 6. * ulstep * 65534. / 1073741824.;
+}
+
+/*
+ * the waveform from the oscillator's phase accumulator, optionally band-limited in doubles
+ */
+static void Generate(const Shape& shape, uint32_t ulstep, bool bandLimit, std::vector<double>& out) {
+  uint32_t phase = 0;
+  uint32_t width = (uint32_t)((shape.Width / 100.) * (FULLPHASE - 1));
+  for (size_t i = 0; i < out.size(); i++) {
+    phase += ulstep;
+    double value;
+    if (shape.Type == SHAPE_SAW) {
+      value = (int)(phase >> 16) - 32767;
+      if (bandLimit) value -= PolyBlepDouble(phase, ulstep);
+    } else if (shape.Type == SHAPE_PULSE) {
+      value = phase < width ? 32767 : -32767;
+      if (bandLimit) value += PolyBlepDouble(phase, ulstep) - PolyBlepDouble(phase - width, ulstep);
+    } else {
+      value = phase & 0x80000000 ? (int)((FULLPHASEL - phase) >> 15) - 32767 : (int)(phase >> 15) - 32767;
+      if (bandLimit) value += PolyBlampDouble(phase, ulstep) - PolyBlampDouble(phase - (uint32_t)HALFPHASE, ulstep);
+    }
+    out[i] = value;
+  }
+}
+
+/*
+ * the oscillator's own output through the block renderer
+ */
+static void Render(const Shape& shape, float frequency, std::vector<double>& out) {
+  Oscillator osc;
+  std::vector<int16_t> samples(out.size());
+  osc.SetWaveform(shape.Wave);
+  osc.SetWidth(shape.Width);
+  osc.SetFloatFrequency(frequency);
+  osc.ResetPhase(0);
+  osc.Render(&samples[0], samples.size());
+  for (size_t i = 0; i < out.size(); i++)
+    out[i] = samples[i];
+}
+
+/*
+ * in-place radix-2 FFT
+ */
+static void Fft(std::vector<std::complex<double> >& x) {
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<double> w(cos(-2 * M_PI / len), sin(-2 * M_PI / len));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> wn(1);
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> u = x[i + k];
+        std::complex<double> v = x[i + k + len / 2] * wn;
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+        wn *= w;
+      }
+    }
+  }
+}
+
+/*
+ * power outside the harmonics below Nyquist relative to the power on them (dB)
+ */
+static double Aliasing(const std::vector<double>& signal, float frequency) {
+
+  std::vector<std::complex<double> > x(FFTSIZE);
+  for (size_t i = 0; i < FFTSIZE; i++) {
+    // 4-term Blackman-Harris
+    double a = 2 * M_PI * i / (FFTSIZE - 1);
+    double w = 0.35875 - 0.48829 * cos(a) + 0.14128 * cos(2 * a) - 0.01168 * cos(3 * a);
+    x[i] = signal[signal.size() - FFTSIZE + i] * w;
+  }
+  Fft(x);
+
+  std::vector<bool> harmonic(FFTSIZE / 2, false);
+  double binHz = (double)SAMPLINGRATE / FFTSIZE;
+  for (double f = frequency; f < SAMPLINGRATE / 2.; f += frequency) {
+    long center = lround(f / binHz);
+    for (long b = center - HARMONICBINS; b <= center + HARMONICBINS; b++)
+      if (b >= 0 && b < FFTSIZE / 2) harmonic[b] = true;
+  }
+
+  double on = 0, off = 0;
+  // skip DC and its window leakage
+  for (size_t b = HARMONICBINS; b < FFTSIZE / 2; b++) {
+    double p = std::norm(x[b]);
+    if (harmonic[b]) on += p; else off += p;
+  }
+  return 10 * log10(off / on);
+}
+
+static double Elapsed(BenchClock::time_point start) {
+  return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long calls = 2000000;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--calls") && a + 1 < argc)
+      calls = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--calls N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  std::vector<double> naive(FFTSIZE * 2);
+  std::vector<double> reference(FFTSIZE * 2);
+  std::vector<double> fixed(FFTSIZE * 2);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("fft_size", (long)FFTSIZE);
+  json.BeginArray("aliasing");
+
+  for (size_t s = 0; s < SHAPECOUNT; s++) {
+    for (size_t f = 0; f < FREQUENCYCOUNT; f++) {
+      uint32_t ulstep = (int)((frequencies[f] / SAMPLINGRATE) * FULLPHASE);
+      Generate(shapes[s], ulstep, false, naive);
+      Generate(shapes[s], ulstep, true, reference);
+      Render(shapes[s], frequencies[f], fixed);
+
+      double naiveDb = Aliasing(naive, frequencies[f]);
+      double referenceDb = Aliasing(reference, frequencies[f]);
+      double fixedDb = Aliasing(fixed, frequencies[f]);
+      if (fixedDb > referenceDb + MAXDELTADB) pass = false;
+      if (referenceDb >= naiveDb || fixedDb >= naiveDb) pass = false;
+
+      json.BeginObject();
+      json.Field("waveform", shapes[s].Name);
+      json.Field("frequency", (double)frequencies[f]);
+      json.Field("naive_db", naiveDb);
+      json.Field("double_db", referenceDb);
+      json.Field("fixed_db", fixedDb);
+      json.EndObject();
+    }
+  }
+
+  json.EndArray();
+  json.BeginArray("cost");
+
+  // one evaluation per sample, like the kernels
+  volatile double doubleSink = 0;
+  volatile int fixedSink = 0;
+  for (size_t f = 0; f < FREQUENCYCOUNT; f++) {
+    uint32_t ulstep = (int)((frequencies[f] / SAMPLINGRATE) * FULLPHASE);
+    uint32_t recip = BlepProbe::BlepReciprocal(ulstep);
+    uint32_t phase = 0;
+    double acc = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (unsigned long i = 0; i < calls; i++) {
+      phase += ulstep;
+      acc += PolyBlepDouble(phase, ulstep);
+    }
+    double doubleNs = Elapsed(start) / calls;
+    doubleSink = acc;
+
+    int sum = 0;
+    phase = 0;
+    start = BenchClock::now();
+    for (unsigned long i = 0; i < calls; i++) {
+      phase += ulstep;
+      sum += BlepProbe::PolyBlep(phase, ulstep, recip);
+    }
+    double fixedNs = Elapsed(start) / calls;
+    fixedSink = sum;
+
+    sum = 0;
+    phase = 0;
+    start = BenchClock::now();
+    for (unsigned long i = 0; i < calls; i++) {
+      phase += ulstep;
+      sum += BlepProbe::PolyBlep(phase, ulstep, 0);
+    }
+    double dividedNs = Elapsed(start) / calls;
+    fixedSink = sum;
+
+    json.BeginObject();
+    json.Field("frequency", (double)frequencies[f]);
+    json.Field("double_ns_per_sample", doubleNs);
+    json.Field("fixed_ns_per_sample", fixedNs);
+    json.Field("fixed_sliding_ns_per_sample", dividedNs);
+    json.EndObject();
+  }
+  (void)doubleSink;
+  (void)fixedSink;
+
+  json.EndArray();
+  json.Field("max_delta_db", MAXDELTADB);
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
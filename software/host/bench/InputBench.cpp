@@ -0,0 +1,516 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * runs synthetic input streams (knobs at rest and turned, CV sines and
+ * steps, calibrated and mapped) through the TXi's input conditioning at
+ * the read timer's 1 kHz, two ways:
+ *   legacy - the chain AnalogReader used to run: ResponsiveAnalogRead's
+ *            float smoothing on 13 bits, then constrain, map, shift,
+ *            calibration and mapping with their divisions
+ *   fixed  - AnalogReader's integer pipeline on the scanner's 16 bits
+ * reports the time each takes per value on this machine, how far their
+ * outputs are apart, how often their outputs change and how much a still
+ * input's output wanders, and how many updates a step takes to settle
+ * then runs each response curve (TI_IN_MAP / TI_PARAM_MAP) on a knob and on
+ * calibrated, mapped CV, reporting its time per value against no curve and
+ * how far its table lands from the curve worked out exactly
+ * results are written as JSON
+ *
+ * usage: telexi_input_bench [--seconds N] [--out FILE]
+ *   --seconds  length of each stream (default: 60)
+ *   --out      write the JSON to FILE instead of stdout
+ *
+ * exits with an error if the outputs drift more than 1% of the range apart
+ * or leave it, or a curve lands more than 0.5% of the range from exact
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "AnalogReader.h"
+#include "JsonWriter.h"
+#include <ResponsiveAnalogRead.h>
+
+typedef std::chrono::steady_clock BenchClock;
+
+// the read timer
+#define UPDATEHZ 1000
+// passes over each stream timed (the fastest is kept)
+#define REPEATS 10
+// the outputs may be this far apart (in the root mean square), 1% of the range
+#define MAXRMS 328
+// settled is within this much of where a step goes (a 13-bit step of CV)
+#define SETTLED 4
+// a curve may land this far from exact, 0.5% of the range
+#define MAXCURVE 164
+
+#define MAXPOT 16379
+
+/*
+ * AnalogReader as it was (the scaling of Read(), then Scale())
+ */
+class LegacyReader
+{
+  public:
+
+    LegacyReader(bool reverse) {
+      _reverse = reverse;
+      if (!_reverse) _bottom = 0;
+      if (_reverse)
+        _analog = new ResponsiveAnalogRead(0, false);
+      else
+        _analog = new ResponsiveAnalogRead(0, true, .0001);
+      _analog->setAnalogResolution(1<<13);
+      _calibrationData[0] = -16384;
+      _calibrationData[1] = 0;
+      _calibrationData[2] = 16383;
+    }
+
+    ~LegacyReader() {
+      delete _analog;
+    }
+
+    int Update(int value) {
+      _readValue = value;
+      _analog->update(_readValue);
+      _readValue = _analog->getValue();
+      if (!_reverse){
+        _readValue = constrain(_readValue, 0, MAXPOT);
+        _readValue = map(_readValue, 0, MAXPOT, 0, 16383);
+      }
+      _readValue = _readValue << (_reverse ? 2 : 1);
+      if (_reverse) _readValue = 16383 - _readValue;
+      if (_calibrated) _readValue = Scale(_readValue);
+      if (_map){
+        _readValue = map(_readValue, _reverse ? BOTTOM : 0, TOP, _bottom, _top);
+      }
+      return _readValue;
+    }
+
+    void SetMap(int top, int bottom) {
+      _top = top;
+      _bottom = bottom;
+      _map = _top != TOP || _bottom != (_reverse ? BOTTOM : 0);
+    }
+
+    void SetCalibrationData(int measure, int value) {
+      _calibrationData[measure] = value;
+    }
+
+    void SetCalibrated(bool calibrated) {
+      _calibrated = calibrated;
+    }
+
+  private:
+
+    int Scale(int value) {
+      if (value >= _calibrationData[1]){
+        value = map(value, _calibrationData[1], _calibrationData[2], 0, 16383);
+      } else {
+        value = map(value, _calibrationData[0], _calibrationData[1], -16384, 0);
+      }
+      return constrain(value, -16384, 16383);
+    }
+
+    bool _reverse;
+    ResponsiveAnalogRead *_analog;
+    int volatile _readValue;
+    int _calibrationData[3];
+    bool _calibrated = false;
+    bool _map = false;
+    int _top = TOP;
+    int _bottom = BOTTOM;
+
+};
+
+/*
+ * a stream: the input's shape (16-bit ADC units, with the scanner's
+ * leftover noise) and the reader's settings
+ */
+struct Stream {
+  const char *Name;
+  bool Cv;
+  int Shape;
+  int Noise;
+  int Calibration[3];
+  int Top;
+  int Bottom;
+};
+
+#define SHAPE_STILL 0
+#define SHAPE_TURNED 1
+#define SHAPE_SINE 2
+#define SHAPE_STEPS 3
+
+static const Stream streams[] = {
+  { "knob at rest", false, SHAPE_STILL, 24, { 0 }, TOP, 0 },
+  { "knob turned", false, SHAPE_TURNED, 24, { 0 }, TOP, 0 },
+  { "knob calibrated", false, SHAPE_TURNED, 24, { 0, 8100, 16300 }, TOP, 0 },
+  { "cv at rest", true, SHAPE_STILL, 24, { 0 }, TOP, BOTTOM },
+  { "cv sine", true, SHAPE_SINE, 24, { 0 }, TOP, BOTTOM },
+  { "cv steps", true, SHAPE_STEPS, 24, { 0 }, TOP, BOTTOM },
+  { "cv calibrated and mapped", true, SHAPE_SINE, 24, { -16100, 150, 16250 }, 1000, -1000 },
+};
+#define STREAMCOUNT (sizeof(streams) / sizeof(streams[0]))
+
+/*
+ * the curves, each run on these streams
+ */
+struct Curve {
+  const char *Name;
+  int Curve;
+};
+
+static const Curve curves[] = {
+  { "exponential", CURVE_EXP },
+  { "logarithmic", CURVE_LOG },
+  { "s-curve", CURVE_S },
+  { "user", CURVE_USER },
+};
+#define CURVECOUNT (sizeof(curves) / sizeof(curves[0]))
+
+static const int curveStreams[] = { 1, 6 };
+#define CURVESTREAMCOUNT (sizeof(curveStreams) / sizeof(curveStreams[0]))
+
+// a user curve, steep through the middle
+static const int userPoints[CURVEPOINTS] = { 0, 400, 1600, 4000, 8192, 12400, 14800, 16000, 16383 };
+
+struct CurveSummary {
+  double LinearNs;
+  double CurvedNs;
+  double RmsError;
+  long MaxError;
+};
+
+struct Summary {
+  double LegacyNs;
+  double FixedNs;
+  double RmsDifference;
+  long MaxDifference;
+  long LegacyChanges;
+  long FixedChanges;
+  double LegacyJitter;
+  double FixedJitter;
+  double LegacySettle;
+  double FixedSettle;
+  bool InRange;
+};
+
+static uint32_t random32 = 1;
+
+static int Noise(int amount) {
+  random32 = random32 * 1664525 + 1013904223;
+  return amount ? (int)((random32 >> 8) % (2 * amount + 1)) - amount : 0;
+}
+
+/*
+ * the stream's values, and where each step is going (-1 while none is)
+ */
+static void Generate(const Stream& s, long updates, std::vector<int>& values, std::vector<long>& steps) {
+  random32 = 1;
+  values.resize(updates);
+  steps.assign(updates, -1);
+  int level = 40000;
+  for (long u = 0; u < updates; u++) {
+    double t = (double)u / UPDATEHZ;
+    double v;
+    switch (s.Shape) {
+      case SHAPE_TURNED: {
+        // turned up over a second, left for three, turned back down, left for three
+        double p = fmod(t, 8);
+        v = p < 1 ? 8000 + 49000 * p : p < 4 ? 57000 : p < 5 ? 57000 - 49000 * (p - 4) : 8000;
+        break;
+      }
+      case SHAPE_SINE:
+        v = 32768 + 30000 * sin(2 * M_PI * t);
+        break;
+      case SHAPE_STEPS:
+        // a new level every 250 ms
+        if (u % (UPDATEHZ / 4) == 0) level = 32000 + Noise(28000);
+        v = level;
+        break;
+      default:
+        v = 30000;
+    }
+    values[u] = constrain((int)lround(v) + Noise(s.Noise), 0, 65535);
+    if (s.Shape == SHAPE_STEPS && u % (UPDATEHZ / 4) == 0) steps[u] = level;
+  }
+}
+
+/*
+ * how far the output wanders from its mean (after the first second)
+ */
+static double Jitter(const std::vector<int>& out) {
+  double sum = 0, squares = 0;
+  long n = 0;
+  for (size_t u = UPDATEHZ; u < out.size(); u++, n++)
+    sum += out[u];
+  double mean = n ? sum / n : 0;
+  for (size_t u = UPDATEHZ; u < out.size(); u++)
+    squares += (out[u] - mean) * (out[u] - mean);
+  return n ? sqrt(squares / n) : 0;
+}
+
+/*
+ * updates until the output stays within SETTLED of where it ends up before
+ * the next step, averaged over the steps
+ */
+static double Settle(const std::vector<int>& out, const std::vector<long>& steps) {
+  double total = 0;
+  long count = 0;
+  for (size_t u = 0; u < out.size(); u++) {
+    if (steps[u] < 0) continue;
+    size_t end = u + 1;
+    while (end < out.size() && steps[end] < 0) end++;
+    int final = out[end - 1];
+    size_t settled = end - 1;
+    while (settled > u && abs(out[settled - 1] - final) <= SETTLED) settled--;
+    total += settled - u;
+    count++;
+  }
+  return count ? total / count : 0;
+}
+
+static void Configure(const Stream& s, LegacyReader *legacy, AnalogReader *fixed) {
+  if (s.Calibration[0] || s.Calibration[1] || s.Calibration[2]) {
+    for (int m = 0; m < 3; m++) {
+      legacy->SetCalibrationData(m, s.Calibration[m]);
+      fixed->SetCalibrationData(m, s.Calibration[m]);
+    }
+    legacy->SetCalibrated(true);
+    fixed->SetCalibrated(true);
+  }
+  legacy->SetMap(s.Top, s.Bottom);
+  fixed->SetMap(s.Top, s.Bottom);
+  fixed->Refresh();
+}
+
+static void Configure(const Stream& s, AnalogReader *reader, bool map) {
+  if (s.Calibration[0] || s.Calibration[1] || s.Calibration[2]) {
+    for (int m = 0; m < 3; m++)
+      reader->SetCalibrationData(m, s.Calibration[m]);
+    reader->SetCalibrated(true);
+  }
+  if (map) reader->SetMap(s.Top, s.Bottom);
+  reader->Refresh();
+}
+
+static Summary Run(const Stream& s, double seconds) {
+
+  Summary summary;
+  memset(&summary, 0, sizeof(summary));
+
+  long updates = (long)(seconds * UPDATEHZ);
+  std::vector<int> values, legacyOut(updates), fixedOut(updates);
+  std::vector<long> steps;
+  Generate(s, updates, values, steps);
+
+  double legacyBest = 0, fixedBest = 0;
+  for (int r = 0; r < REPEATS; r++) {
+    LegacyReader *legacy = new LegacyReader(s.Cv);
+    AnalogReader *fixed = new AnalogReader(0, s.Cv);
+    Configure(s, legacy, fixed);
+
+    // the legacy chain read 13 bits; the scanner hands over 16
+    BenchClock::time_point start = BenchClock::now();
+    for (long u = 0; u < updates; u++)
+      legacyOut[u] = legacy->Update(values[u] >> READSHIFT);
+    double legacyNs = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+
+    start = BenchClock::now();
+    for (long u = 0; u < updates; u++)
+      fixedOut[u] = fixed->Update(values[u]);
+    double fixedNs = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+
+    if (!r || legacyNs < legacyBest) legacyBest = legacyNs;
+    if (!r || fixedNs < fixedBest) fixedBest = fixedNs;
+    delete legacy;
+    delete fixed;
+  }
+  summary.LegacyNs = legacyBest / updates;
+  summary.FixedNs = fixedBest / updates;
+
+  // the first second, from power up, is left out of the comparison
+  double squares = 0;
+  long compared = 0;
+  summary.InRange = true;
+  for (long u = 0; u < updates; u++) {
+    if (fixedOut[u] < BOTTOM || fixedOut[u] > TOP) summary.InRange = false;
+    if (u > 0 && legacyOut[u] != legacyOut[u - 1]) summary.LegacyChanges++;
+    if (u > 0 && fixedOut[u] != fixedOut[u - 1]) summary.FixedChanges++;
+    if (u < UPDATEHZ) continue;
+    long difference = labs((long)fixedOut[u] - legacyOut[u]);
+    squares += (double)difference * difference;
+    if (difference > summary.MaxDifference) summary.MaxDifference = difference;
+    compared++;
+  }
+  summary.RmsDifference = compared ? sqrt(squares / compared) : 0;
+  summary.LegacyJitter = Jitter(legacyOut);
+  summary.FixedJitter = Jitter(fixedOut);
+  summary.LegacySettle = Settle(legacyOut, steps);
+  summary.FixedSettle = Settle(fixedOut, steps);
+  return summary;
+}
+
+/*
+ * the curved reader against one without the curve (and unmapped), whose
+ * output goes through the curve and the map in doubles
+ */
+static CurveSummary RunCurve(const Stream& s, int curve, double seconds) {
+
+  CurveSummary summary;
+  memset(&summary, 0, sizeof(summary));
+
+  long updates = (long)(seconds * UPDATEHZ);
+  std::vector<int> values, linearOut(updates), curvedOut(updates);
+  std::vector<long> steps;
+  Generate(s, updates, values, steps);
+
+  double linearBest = 0, curvedBest = 0;
+  for (int r = 0; r < REPEATS; r++) {
+    AnalogReader *linear = new AnalogReader(0, s.Cv);
+    AnalogReader *curved = new AnalogReader(0, s.Cv);
+    Configure(s, linear, true);
+    Configure(s, curved, true);
+    for (int p = 0; p < CURVEPOINTS; p++)
+      curved->SetCurvePoint(p, userPoints[p]);
+    curved->SetCurve(curve);
+    curved->Refresh();
+
+    BenchClock::time_point start = BenchClock::now();
+    for (long u = 0; u < updates; u++)
+      linearOut[u] = linear->Update(values[u]);
+    double linearNs = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+
+    start = BenchClock::now();
+    for (long u = 0; u < updates; u++)
+      curvedOut[u] = curved->Update(values[u]);
+    double curvedNs = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+
+    if (!r || linearNs < linearBest) linearBest = linearNs;
+    if (!r || curvedNs < curvedBest) curvedBest = curvedNs;
+    delete linear;
+    delete curved;
+  }
+  summary.LinearNs = linearBest / updates;
+  summary.CurvedNs = curvedBest / updates;
+
+  AnalogReader *plain = new AnalogReader(0, s.Cv);
+  AnalogReader *shape = new AnalogReader(0, s.Cv);
+  Configure(s, plain, false);
+  for (int p = 0; p < CURVEPOINTS; p++)
+    shape->SetCurvePoint(p, userPoints[p]);
+  shape->SetCurve(curve);
+
+  bool calibrated = s.Calibration[0] || s.Calibration[1] || s.Calibration[2];
+  double low = calibrated || s.Cv ? BOTTOM : 0;
+  double from = s.Cv ? BOTTOM : 0;
+  double squares = 0;
+  long compared = 0;
+  for (long u = 0; u < updates; u++) {
+    double exact = plain->Update(values[u]);
+    exact = low + (TOP - low) * shape->Shape(constrain((exact - low) / (TOP - low), 0., 1.));
+    exact = (exact - from) * (s.Top - s.Bottom) / (TOP - from) + s.Bottom;
+    if (u < UPDATEHZ) continue;
+    long error = lround(fabs(curvedOut[u] - exact));
+    squares += (double)error * error;
+    if (error > summary.MaxError) summary.MaxError = error;
+    compared++;
+  }
+  summary.RmsError = compared ? sqrt(squares / compared) : 0;
+
+  delete plain;
+  delete shape;
+  return summary;
+}
+
+int main(int argc, char *argv[]) {
+
+  double seconds = 60;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--seconds") && a + 1 < argc)
+      seconds = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--seconds N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (seconds < 2) seconds = 2;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("seconds", seconds);
+  json.Field("update_hz", (long)UPDATEHZ);
+  json.BeginArray("streams");
+
+  for (size_t s = 0; s < STREAMCOUNT; s++) {
+    Summary summary = Run(streams[s], seconds);
+    if (summary.RmsDifference > MAXRMS || !summary.InRange) pass = false;
+
+    json.BeginObject();
+    json.Field("name", streams[s].Name);
+    json.Field("legacy_ns", summary.LegacyNs);
+    json.Field("fixed_ns", summary.FixedNs);
+    json.Field("speedup", summary.FixedNs > 0 ? summary.LegacyNs / summary.FixedNs : 0.);
+    json.Field("rms_difference", summary.RmsDifference);
+    json.Field("max_difference", summary.MaxDifference);
+    json.Field("legacy_output_changes", summary.LegacyChanges);
+    json.Field("fixed_output_changes", summary.FixedChanges);
+    if (streams[s].Shape == SHAPE_STILL) {
+      json.Field("legacy_jitter_rms", summary.LegacyJitter);
+      json.Field("fixed_jitter_rms", summary.FixedJitter);
+    }
+    if (streams[s].Shape == SHAPE_STEPS) {
+      json.Field("legacy_settle_updates", summary.LegacySettle);
+      json.Field("fixed_settle_updates", summary.FixedSettle);
+    }
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.BeginArray("curves");
+
+  for (size_t c = 0; c < CURVECOUNT; c++) {
+    for (size_t i = 0; i < CURVESTREAMCOUNT; i++) {
+      const Stream& stream = streams[curveStreams[i]];
+      CurveSummary summary = RunCurve(stream, curves[c].Curve, seconds);
+      if (summary.MaxError > MAXCURVE) pass = false;
+
+      json.BeginObject();
+      json.Field("curve", curves[c].Name);
+      json.Field("stream", stream.Name);
+      json.Field("linear_ns", summary.LinearNs);
+      json.Field("curved_ns", summary.CurvedNs);
+      json.Field("rms_error", summary.RmsError);
+      json.Field("max_error", summary.MaxError);
+      json.EndObject();
+    }
+  }
+
+  json.EndArray();
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "JsonWriter.h"
+
+/*
+ * JSON Writer
+ */
+
+JsonWriter::JsonWriter(FILE *out) {
+  _out = out;
+  _first = true;
+  _depth = 0;
+}
+
+void JsonWriter::Key(const char *key) {
+  if (!_first) fputs(",", _out);
+  fprintf(_out, "\n%*s", _depth * 2, "");
+  if (key) fprintf(_out, "\"%s\": ", key);
+  _first = false;
+}
+
+void JsonWriter::BeginObject(const char *key) {
+  if (_depth > 0) Key(key);
+  fputs("{", _out);
+  _first = true;
+  _depth++;
+}
+
+void JsonWriter::EndObject() {
+  _depth--;
+  fprintf(_out, "\n%*s}", _depth * 2, "");
+  if (_depth == 0) fputs("\n", _out);
+  _first = false;
+}
+
+void JsonWriter::BeginArray(const char *key) {
+  Key(key);
+  fputs("[", _out);
+  _first = true;
+  _depth++;
+}
+
+void JsonWriter::EndArray() {
+  _depth--;
+  fprintf(_out, "\n%*s]", _depth * 2, "");
+  _first = false;
+}
+
+void JsonWriter::Field(const char *key, const char *value) {
+  Key(key);
+  fprintf(_out, "\"%s\"", value);
+}
+
+void JsonWriter::Field(const char *key, long value) {
+  Key(key);
+  fprintf(_out, "%ld", value);
+}
+
+void JsonWriter::Field(const char *key, double value) {
+  Key(key);
+  fprintf(_out, "%.3f", value);
+}
+
+void JsonWriter::Field(const char *key, bool value) {
+  Key(key);
+  fputs(value ? "true" : "false", _out);
+}
+
+void JsonWriter::Stats(const BenchStats& stats) {
+  Field("ticks", (long)stats.Ticks);
+  Field("ns_per_sample", stats.MeanNs);
+  Field("ns_per_channel", stats.MeanNs / 4);
+  Field("p99_ns", stats.P99Ns);
+  Field("worst_ns", stats.WorstNs);
+  Field("peak_tick_ns", stats.PeakNs);
+  Field("headroom", stats.Headroom);
+}
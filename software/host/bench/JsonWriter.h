@@ -0,0 +1,56 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef JsonWriter_h
+#define JsonWriter_h
+
+#include <stdio.h>
+
+/*
+ * timing results for one benchmark scenario
+ */
+struct BenchStats {
+  unsigned long Ticks;
+  double MeanNs;
+  double P99Ns;
+  double WorstNs;
+  // the costliest tick of the OSCBUFFER-tick render cycle (the median of each
+  // tick of it, so host preemption doesn't count); the headroom is against it
+  double PeakNs;
+  double Headroom;
+};
+
+/*
+ * minimal streaming JSON writer for machine-readable results
+ */
+class JsonWriter
+{
+  public:
+
+    JsonWriter(FILE *out);
+
+    void BeginObject(const char *key = NULL);
+    void EndObject();
+    void BeginArray(const char *key);
+    void EndArray();
+
+    void Field(const char *key, const char *value);
+    void Field(const char *key, long value);
+    void Field(const char *key, double value);
+    void Field(const char *key, bool value);
+    void Stats(const BenchStats& stats);
+
+  private:
+
+    void Key(const char *key);
+
+    FILE *_out;
+    bool _first;
+    int _depth;
+
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * per-sample cost of the writeOutputs() ISR for typical mixed patches with
+ * every output at audio rate and with slow oscillators at the control rate;
+ * reports the rate each output runs at, the time saved and how far the
+ * control rate output strays from the audio rate one; results are written
+ * as JSON
+ *
+ * usage: telexo_multirate_bench [--ticks N] [--out FILE]
+ *   --ticks  ISR passes per patch and mode (default: one second of samples)
+ *   --out    write the JSON to FILE instead of stdout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "Oscillator.h"
+
+#define CH_IDLE 0
+#define CH_AUDIO 1
+#define CH_LFO 2
+#define CH_SLEW 3
+#define CH_ENVELOPE 4
+
+static const char *rateNames[] = { "idle", "ramp", "control", "audio" };
+
+struct Channel {
+  int Mode;
+  int Wave;
+  // Hz for audio, millihertz for an LFO
+  int Frequency;
+};
+
+struct Patch {
+  const char *Name;
+  Channel Channels[4];
+};
+
+static const Patch patches[] = {
+  { "voice+lfo+slew+env", { { CH_AUDIO, 0, 220 }, { CH_LFO, 1 * MORPHRANGE, 2000 }, { CH_SLEW, 0, 0 }, { CH_ENVELOPE, 0, 0 } } },
+  { "four lfos", { { CH_LFO, 0, 500 }, { CH_LFO, 1 * MORPHRANGE, 1000 }, { CH_LFO, 4 * MORPHRANGE, 3000 }, { CH_LFO, 20 * MORPHRANGE + 50, 5000 } } },
+  { "two voices+two lfos", { { CH_AUDIO, 0, 110 }, { CH_AUDIO, 4 * MORPHRANGE, 330 }, { CH_LFO, 0, 250 }, { CH_LFO, 2 * MORPHRANGE, 4000 } } },
+  { "lfos+envelopes", { { CH_LFO, 0, 100 }, { CH_LFO, 4 * MORPHRANGE + 25, 1500 }, { CH_ENVELOPE, 0, 0 }, { CH_ENVELOPE, 0, 0 } } },
+  { "lfo+idle", { { CH_LFO, 0, 700 }, { CH_IDLE, 0, 0 }, { CH_IDLE, 0, 0 }, { CH_IDLE, 0, 0 } } },
+  { "four voices", { { CH_AUDIO, 0, 110 }, { CH_AUDIO, 1 * MORPHRANGE, 220 }, { CH_AUDIO, 4 * MORPHRANGE, 440 }, { CH_AUDIO, 20 * MORPHRANGE, 880 } } },
+};
+#define PATCHCOUNT (sizeof(patches) / sizeof(patches[0]))
+
+static const Patch *current = NULL;
+
+/*
+ * keeps the slewing outputs moving (outside of the timed region)
+ */
+static void Retarget(BenchRig& rig, unsigned long tick) {
+  if (tick % 2000 != 0) return;
+  bool up = (tick / 2000) % 2 == 0;
+  for (int i = 0; i < 4; i++)
+    if (current->Channels[i].Mode == CH_SLEW)
+      rig.cv[i]->TargetValue(up ? 16383 : -8192);
+}
+
+static void Apply(BenchRig& rig, const Patch& p) {
+  rig.Reset();
+  current = &p;
+  for (int i = 0; i < 4; i++) {
+    CVOutput *cv = rig.cv[i];
+    const Channel& c = p.Channels[i];
+    if (c.Mode == CH_SLEW) cv->SetSlew(60, 0);
+    if (c.Mode == CH_ENVELOPE) {
+      cv->SetEnvelopeMode(1);
+      cv->SetAttack(20, 0);
+      cv->SetDecay(150, 0);
+      cv->SetLoop(0);
+    }
+    cv->SetValue(16383);
+    if (c.Mode == CH_AUDIO || c.Mode == CH_LFO) {
+      cv->SetWaveform(c.Wave);
+      if (c.Mode == CH_AUDIO)
+        cv->SetFrequency(c.Frequency);
+      else
+        cv->SetLFO(c.Frequency);
+    }
+    if (c.Mode == CH_ENVELOPE) cv->TriggerEnvelope();
+  }
+}
+
+/*
+ * the DAC output of every channel on every tick
+ */
+static void Record(BenchRig& rig, const Patch& p, unsigned long ticks, std::vector<uint16_t> out[4]) {
+  Apply(rig, p);
+  for (unsigned long t = 0; t < ticks; t++) {
+    Retarget(rig, t);
+    rig.Tick();
+    for (int i = 0; i < 4; i++)
+      out[i][t] = HostHal::DacOutput(dacOutputs[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long ticks = SAMPLINGRATE;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--ticks") && a + 1 < argc)
+      ticks = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (ticks == 0) ticks = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  BenchRig rig;
+  JsonWriter json(out);
+  std::vector<uint16_t> audio[4];
+  std::vector<uint16_t> control[4];
+  for (int i = 0; i < 4; i++) {
+    audio[i].resize(ticks);
+    control[i].resize(ticks);
+  }
+  double totalAudio = 0;
+  double totalMultirate = 0;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("control_rate", (double)SAMPLINGRATE / OSCBUFFER);
+  json.Field("ticks", (long)ticks);
+  json.BeginArray("patches");
+
+  for (size_t p = 0; p < PATCHCOUNT; p++) {
+
+    CVOutput::SetMultirate(false);
+    Record(rig, patches[p], ticks, audio);
+    Apply(rig, patches[p]);
+    BenchStats all = rig.Run(ticks, Retarget);
+
+    CVOutput::SetMultirate(true);
+    Record(rig, patches[p], ticks, control);
+    Apply(rig, patches[p]);
+    BenchStats multirate = rig.Run(ticks, Retarget);
+
+    totalAudio += all.MeanNs;
+    totalMultirate += multirate.MeanNs;
+
+    json.BeginObject();
+    json.Field("name", patches[p].Name);
+    json.BeginArray("channels");
+    for (int i = 0; i < 4; i++) {
+      long worst = 0;
+      double sum = 0;
+      for (unsigned long t = 0; t < ticks; t++) {
+        long difference = labs((long)audio[i][t] - control[i][t]);
+        sum += difference;
+        if (difference > worst) worst = difference;
+      }
+      json.BeginObject();
+      json.Field("rate", rateNames[rig.cv[i]->GetRate()]);
+      json.Field("max_difference", worst);
+      json.Field("mean_difference", sum / ticks);
+      json.EndObject();
+    }
+    json.EndArray();
+    json.Field("audio_rate_ns_per_sample", all.MeanNs);
+    json.Field("multirate_ns_per_sample", multirate.MeanNs);
+    json.Field("saved", all.MeanNs > 0 ? 1. - multirate.MeanNs / all.MeanNs : 0.);
+    json.Field("multirate_headroom", multirate.Headroom);
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.BeginObject("summary");
+  json.Field("patches", (long)PATCHCOUNT);
+  json.Field("audio_rate_ns_per_sample", totalAudio / PATCHCOUNT);
+  json.Field("multirate_ns_per_sample", totalMultirate / PATCHCOUNT);
+  json.Field("saved", totalAudio > 0 ? 1. - totalMultirate / totalAudio : 0.);
+  json.EndObject();
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return 0;
+}
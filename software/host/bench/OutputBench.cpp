@@ -0,0 +1,223 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * per-sample cost of the TELEXo writeOutputs() ISR across the oscillator,
+ * slew, log and envelope modes; results are written as JSON
+ *
+ * usage: telexo_bench [--ticks N] [--all] [--max-ns N] [--out FILE]
+ *   --ticks   ISR passes per scenario (default: one second of samples)
+ *   --all     run the rectify/portamento/log combinations for every wavetable
+ *             (default: only for the sine/triangle/saw/square fast paths)
+ *   --max-ns  exit with an error if the costliest tick of any scenario's render
+ *             cycle takes more than N ns
+ *   --out     write the JSON to FILE instead of stdout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "Oscillator.h"
+
+// sine, triangle, saw and square are tables 0-3 (see Wavetables.h)
+#define LASTFASTWAVE 3
+
+static const int frequencies[4] = { 110, 220, 440, 880 };
+
+struct Scenario {
+  char Name[48];
+  bool Oscillator;
+  int Wave;
+  int Rectify;
+  bool Portamento;
+  bool Log;
+  bool Slew;
+  bool Envelope;
+};
+
+/*
+ * keeps portamento and slew moving by retargeting outside of the timed region
+ */
+static void Retarget(BenchRig& rig, unsigned long tick) {
+  if (tick % 300 != 0) return;
+  bool up = (tick / 300) % 2 == 0;
+  for (int i = 0; i < 4; i++) {
+    rig.cv[i]->TargetFrequency(frequencies[i] * (up ? 2 : 1));
+    rig.cv[i]->TargetValue(up ? 16383 : 4096);
+  }
+}
+
+static void Apply(BenchRig& rig, const Scenario& s) {
+  rig.Reset();
+  for (int i = 0; i < 4; i++) {
+    CVOutput *cv = rig.cv[i];
+    if (s.Log) cv->SetLog(1);
+    if (s.Slew) cv->SetSlew(10, 0);
+    if (s.Envelope) {
+      cv->SetEnvelopeMode(1);
+      cv->SetAttack(2, 0);
+      cv->SetDecay(8, 0);
+      cv->SetLoop(0);
+    }
+    cv->SetValue(16383);
+    if (s.Oscillator) {
+      cv->SetWaveform(s.Wave);
+      cv->SetRectify(s.Rectify);
+      if (s.Portamento) cv->SetFrequencySlew(20, 0);
+      cv->SetFrequency(frequencies[i]);
+    }
+    if (s.Envelope) cv->TriggerEnvelope();
+  }
+}
+
+static Scenario Make(const char *name, bool oscillator, int wave, int rectify, bool portamento, bool log, bool slew, bool envelope) {
+  Scenario s;
+  snprintf(s.Name, sizeof(s.Name), "%s", name);
+  s.Oscillator = oscillator;
+  s.Wave = wave;
+  s.Rectify = rectify;
+  s.Portamento = portamento;
+  s.Log = log;
+  s.Slew = slew;
+  s.Envelope = envelope;
+  return s;
+}
+
+/*
+ * rectify x portamento x log x morph for one table
+ */
+static void AddCombinations(std::vector<Scenario>& list, int table) {
+  char name[48];
+  for (int morph = 0; morph <= 50; morph += 50)
+    for (int rect = -2; rect <= 2; rect++)
+      for (int porta = 0; porta < 2; porta++)
+        for (int log = 0; log < 2; log++) {
+          snprintf(name, sizeof(name), "combo/w%d/m%d/r%d/p%d/l%d", table, morph, rect, porta, log);
+          list.push_back(Make(name, true, table * MORPHRANGE + morph, rect, porta, log, false, false));
+        }
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long ticks = SAMPLINGRATE;
+  bool all = false;
+  double maxNs = 0;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--ticks") && a + 1 < argc)
+      ticks = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--all"))
+      all = true;
+    else if (!strcmp(argv[a], "--max-ns") && a + 1 < argc)
+      maxNs = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--all] [--max-ns N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  int tables = Oscillator::GetWaveformCount();
+  char name[48];
+
+  // build the scenario list
+  std::vector<Scenario> list;
+  list.push_back(Make("cv/static", false, 0, 0, false, false, false, false));
+  list.push_back(Make("cv/slew", false, 0, 0, false, false, true, false));
+  list.push_back(Make("cv/slew+log", false, 0, 0, false, true, true, false));
+  list.push_back(Make("env/loop", false, 0, 0, false, false, false, true));
+  list.push_back(Make("env/loop+osc", true, 0, 0, false, false, false, true));
+  list.push_back(Make("env/loop+osc+log", true, 0, 0, false, true, false, true));
+
+  // every table (and noise) with and without morphing
+  for (int w = 0; w <= tables; w++) {
+    snprintf(name, sizeof(name), "wave/%d", w);
+    list.push_back(Make(name, true, w * MORPHRANGE, 0, false, false, false, false));
+    snprintf(name, sizeof(name), "wave/%d+morph", w);
+    list.push_back(Make(name, true, w * MORPHRANGE + MORPHRANGE / 2, 0, false, false, false, false));
+  }
+
+  // the modifiers on the fast paths (or everywhere)
+  for (int w = 0; w <= (all ? tables : LASTFASTWAVE); w++)
+    AddCombinations(list, w);
+
+  BenchRig rig;
+  JsonWriter json(out);
+
+  double worstMean = 0;
+  double worstTick = 0;
+  double peakTick = 0;
+  const char *peakName = "";
+  double totalMean = 0;
+  const char *worstName = "";
+  bool over = false;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("sample_period_ns", SAMPLEPERIODNS);
+  json.Field("channels", 4L);
+  json.BeginArray("scenarios");
+
+  for (size_t i = 0; i < list.size(); i++) {
+    const Scenario& s = list[i];
+    Apply(rig, s);
+    BenchStats stats = rig.Run(ticks, (s.Portamento || s.Slew) ? Retarget : NULL);
+
+    json.BeginObject();
+    json.Field("name", s.Name);
+    json.Field("oscillator", s.Oscillator);
+    json.Field("wave", (long)s.Wave);
+    json.Field("rectify", (long)s.Rectify);
+    json.Field("portamento", s.Portamento);
+    json.Field("log", s.Log);
+    json.Field("slew", s.Slew);
+    json.Field("envelope", s.Envelope);
+    json.Stats(stats);
+    json.EndObject();
+
+    totalMean += stats.MeanNs;
+    if (stats.MeanNs > worstMean) {
+      worstMean = stats.MeanNs;
+      worstName = s.Name;
+    }
+    if (stats.WorstNs > worstTick) worstTick = stats.WorstNs;
+    if (stats.PeakNs > peakTick) {
+      peakTick = stats.PeakNs;
+      peakName = s.Name;
+    }
+    if (maxNs > 0 && stats.PeakNs > maxNs) over = true;
+  }
+
+  json.EndArray();
+  json.BeginObject("summary");
+  json.Field("scenarios", (long)list.size());
+  json.Field("mean_ns_per_sample", list.empty() ? 0. : totalMean / list.size());
+  json.Field("worst_scenario", worstName);
+  json.Field("worst_scenario_ns_per_sample", worstMean);
+  json.Field("worst_tick_ns", worstTick);
+  json.Field("peak_tick_scenario", peakName);
+  json.Field("peak_tick_ns", peakTick);
+  json.Field("min_headroom", 1. - peakTick / SAMPLEPERIODNS);
+  if (maxNs > 0) {
+    json.Field("max_ns", maxNs);
+    json.Field("pass", !over);
+  }
+  json.EndObject();
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return over ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * per-sample cost of Oscillator::Oscillate() against Oscillator::Render()
+ * at several block sizes, checking that both produce the same samples;
+ * results are written as JSON
+ *
+ * usage: telexo_render_bench [--samples N] [--all] [--out FILE]
+ *   --samples  samples rendered per scenario and path (default: four seconds)
+ *   --all      run every wavetable (default: the fast paths and a few tables)
+ *   --out      write the JSON to FILE instead of stdout
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "Oscillator.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+// retarget the portamento scenarios this often (in samples)
+#define RETARGETSAMPLES 300
+
+static const size_t blockSizes[] = { 1, 4, 16, RENDERBLOCK };
+#define BLOCKSIZECOUNT (sizeof(blockSizes) / sizeof(blockSizes[0]))
+
+struct Scenario {
+  char Name[48];
+  int Wave;
+  int Frequency;
+  int Width;
+  int Rectify;
+  bool Portamento;
+  // scan the tables instead of setting the waveform (sliding the position back and forth)
+  bool Scan;
+  bool ScanSlew;
+  int ScanFrom;
+  int ScanTo;
+};
+
+static Scenario Make(const char *name, int wave, int frequency, int width, int rectify, bool portamento) {
+  Scenario s;
+  snprintf(s.Name, sizeof(s.Name), "%s", name);
+  s.Wave = wave;
+  s.Frequency = frequency;
+  s.Width = width;
+  s.Rectify = rectify;
+  s.Portamento = portamento;
+  s.Scan = false;
+  s.ScanSlew = false;
+  s.ScanFrom = 0;
+  s.ScanTo = 0;
+  return s;
+}
+
+static Scenario MakeScan(const char *name, int from, int to, int frequency, bool slew) {
+  Scenario s = Make(name, 0, frequency, 50, 0, false);
+  s.Scan = true;
+  s.ScanSlew = slew;
+  s.ScanFrom = from;
+  s.ScanTo = to;
+  return s;
+}
+
+static void Apply(Oscillator& osc, const Scenario& s) {
+  osc.SetWaveform(s.Wave);
+  osc.SetWidth(s.Width);
+  osc.SetRectify(s.Rectify);
+  if (s.Portamento) osc.SetPortamentoMs(20);
+  osc.SetFrequency(s.Frequency);
+  osc.ResetPhase(0);
+  if (s.Scan) {
+    osc.SetScanFrom(s.ScanFrom);
+    osc.SetScanTo(s.ScanTo);
+    osc.SetScanSlewMs(s.ScanSlew ? 10 : 0);
+    osc.SetScan(SCANRANGE / 3);
+  }
+}
+
+static bool Retargets(const Scenario& s) {
+  return s.Portamento || s.ScanSlew;
+}
+
+static void Retarget(Oscillator& osc, const Scenario& s, size_t sample) {
+  if (!Retargets(s) || sample % RETARGETSAMPLES != 0) return;
+  if (s.ScanSlew)
+    osc.TargetScan((sample / RETARGETSAMPLES) % 2 == 0 ? SCANRANGE : 0);
+  else
+    osc.TargetFrequency((sample / RETARGETSAMPLES) % 2 == 0 ? s.Frequency * 2 : s.Frequency);
+}
+
+static double Elapsed(BenchClock::time_point start) {
+  return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+/*
+ * the scalar path as CVOutput used it, saturated like Render() (the whole loop is timed)
+ */
+static double RunScalar(const Scenario& s, std::vector<int16_t>& out) {
+  Oscillator osc;
+  Apply(osc, s);
+  randomSeed(1);
+  int value;
+  BenchClock::time_point start = BenchClock::now();
+  for (size_t i = 0; i < out.size(); i++) {
+    Retarget(osc, s, i);
+    value = osc.Oscillate();
+    out[i] = constrain(value, -32768, 32767);
+  }
+  return Elapsed(start) / out.size();
+}
+
+/*
+ * the block path; blocks are cut short at retarget points so both paths see the same commands
+ */
+static double RunBlocks(const Scenario& s, size_t block, std::vector<int16_t>& out) {
+  Oscillator osc;
+  Apply(osc, s);
+  randomSeed(1);
+  size_t i = 0;
+  size_t count;
+  BenchClock::time_point start = BenchClock::now();
+  while (i < out.size()) {
+    Retarget(osc, s, i);
+    count = block;
+    if (Retargets(s) && RETARGETSAMPLES - i % RETARGETSAMPLES < count) count = RETARGETSAMPLES - i % RETARGETSAMPLES;
+    if (out.size() - i < count) count = out.size() - i;
+    osc.Render(&out[i], count);
+    i += count;
+  }
+  return Elapsed(start) / out.size();
+}
+
+int main(int argc, char *argv[]) {
+
+  size_t samples = SAMPLINGRATE * 4;
+  bool all = false;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--samples") && a + 1 < argc)
+      samples = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--all"))
+      all = true;
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--samples N] [--all] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (samples == 0) samples = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  int tables = Oscillator::GetWaveformCount();
+  char name[48];
+
+  // build the scenario list
+  std::vector<Scenario> list;
+  list.push_back(Make("sine", 0, 440, 50, 0, false));
+  list.push_back(Make("triangle", 1 * MORPHRANGE, 440, 50, 0, false));
+  list.push_back(Make("saw", 2 * MORPHRANGE, 440, 50, 0, false));
+  list.push_back(Make("saw/blep", 2 * MORPHRANGE, 9000, 50, 0, false));
+  list.push_back(Make("square", 3 * MORPHRANGE, 440, 50, 0, false));
+  list.push_back(Make("square/pwm+blep", 3 * MORPHRANGE, 9000, 20, 0, false));
+  list.push_back(Make("sine+morph", MORPHRANGE / 2, 440, 50, 0, false));
+  list.push_back(Make("saw+morph/blep", 2 * MORPHRANGE + MORPHRANGE / 2, 9000, 50, 0, false));
+  list.push_back(Make("sine/rect", 0, 440, 50, -2, false));
+  list.push_back(Make("sine/porta", 0, 440, 50, 0, true));
+  list.push_back(Make("square/porta+rect", 3 * MORPHRANGE, 440, 30, 1, true));
+  list.push_back(Make("noise", tables * MORPHRANGE, 440, 50, 0, false));
+  list.push_back(Make("noise+morph/rect", tables * MORPHRANGE + MORPHRANGE / 2, 440, 50, 2, false));
+  list.push_back(MakeScan("scan", 4 * MORPHRANGE, (tables - 1) * MORPHRANGE, 440, false));
+  list.push_back(MakeScan("scan/slew", 4 * MORPHRANGE, 12 * MORPHRANGE, 440, true));
+  list.push_back(MakeScan("scan/slew+lfo", (tables - 1) * MORPHRANGE, 0, 2, true));
+  for (int w = 4; w < tables; w++) {
+    if (!all && w % 50 != 4) continue;
+    snprintf(name, sizeof(name), "table/%d", w);
+    list.push_back(Make(name, w * MORPHRANGE, 440, 50, 0, false));
+    snprintf(name, sizeof(name), "table/%d+morph/porta", w);
+    list.push_back(Make(name, w * MORPHRANGE + MORPHRANGE / 2, 440, 50, 0, true));
+  }
+
+  JsonWriter json(out);
+  std::vector<int16_t> scalar(samples);
+  std::vector<int16_t> block(samples);
+  bool identical = true;
+  double scalarTotal = 0;
+  double blockTotal[BLOCKSIZECOUNT] = { 0 };
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("samples", (long)samples);
+  json.BeginArray("scenarios");
+
+  for (size_t i = 0; i < list.size(); i++) {
+    const Scenario& s = list[i];
+    double scalarNs = RunScalar(s, scalar);
+    scalarTotal += scalarNs;
+
+    json.BeginObject();
+    json.Field("name", s.Name);
+    json.Field("wave", (long)s.Wave);
+    json.Field("scalar_ns_per_sample", scalarNs);
+    json.BeginArray("blocks");
+
+    for (size_t b = 0; b < BLOCKSIZECOUNT; b++) {
+      double blockNs = RunBlocks(s, blockSizes[b], block);
+      blockTotal[b] += blockNs;
+
+      size_t mismatches = 0;
+      size_t first = 0;
+      for (size_t k = 0; k < samples; k++)
+        if (scalar[k] != block[k] && mismatches++ == 0) first = k;
+      if (mismatches) identical = false;
+
+      json.BeginObject();
+      json.Field("block", (long)blockSizes[b]);
+      json.Field("ns_per_sample", blockNs);
+      json.Field("speedup", blockNs > 0 ? scalarNs / blockNs : 0.);
+      json.Field("mismatches", (long)mismatches);
+      if (mismatches) json.Field("first_mismatch", (long)first);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.BeginObject("summary");
+  json.Field("scenarios", (long)list.size());
+  json.Field("scalar_ns_per_sample", scalarTotal / list.size());
+  for (size_t b = 0; b < BLOCKSIZECOUNT; b++) {
+    snprintf(name, sizeof(name), "block%d_ns_per_sample", (int)blockSizes[b]);
+    json.Field(name, blockTotal[b] / list.size());
+  }
+  json.Field("identical", identical);
+  json.EndObject();
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "SpiSim.h"
+#include "HostHal.h"
+
+SpiSim::SpiSim(double clockHz, double gapNs) {
+  _now = 0;
+  _wordNs = 24 * 1000000000. / clockHz + gapNs;
+  _waited = 0;
+  _words = 0;
+  _buffer = NULL;
+  _count = 0;
+  _sent = 0;
+  _start = 0;
+}
+
+void SpiSim::Start(const uint32_t *words, uint8_t count) {
+  _buffer = words;
+  _count = count;
+  _sent = 0;
+  _start = _now;
+}
+
+bool SpiSim::Busy() {
+  Deliver();
+  return _sent < _count;
+}
+
+/*
+ * jumps to the end of the transfer, counting the jump as CPU time
+ */
+void SpiSim::Wait() {
+  double end = _start + _count * _wordNs;
+  if (_sent < _count && end > _now) {
+    _waited += end - _now;
+    _now = end;
+  }
+  Deliver();
+}
+
+void SpiSim::Advance(double ns) {
+  _now += ns;
+  Deliver();
+}
+
+double SpiSim::Now() {
+  return _now;
+}
+
+double SpiSim::WordNs() {
+  return _wordNs;
+}
+
+double SpiSim::WaitedNs() {
+  return _waited;
+}
+
+unsigned long SpiSim::Words() {
+  return _words;
+}
+
+/*
+ * the words finished by now reach the DAC, framed by SYNC like the FIFO does it
+ */
+void SpiSim::Deliver() {
+  while (_sent < _count && _start + (_sent + 1) * _wordNs <= _now) {
+    uint32_t word = _buffer[_sent++];
+    digitalWrite(HOST_DAC_SYNC_PIN, LOW);
+    HostHal::SpiByte((word >> 16) & 0xFF);
+    HostHal::SpiByte((word >> 8) & 0xFF);
+    HostHal::SpiByte(word & 0xFF);
+    digitalWrite(HOST_DAC_SYNC_PIN, HIGH);
+    _words++;
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef SpiSim_h
+#define SpiSim_h
+
+#include "DacQueue.h"
+
+/*
+ * a DMA-fed SPI peripheral in simulated time: each 24-bit word takes
+ * 24 clocks plus a gap for SYNC, and is handed to the DAC capture in
+ * HostHal once its last bit has shifted out
+ */
+class SpiSim : public DacTransport
+{
+  public:
+
+    SpiSim(double clockHz, double gapNs);
+
+    void Start(const uint32_t *words, uint8_t count);
+    bool Busy();
+    void Wait();
+
+    // moves simulated time forward
+    void Advance(double ns);
+
+    double Now();
+    double WordNs();
+    // time spent inside Wait() (the CPU busy-waiting)
+    double WaitedNs();
+    unsigned long Words();
+
+  private:
+
+    void Deliver();
+
+    double _now;
+    double _wordNs;
+    double _waited;
+    unsigned long _words;
+
+    const uint32_t *_buffer;
+    uint8_t _count;
+    uint8_t _sent;
+    double _start;
+
+};
+
+#endif
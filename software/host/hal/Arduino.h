@@ -0,0 +1,125 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * a minimal stand-in for the Teensyduino core so the TELEX classes
+ * can be compiled and exercised on a desktop machine
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <type_traits>
+
+// code placement is meaningless off the Teensy
+#define FASTRUN
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+// Teensy 3.x analog pin numbers (used by the TELEXi)
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define A8 22
+#define A9 23
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// same semantics as the Arduino macro (including the mixed-type promotion)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+template <class A, class B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+
+template <class A, class B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// time (driven by the host simulation - see HostHal.h)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// pins
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+int analogRead(uint8_t pin);
+void analogReadResolution(unsigned int bits);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+
+// random numbers (deterministic unless seeded)
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// interrupts are not simulated
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/*
+ * serial output is routed to stderr so it never mixes with tool output
+ */
+class HardwareSerial
+{
+  public:
+
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+
+    void print(const char *s);
+    void print(long value, int base = 10);
+    void println(const char *s = "");
+    void println(long value, int base = 10);
+    int printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+};
+
+extern HardwareSerial Serial;
+
+/*
+ * the host never fires timers on its own; tools call the callback directly
+ */
+class IntervalTimer
+{
+  public:
+
+    bool begin(void (*callback)(), unsigned int microseconds) {
+      _callback = callback;
+      _microseconds = microseconds;
+      return true;
+    }
+    void end() { _callback = NULL; }
+
+  private:
+
+    void (*_callback)() = NULL;
+    unsigned int _microseconds = 0;
+
+};
+
+#endif
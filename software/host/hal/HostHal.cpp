@@ -0,0 +1,305 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include <stdarg.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "i2c_t3.h"
+#include "HostHal.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+i2c_t3 Wire;
+
+/*
+ * Simulated Hardware State
+ */
+
+static uint32_t hostMicros = 0;
+static unsigned long hostRandom = 1;
+
+static uint8_t pinState[HOST_PINS];
+static int analogOut[HOST_PINS];
+static int analogIn[HOST_PINS];
+
+static uint8_t syncPin = HOST_DAC_SYNC_PIN;
+static bool recordDac = true;
+static unsigned long dacWordCount = 0;
+static std::vector<uint32_t> dacWords;
+
+static uint16_t dacBuffer[4];
+static uint16_t dacOutput[4];
+static unsigned long dacLatchCount = 0;
+
+static uint32_t frameWord = 0;
+static int frameBytes = 0;
+
+/*
+ * Arduino Core
+ */
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+uint32_t millis() {
+  return hostMicros / 1000;
+}
+
+uint32_t micros() {
+  return hostMicros;
+}
+
+void delay(uint32_t ms) {
+  hostMicros += ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+  hostMicros += us;
+}
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  // unconnected pins (the DAC's -1 pins arrive here as 255) are ignored like on the Teensy
+  if (pin >= HOST_PINS) return;
+  pinState[pin] = value;
+  HostHal::PinWritten(pin, value);
+}
+
+uint8_t digitalRead(uint8_t pin) {
+  return pin < HOST_PINS ? pinState[pin] : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin < HOST_PINS) analogOut[pin] = value;
+}
+
+int analogRead(uint8_t pin) {
+  return pin < HOST_PINS ? analogIn[pin] : 0;
+}
+
+void analogReadResolution(unsigned int) {
+}
+
+void shiftOut(uint8_t, uint8_t, uint8_t, uint8_t value) {
+  HostHal::SpiByte(value);
+}
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  // glibc-style LCG; deterministic so runs can be compared
+  hostRandom = hostRandom * 1103515245 + 12345;
+  return (long)((hostRandom >> 16) & 0x7FFFFFFF) % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) hostRandom = seed;
+}
+
+/*
+ * Serial
+ */
+
+void HardwareSerial::print(const char *s) {
+  fputs(s, stderr);
+}
+
+void HardwareSerial::print(long value, int base) {
+  if (base == 16)
+    fprintf(stderr, "%lx", value);
+  else
+    fprintf(stderr, "%ld", value);
+}
+
+void HardwareSerial::println(const char *s) {
+  fprintf(stderr, "%s\n", s);
+}
+
+void HardwareSerial::println(long value, int base) {
+  print(value, base);
+  fputs("\n", stderr);
+}
+
+int HardwareSerial::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int ret = vfprintf(stderr, format, args);
+  va_end(args);
+  return ret;
+}
+
+/*
+ * SPI
+ */
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  HostHal::SpiByte(data);
+  return 0;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+  HostHal::SpiByte(data >> 8);
+  HostHal::SpiByte(data & 0xFF);
+  return 0;
+}
+
+/*
+ * i2c (slave side)
+ */
+
+int i2c_t3::available() {
+  return _rxLength - _rxPosition;
+}
+
+int i2c_t3::read() {
+  return _rxPosition < _rxLength ? _rxBuffer[_rxPosition++] : -1;
+}
+
+size_t i2c_t3::write(uint8_t data) {
+  if (_txLength >= I2C_BUFFER_LENGTH) return 0;
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+void i2c_t3::Receive(const uint8_t *data, size_t len) {
+  len = min(len, (size_t)I2C_BUFFER_LENGTH);
+  memcpy(_rxBuffer, data, len);
+  _rxLength = len;
+  _rxPosition = 0;
+  if (_receive) _receive(len);
+}
+
+size_t i2c_t3::Request(uint8_t *data, size_t len) {
+  _txLength = 0;
+  if (_request) _request();
+  len = min(len, _txLength);
+  memcpy(data, _txBuffer, len);
+  return len;
+}
+
+/*
+ * Host Controls
+ */
+
+void HostHal::SetMicros(uint32_t us) {
+  hostMicros = us;
+}
+
+void HostHal::AdvanceMicros(uint32_t us) {
+  hostMicros += us;
+}
+
+uint8_t HostHal::GetPin(uint8_t pin) {
+  return digitalRead(pin);
+}
+
+int HostHal::GetAnalogOut(uint8_t pin) {
+  return pin < HOST_PINS ? analogOut[pin] : 0;
+}
+
+void HostHal::SetAnalogIn(uint8_t pin, int value) {
+  if (pin < HOST_PINS) analogIn[pin] = value;
+}
+
+void HostHal::SetSyncPin(uint8_t pin) {
+  syncPin = pin;
+}
+
+void HostHal::RecordDac(bool record) {
+  recordDac = record;
+}
+
+void HostHal::ClearDac() {
+  dacWords.clear();
+  dacWordCount = 0;
+  dacLatchCount = 0;
+}
+
+unsigned long HostHal::DacWordCount() {
+  return dacWordCount;
+}
+
+const std::vector<uint32_t>& HostHal::DacWords() {
+  return dacWords;
+}
+
+/*
+ * splits a word using the DAC7565 layout (see DAC7565.h):
+ * LD1..LD0 at bits 21-20, DACSEL1..DACSEL0 at bits 18-17, data in the low 16 bits
+ */
+DacWrite HostHal::DecodeDacWord(uint32_t word) {
+  DacWrite decoded;
+  decoded.Load = (word >> 20) & 3;
+  decoded.Channel = decoded.Load == 3 ? 5 : ((word >> 17) & 3) + 1;
+  decoded.Value = word & 0xFFFF;
+  return decoded;
+}
+
+uint16_t HostHal::DacBuffer(uint8_t channel) {
+  return channel >= 1 && channel <= 4 ? dacBuffer[channel - 1] : 0;
+}
+
+uint16_t HostHal::DacOutput(uint8_t channel) {
+  return channel >= 1 && channel <= 4 ? dacOutput[channel - 1] : 0;
+}
+
+unsigned long HostHal::DacLatchCount() {
+  return dacLatchCount;
+}
+
+/*
+ * applies a word to the simulated registers: store (LD 0), single channel
+ * update (LD 1), simultaneous update of every channel (LD 2) or broadcast (LD 3);
+ * power-down and reference words (PD0 set) leave the data registers alone
+ */
+static void ApplyDacWord(uint32_t word) {
+  if (word & 0x010000) return;
+  DacWrite decoded = HostHal::DecodeDacWord(word);
+  if (decoded.Load == 3) {
+    for (int c = 0; c < 4; c++)
+      dacBuffer[c] = dacOutput[c] = decoded.Value;
+  } else {
+    dacBuffer[decoded.Channel - 1] = decoded.Value;
+    if (decoded.Load == 1)
+      dacOutput[decoded.Channel - 1] = decoded.Value;
+    else if (decoded.Load == 2)
+      for (int c = 0; c < 4; c++)
+        dacOutput[c] = dacBuffer[c];
+  }
+  if (decoded.Load) dacLatchCount++;
+}
+
+/*
+ * shifts one byte into the open frame; every 24 bits make a DAC word
+ */
+void HostHal::SpiByte(uint8_t data) {
+  frameWord = (frameWord << 8) | data;
+  if (++frameBytes == 3) {
+    dacWordCount++;
+    ApplyDacWord(frameWord & 0xFFFFFF);
+    if (recordDac) dacWords.push_back(frameWord & 0xFFFFFF);
+    frameWord = 0;
+    frameBytes = 0;
+  }
+}
+
+/*
+ * the falling edge of SYNC starts a new frame (dropping any partial word)
+ */
+void HostHal::PinWritten(uint8_t pin, uint8_t value) {
+  if (pin == syncPin && value == LOW) {
+    frameWord = 0;
+    frameBytes = 0;
+  }
+}
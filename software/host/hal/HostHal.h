@@ -0,0 +1,63 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef HostHal_h
+#define HostHal_h
+
+#include <vector>
+
+#include "Arduino.h"
+
+// the TELEXo wires the DAC7565 SYNC line to pin 10
+#define HOST_DAC_SYNC_PIN 10
+#define HOST_PINS 64
+
+/*
+ * a decoded 24-bit DAC7565 word
+ */
+struct DacWrite {
+  uint8_t Channel;
+  uint8_t Load;
+  uint16_t Value;
+};
+
+/*
+ * controls the simulated hardware behind the Arduino stand-ins
+ */
+class HostHal
+{
+  public:
+
+    // simulated clock
+    static void SetMicros(uint32_t us);
+    static void AdvanceMicros(uint32_t us);
+
+    // pin state as last written by the firmware
+    static uint8_t GetPin(uint8_t pin);
+    static int GetAnalogOut(uint8_t pin);
+    static void SetAnalogIn(uint8_t pin, int value);
+
+    // DAC capture - every SYNC-framed 24-bit word sent over SPI
+    static void SetSyncPin(uint8_t pin);
+    static void RecordDac(bool record);
+    static void ClearDac();
+    static unsigned long DacWordCount();
+    static const std::vector<uint32_t>& DacWords();
+    static DacWrite DecodeDacWord(uint32_t word);
+
+    // DAC registers as the DAC7565 would hold them after the captured words
+    // (channel: DAC_CHANNEL_A to DAC_CHANNEL_D)
+    static uint16_t DacBuffer(uint8_t channel);
+    static uint16_t DacOutput(uint8_t channel);
+    static unsigned long DacLatchCount();
+
+    // called by the SPI and pin stand-ins
+    static void SpiByte(uint8_t data);
+    static void PinWritten(uint8_t pin, uint8_t value);
+
+};
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#include "ResponsiveAnalogRead.h"
+
+ResponsiveAnalogRead::ResponsiveAnalogRead(int, bool sleepEnable, float snapMultiplier) {
+  this->sleepEnable = sleepEnable;
+  setSnapMultiplier(snapMultiplier);
+}
+
+void ResponsiveAnalogRead::update(int rawValueRead) {
+  rawValue = rawValueRead;
+  responsiveValue = getResponsiveValue(rawValue);
+}
+
+int ResponsiveAnalogRead::getResponsiveValue(int newValue) {
+
+  // near an edge, drag the value towards it (easier to reach and to wake from)
+  if (sleepEnable && edgeSnapEnable) {
+    if (newValue < activityThreshold)
+      newValue = (newValue * 2) - activityThreshold;
+    else if (newValue > analogResolution - activityThreshold)
+      newValue = (newValue * 2) - analogResolution + activityThreshold;
+  }
+
+  unsigned int diff = abs(newValue - smoothValue);
+
+  // the margin of error, as its own moving average
+  errorEMA += ((newValue - smoothValue) - errorEMA) * 0.4;
+
+  if (sleepEnable) {
+    sleeping = fabs(errorEMA) < activityThreshold;
+    if (sleeping) return (int)smoothValue;
+  }
+
+  float snap = snapCurve(diff * snapMultiplier);
+  smoothValue += (newValue - smoothValue) * snap;
+
+  if (smoothValue < 0.0)
+    smoothValue = 0.0;
+  else if (smoothValue > analogResolution - 1)
+    smoothValue = analogResolution - 1;
+
+  return (int)smoothValue;
+
+}
+
+float ResponsiveAnalogRead::snapCurve(float x) {
+  float y = 1.0 / (x + 1.0);
+  y = (1.0 - y) * 2.0;
+  if (y > 1.0) return 1.0;
+  return y;
+}
+
+void ResponsiveAnalogRead::setSnapMultiplier(float newMultiplier) {
+  if (newMultiplier > 1.0) newMultiplier = 1.0;
+  if (newMultiplier < 0.0) newMultiplier = 0.0;
+  snapMultiplier = newMultiplier;
+}
@@ -0,0 +1,49 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef ResponsiveAnalogRead_h
+#define ResponsiveAnalogRead_h
+
+#include "Arduino.h"
+
+/*
+ * the smoothing of the ResponsiveAnalogRead library (1.2) the TXi inputs
+ * used to run through: an exponential average whose rate follows a snap
+ * curve of the distance to the input, with sleep and edge snapping; only
+ * what the old AnalogReader called, for comparing against it
+ */
+class ResponsiveAnalogRead
+{
+  public:
+
+    ResponsiveAnalogRead(int pin, bool sleepEnable, float snapMultiplier = 0.01);
+
+    int getValue() { return responsiveValue; }
+    void update(int rawValueRead);
+    void setSnapMultiplier(float newMultiplier);
+    void setAnalogResolution(int resolution) { analogResolution = resolution; }
+
+  private:
+
+    int getResponsiveValue(int newValue);
+    float snapCurve(float x);
+
+    int analogResolution = 1024;
+    float snapMultiplier;
+    bool sleepEnable;
+    float activityThreshold = 4.0;
+    bool edgeSnapEnable = true;
+
+    float smoothValue = 0;
+    float errorEMA = 0.0;
+    bool sleeping = false;
+
+    int rawValue = 0;
+    int responsiveValue = 0;
+
+};
+
+#endif
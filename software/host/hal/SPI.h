@@ -0,0 +1,34 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef SPI_h
+#define SPI_h
+
+#include "Arduino.h"
+
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV4 0x00
+
+/*
+ * bytes transferred here are framed by the DAC sync pin and recorded by HostHal
+ */
+class SPIClass
+{
+  public:
+
+    void begin() {}
+    void end() {}
+    void setBitOrder(uint8_t) {}
+    void setClockDivider(uint8_t) {}
+
+    uint8_t transfer(uint8_t data);
+    uint16_t transfer16(uint16_t data);
+
+};
+
+extern SPIClass SPI;
+
+#endif
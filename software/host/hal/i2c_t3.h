@@ -0,0 +1,63 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ */
+
+#ifndef i2c_t3_h
+#define i2c_t3_h
+
+#include "Arduino.h"
+
+#define I2C_MASTER 0
+#define I2C_SLAVE 1
+
+#define I2C_PINS_18_19 0
+
+#define I2C_PULLUP_EXT 0
+#define I2C_PULLUP_INT 1
+
+#define I2C_RATE_100 0
+#define I2C_RATE_400 1
+#define I2C_RATE_2400 2
+
+#define I2C_BUFFER_LENGTH 259
+
+/*
+ * a slave-side model of the Teensy i2c_t3 library
+ * the host plays the bus master with Receive() and Request()
+ */
+class i2c_t3
+{
+  public:
+
+    void begin(uint8_t, uint8_t, uint8_t, uint8_t, uint32_t) {}
+    void onReceive(void (*function)(size_t len)) { _receive = function; }
+    void onRequest(void (*function)()) { _request = function; }
+
+    int available();
+    int read();
+    size_t write(uint8_t data);
+
+    // host side: deliver a master write and fire the receive callback
+    void Receive(const uint8_t *data, size_t len);
+    // host side: fire the request callback and collect what the slave wrote
+    size_t Request(uint8_t *data, size_t len);
+
+  private:
+
+    void (*_receive)(size_t len) = NULL;
+    void (*_request)() = NULL;
+
+    uint8_t _rxBuffer[I2C_BUFFER_LENGTH];
+    size_t _rxLength = 0;
+    size_t _rxPosition = 0;
+
+    uint8_t _txBuffer[I2C_BUFFER_LENGTH];
+    size_t _txLength = 0;
+
+};
+
+extern i2c_t3 Wire;
+
+#endif
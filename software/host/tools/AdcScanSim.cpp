@@ -0,0 +1,240 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * runs the TXi's ADC scanner against two simulated DMA-fed ADCs sweeping
+ * the inputs' channels (as TELEXi.ino assigns them) on slow sine waves
+ * with noise, collecting on the read timer:
+ *   - every pass must average exactly the samples each input got since
+ *     the last one (or, when it comes too late for the ring, the newest
+ *     the ring still holds, counted as an overrun)
+ * and reports each input's sample rate, the noise left on a pass's value
+ * against a single blocking analogRead, and the time the read timer spent
+ * waiting on the eight blocking reads against the time collecting takes
+ * results are written as JSON
+ *
+ * usage: adc_scan_sim [--seconds N] [--conversion-us US] [--out FILE]
+ *   --seconds        simulated time per scenario (default: 10)
+ *   --conversion-us  one conversion, 16-bit with the core's 4x averaging (default: 12)
+ *   --out            write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a pass averages the wrong samples or an overrun
+ * goes uncounted
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AdcScanner.h"
+#include "AdcSim.h"
+#include "AnalogReader.h"
+#include "JsonWriter.h"
+
+typedef std::chrono::steady_clock SimClock;
+
+// the 16-bit results down to analogRead's 13 bits
+#define ADCSHIFT READSHIFT
+// noise on each conversion (16-bit units, so +-8 in analogRead's)
+#define NOISE 64
+
+// the inputs' ADC channels as TELEXi.ino has them
+static const AdcSlot slots[ADCINPUTS] = { { 0, 6 }, { 0, 7 }, { 0, 15 }, { 0, 4 }, { 0, 14 }, { 1, 9 }, { 0, 5 }, { 1, 8 } };
+
+/*
+ * the read timer's period, and how often (and how far) a pass comes late
+ */
+struct Scenario {
+  const char *Name;
+  double PeriodUs;
+  int LateEvery;
+  double LateUs;
+};
+
+static const Scenario scenarios[] = {
+  { "1 kHz read timer", 1000, 0, 0 },
+  { "4 kHz read timer", 250, 0, 0 },
+  { "late passes", 1000, 100, 3000 },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct Summary {
+  long Passes;
+  long Mismatches;
+  long Overruns;
+  long ExpectedOverruns;
+  double MinRate;
+  double MaxRate;
+  double SingleNoise;
+  double ScannedNoise;
+  double CollectNs;
+};
+
+/*
+ * a slow sine of its own on each channel
+ */
+static double Signal(uint8_t adc, uint8_t channel, double us) {
+  double hz = 0.5 + channel * 0.25 + adc * 0.1;
+  return 32768 + 24000 * sin(2 * M_PI * hz * us / 1000000.);
+}
+
+static Summary Run(const Scenario& s, double seconds, double conversionUs) {
+
+  Summary summary;
+  memset(&summary, 0, sizeof(summary));
+
+  AdcSim adc(conversionUs, Signal, NOISE);
+  AdcScanner *scanner = new AdcScanner(&adc);
+  scanner->Begin(slots, ADCINPUTS);
+
+  // the inputs in each ADC's sweep, and the samples taken so far
+  int inputs[ADCCOUNT][ADCINPUTS];
+  int count[ADCCOUNT] = { 0 };
+  for (int i = 0; i < ADCINPUTS; i++)
+    inputs[slots[i].Adc][count[slots[i].Adc]++] = i;
+  size_t read[ADCCOUNT] = { 0 };
+  long samples[ADCINPUTS] = { 0 };
+
+  double singleSquares = 0, scannedSquares = 0;
+  long noiseCount = 0;
+  double collectNs = 0;
+  double us = 0;
+
+  while (us < seconds * 1000000.) {
+    us += s.PeriodUs;
+    if (s.LateEvery && (summary.Passes + 1) % s.LateEvery == 0) us += s.LateUs;
+
+    adc.Advance(us);
+    unsigned long overruns = scanner->Overruns();
+    SimClock::time_point start = SimClock::now();
+    scanner->Collect();
+    collectNs += std::chrono::duration<double, std::nano>(SimClock::now() - start).count();
+    summary.Passes++;
+
+    // what the pass should have averaged
+    double sum[ADCINPUTS] = { 0 }, clean[ADCINPUTS] = { 0 };
+    int n[ADCINPUTS] = { 0 };
+    uint16_t last[ADCINPUTS] = { 0 };
+    double lastClean[ADCINPUTS] = { 0 };
+    for (int a = 0; a < ADCCOUNT; a++) {
+      if (!count[a]) continue;
+      size_t written = adc.Samples(a).size();
+      // the newest the ring holds, less the sweep being written over
+      size_t keep = ADCRINGSIZE / count[a] * count[a] - count[a];
+      if (written - read[a] > keep) {
+        summary.ExpectedOverruns++;
+        read[a] = written - keep;
+      }
+      for (; read[a] < written; read[a]++) {
+        int input = inputs[a][read[a] % count[a]];
+        sum[input] += adc.Samples(a)[read[a]];
+        clean[input] += adc.Clean(a)[read[a]];
+        last[input] = adc.Samples(a)[read[a]];
+        lastClean[input] = adc.Clean(a)[read[a]];
+        n[input]++;
+      }
+    }
+    summary.Overruns += (long)(scanner->Overruns() - overruns);
+
+    for (int i = 0; i < ADCINPUTS; i++) {
+      if (!n[i]) continue;
+      long expected = ((long)sum[i] + n[i] / 2) / n[i];
+      if (scanner->Value(i) != expected || scanner->Samples(i) != n[i]) summary.Mismatches++;
+      samples[i] += n[i];
+
+      // in analogRead units: the pass's value, and one blocking read at the end of it
+      double scanned = (scanner->Value(i) >> ADCSHIFT) - clean[i] / n[i] / (1 << ADCSHIFT);
+      double single = (last[i] >> ADCSHIFT) - lastClean[i] / (1 << ADCSHIFT);
+      scannedSquares += scanned * scanned;
+      singleSquares += single * single;
+      noiseCount++;
+    }
+  }
+
+  for (int i = 0; i < ADCINPUTS; i++) {
+    double rate = samples[i] / (us / 1000000.);
+    if (i == 0 || rate < summary.MinRate) summary.MinRate = rate;
+    if (rate > summary.MaxRate) summary.MaxRate = rate;
+  }
+  summary.SingleNoise = sqrt(singleSquares / noiseCount);
+  summary.ScannedNoise = sqrt(scannedSquares / noiseCount);
+  summary.CollectNs = collectNs / summary.Passes;
+
+  delete scanner;
+  return summary;
+}
+
+int main(int argc, char *argv[]) {
+
+  double seconds = 10;
+  double conversionUs = 12;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--seconds") && a + 1 < argc)
+      seconds = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--conversion-us") && a + 1 < argc)
+      conversionUs = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--seconds N] [--conversion-us US] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (seconds < 0.1) seconds = 0.1;
+  if (conversionUs < 1) conversionUs = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("seconds", seconds);
+  json.Field("conversion_us", conversionUs);
+  json.Field("ring_samples", (long)ADCRINGSIZE);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    Summary summary = Run(scenarios[s], seconds, conversionUs);
+    if (summary.Mismatches || summary.Overruns != summary.ExpectedOverruns ||
+        (!scenarios[s].LateEvery && summary.Overruns))
+      pass = false;
+
+    // the eight blocking analogRead calls each pass used to wait out
+    double blockingUs = ADCINPUTS * conversionUs;
+
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.Field("period_us", scenarios[s].PeriodUs);
+    json.Field("passes", summary.Passes);
+    json.Field("mismatches", summary.Mismatches);
+    json.Field("overruns", summary.Overruns);
+    json.Field("expected_overruns", summary.ExpectedOverruns);
+    json.Field("min_samples_per_second", summary.MinRate);
+    json.Field("max_samples_per_second", summary.MaxRate);
+    json.Field("single_read_noise_rms", summary.SingleNoise);
+    json.Field("scanned_noise_rms", summary.ScannedNoise);
+    json.Field("blocking_reads_us", blockingUs);
+    json.Field("blocking_reads_cpu", blockingUs / scenarios[s].PeriodUs);
+    json.Field("collect_ns_host", summary.CollectNs);
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * measures the aliasing of a wavetable oscillator reading the tables as
+ * stored and reading their band-limited levels; each note is tuned to an odd
+ * number of cycles in FFTSIZE samples, so the folded harmonics land between
+ * the real ones, and everything off the harmonic bins is reported in dB
+ * against a full scale sine
+ *
+ * usage: alias_check [--ceiling DBFS]
+ *   --ceiling  the most aliasing any note may have reading the band-limited
+ *              levels (default: -30 dBFS)
+ *
+ * a note also fails if the levels make it more than WORSEDB worse than
+ * reading the table as stored (a small level's linear interpolation images
+ * can outweigh the little aliasing a darker table had), unless it stays under
+ * FLOOR, or if they lose more than LOSSDB of the harmonics between BANDLOW and
+ * BANDHIGH; levels an octave apart can only promise the harmonics below half
+ * of Nyquist, so the band stops there when that is lower
+ */
+
+#include <complex>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "defines.h"
+#include "Oscillator.h"
+
+#define FFTBITS 16
+#define FFTSIZE (1 << FFTBITS)
+// the aliasing a note may gain over the table as stored
+#define WORSEDB 3.
+// aliasing below this (dB full scale) is left to the DAC's own noise
+#define FLOOR -80.
+// the band whose harmonics should survive the levels (Hz), and what they may lose of it
+#define BANDLOW 3000.
+#define BANDHIGH 10000.
+#define LOSSDB 3.
+
+typedef std::complex<double> Complex;
+
+// bright tables present in every build (the sine should not change)
+static const int tables[] = { 0, 4, 5, 12, 21, 28, 40, 63 };
+#define TABLECOUNT (sizeof(tables) / sizeof(tables[0]))
+
+static const int notes[] = { 55, 110, 220, 440, 880, 1760, 3520, 5000 };
+#define NOTECOUNT (sizeof(notes) / sizeof(notes[0]))
+
+/*
+ * in-place radix-2 FFT
+ */
+static void Fft(std::vector<Complex>& x) {
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t length = 2; length <= n; length <<= 1) {
+    Complex w(cos(-2 * M_PI / length), sin(-2 * M_PI / length));
+    for (size_t i = 0; i < n; i += length) {
+      Complex wn(1, 0);
+      for (size_t k = 0; k < length / 2; k++) {
+        Complex u = x[i + k];
+        Complex v = x[i + k + length / 2] * wn;
+        x[i + k] = u + v;
+        x[i + k + length / 2] = u - v;
+        wn *= w;
+      }
+    }
+  }
+}
+
+/*
+ * the energy off the harmonics, in dB against a full scale sine, and the
+ * energy of the harmonics between BANDLOW and BANDHIGH
+ */
+static double Aliasing(int table, int cycles, bool bandLimit, double& band) {
+
+  Oscillator osc;
+  std::vector<int16_t> samples(FFTSIZE);
+  std::vector<Complex> bins(FFTSIZE);
+
+  Oscillator::SetBandLimit(bandLimit);
+  osc.SetWaveform(table * MORPHRANGE);
+  // a whole number of cycles in FFTSIZE samples: the step is exactly cycles << (32 - FFTBITS)
+  osc.SetFloatFrequency((float)cycles * SAMPLINGRATE / FFTSIZE);
+  osc.ResetPhase(0);
+  osc.Render(&samples[0], FFTSIZE);
+
+  for (size_t i = 0; i < FFTSIZE; i++)
+    bins[i] = samples[i];
+  Fft(bins);
+
+  double alias = 0;
+  double high = SAMPLINGRATEDIV2 / 2 < BANDHIGH ? SAMPLINGRATEDIV2 / 2 : BANDHIGH;
+  band = 0;
+  for (int b = 1; b <= FFTSIZE / 2; b++) {
+    double hz = (double)b * SAMPLINGRATE / FFTSIZE;
+    if (b % cycles)
+      alias += std::norm(bins[b]);
+    else if (hz >= BANDLOW && hz <= high)
+      band += std::norm(bins[b]);
+  }
+
+  double fullScale = 32767. * FFTSIZE / 2;
+  return alias > 0 ? 10 * log10(alias / (fullScale * fullScale)) : -200;
+}
+
+int main(int argc, char *argv[]) {
+
+  double ceiling = -30;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--ceiling") && a + 1 < argc)
+      ceiling = strtod(argv[++a], NULL);
+    else {
+      fprintf(stderr, "usage: %s [--ceiling DBFS]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  bool pass = true;
+  double worstStored = -200;
+  double worstLimited = -200;
+
+  printf("%-6s %6s %12s %12s %8s %8s\n", "table", "Hz", "as stored", "band-limited", "gain", "in band");
+
+  for (size_t t = 0; t < TABLECOUNT; t++) {
+    if (tables[t] >= Oscillator::GetWaveformCount()) continue;
+    for (size_t n = 0; n < NOTECOUNT; n++) {
+      if (notes[n] >= SAMPLINGRATEDIV2) continue;
+      // the nearest odd number of cycles
+      int cycles = (int)((double)notes[n] * FFTSIZE / SAMPLINGRATE) | 1;
+      double storedBand, limitedBand;
+      double stored = Aliasing(tables[t], cycles, false, storedBand);
+      double limited = Aliasing(tables[t], cycles, true, limitedBand);
+      double gain = stored - limited;
+      double loss = storedBand <= 0 ? 0 : limitedBand > 0 ? 10 * log10(limitedBand / storedBand) : -200;
+      bool ok = limited < ceiling && (limited < FLOOR || gain > -WORSEDB) && loss > -LOSSDB;
+      if (stored > worstStored) worstStored = stored;
+      if (limited > worstLimited) worstLimited = limited;
+      pass = pass && ok;
+      printf("%-6d %6.0f %6.1f dBFS %7.1f dBFS %5.1f dB %5.1f dB%s\n", tables[t], (double)cycles * SAMPLINGRATE / FFTSIZE,
+        stored, limited, gain, loss, ok ? "" : " - FAILED");
+    }
+  }
+
+  printf("worst note: %.1f dBFS as stored, %.1f dBFS band-limited (ceiling %.1f dBFS) - %s\n",
+    worstStored, worstLimited, ceiling, pass ? "ok" : "FAILED");
+
+  Oscillator::SetBandLimit(true);
+  return pass ? 0 : 1;
+}
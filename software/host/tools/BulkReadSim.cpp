@@ -0,0 +1,418 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * models a master scanning all eight TXi inputs over a 400 kHz i2c bus,
+ * through the receive and request callbacks wired as in TELEXi.ino, with
+ * the 1 kHz read timer running under the traffic:
+ *   single  - a one-byte select and a two-byte read per input
+ *   bulk    - a bulk select (TI_BULK) and one sixteen-byte read
+ *   armed   - the bulk select sent once, then only the reads
+ *   delta   - a delta select (TI_DELTA) sent once, then a one-byte read of
+ *             the inputs that changed and a read of just their values
+ * reports the transactions, bytes on the wire and bus time per scan, the
+ * scans a second one and eight modules allow, and how often a scan mixes
+ * values from different passes of the read timer; checks every value
+ * against the one the module held when it was read (a delta scan's copy
+ * within the threshold of it); then runs the delta reads with fewer of the
+ * inputs moving (the rest still, with a little noise), a scan on each pass
+ * of the read timer, against armed bulk reads at the same pace; and checks
+ * the selects past TI_DELTA_N (0x1E, 0x1F) read their input as usual
+ * results are written as JSON
+ *
+ * usage: bulk_read_sim [--scans N] [--out FILE]
+ *   --scans  scans per value set and mode (default: 1000)
+ *   --out    write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a value is misread, a bulk or delta scan mixes passes
+ * or a select past the delta ones starts a bulk or delta read
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "HostHal.h"
+#include "InputReport.h"
+#include "JsonWriter.h"
+#include "Quantizer.h"
+#include "TxHelper.h"
+#include "telex.h"
+
+// a byte (and its acknowledge) at 400 kHz, the start and stop around a
+// transaction, and the master's pause between transactions
+#define BYTEUS 22.5
+#define FRAMEUS 5
+#define PAUSEUS 15
+
+// the read timer (readTimer.begin(readInputs, 1000) in TELEXi.ino)
+#define READUS 1000
+
+// modules on the bus for the scan rates
+#define MAXMODULES 8
+
+#define MODE_SINGLE 0
+#define MODE_BULK 1
+#define MODE_ARMED 2
+#define MODE_DELTA 3
+
+static const char *modeNames[] = { "single", "bulk", "armed", "delta" };
+static const char *setNames[] = { "normal", "quantized", "note" };
+static const int bulkSelects[] = { TI_BULK, TI_BULK_QT, TI_BULK_N };
+static const int deltaSelects[] = { TI_DELTA, TI_DELTA_QT, TI_DELTA_N };
+
+// inputs moving in the delta runs, and the noise on the still ones
+static const int movingCounts[] = { 0, 1, 2, 4, 8 };
+#define MOVINGCOUNTS (sizeof(movingCounts) / sizeof(movingCounts[0]))
+#define NOISE 4
+
+/*
+ * the TXi as TELEXi.ino has it (less the commands)
+ */
+static volatile int inputValue[INPUTCOUNT];
+static volatile int quantizedValue[INPUTCOUNT];
+static volatile int quantizedNote[INPUTCOUNT];
+static Quantizer *quant[INPUTCOUNT];
+static byte activeInput = 0;
+static byte activeMode = 0;
+static bool activeBulk = false;
+static bool activeDelta = false;
+static InputReport report;
+
+// passes of the read timer so far, and the inputs moving
+static long pass = 0;
+static int moving = INPUTCOUNT;
+
+static uint32_t random32 = 1;
+
+static int Noise() {
+  random32 = random32 * 1664525 + 1013904223;
+  return (int)((random32 >> 8) % (2 * NOISE + 1)) - NOISE;
+}
+
+/*
+ * four knobs and four CV inputs moving at different rates (or held still)
+ */
+static void ReadInputs() {
+  pass++;
+  double t = pass * READUS / 1000000.;
+  for (int p = 0; p < INPUTCOUNT; p++) {
+    double wave = p < moving ? sin(2 * M_PI * (0.3 + p * 0.7) * t) : 0.5;
+    inputValue[p] = p < 4 ? (int)lround((wave + 1) * 8191.5) : (int)lround(wave * 16383);
+    if (p >= moving) inputValue[p] += Noise();
+    QuantizeResponse response = quant[p]->Quantize(inputValue[p]);
+    quantizedValue[p] = response.Value;
+    quantizedNote[p] = response.Note;
+  }
+}
+
+static const volatile int *ModeValues(byte mode) {
+  switch (mode) {
+    case 1:
+      return quantizedValue;
+    case 2:
+      return quantizedNote;
+    default:
+      return inputValue;
+  }
+}
+
+static void ReceiveEvent(size_t len) {
+  TxResponse response = TxHelper::Parse(len);
+  if (len == 1) {
+    TxIO io = TxHelper::DecodeIO(response.Command);
+    byte select = response.Command;
+    activeBulk = select >= TI_BULK && select <= TI_BULK_N;
+    activeDelta = select >= TI_DELTA && select <= TI_DELTA_N;
+    activeInput = activeBulk || activeDelta ? 0 : io.Port;
+    activeMode = activeDelta ? select - TI_DELTA : activeBulk ? select - TI_BULK : io.Mode;
+    if (activeDelta) report.ResetDelta();
+  }
+}
+
+static void RequestEvent() {
+  if (activeDelta) {
+    report.SendDelta(ModeValues(activeMode), activeMode);
+    return;
+  }
+  if (activeBulk) {
+    report.Snapshot(ModeValues(activeMode));
+    report.Send();
+    return;
+  }
+  noInterrupts();
+  int value = ModeValues(activeMode)[activeInput];
+  interrupts();
+  TxHelper::Send(value);
+}
+
+/*
+ * the bus: runs the read timer up to the end of each transaction
+ */
+struct Bus {
+  double Us;
+  double NextRead;
+  long Transactions;
+  long Bytes;
+
+  void Advance(size_t bytes) {
+    // the address byte goes first
+    Us += (bytes + 1) * BYTEUS + FRAMEUS;
+    Transactions++;
+    Bytes += bytes + 1;
+    RunTimer();
+  }
+
+  void Idle(double until) {
+    if (until > Us) Us = until;
+    RunTimer();
+  }
+
+  void RunTimer() {
+    while (NextRead <= Us) {
+      ReadInputs();
+      NextRead += READUS;
+    }
+  }
+
+  void Select(uint8_t select) {
+    Advance(1);
+    Wire.Receive(&select, 1);
+    Us += PAUSEUS;
+  }
+
+  size_t Read(uint8_t *data, size_t len) {
+    Advance(len);
+    size_t got = Wire.Request(data, len);
+    Us += PAUSEUS;
+    return got;
+  }
+};
+
+struct Summary {
+  double Transactions;
+  double Bytes;
+  double BusUs;
+  double ScansPerSecond;
+  double ScansPerSecondAll;
+  long Misread;
+  long Mixed;
+};
+
+static int Decode(const uint8_t *data) {
+  return (int16_t)((data[0] << 8) + data[1]);
+}
+
+/*
+ * scans back to back (a period of 0) or one every period, where the bus
+ * time is the time it is busy for each scan
+ */
+static Summary Run(int mode, int set, int scans, int movingInputs, double periodUs) {
+
+  Summary summary;
+  memset(&summary, 0, sizeof(summary));
+  Bus bus;
+  memset(&bus, 0, sizeof(bus));
+  // the master's copy of the values (delta reads)
+  int copy[INPUTCOUNT] = { 0 };
+
+  Wire.onReceive(ReceiveEvent);
+  Wire.onRequest(RequestEvent);
+  report = InputReport();
+  pass = 0;
+  moving = movingInputs;
+  random32 = 1;
+  ReadInputs();
+  bus.NextRead = READUS;
+
+  if (mode == MODE_ARMED) bus.Select(bulkSelects[set]);
+  if (mode == MODE_DELTA) bus.Select(deltaSelects[set]);
+  long transactions = bus.Transactions;
+  long bytes = bus.Bytes;
+  double start = bus.Us;
+  double busy = 0;
+
+  for (int s = 0; s < scans; s++) {
+    if (periodUs > 0) bus.Idle(start + s * periodUs);
+    double scanStart = bus.Us;
+
+    uint8_t data[INPUTCOUNT * 2];
+    long passes[INPUTCOUNT];
+    int expected[INPUTCOUNT];
+    int values[INPUTCOUNT];
+    // a delta scan's copy may sit within the threshold of the value held
+    int tolerance = 0;
+
+    if (mode == MODE_SINGLE) {
+      for (int i = 0; i < INPUTCOUNT; i++) {
+        bus.Select((set << 3) + i);
+        bus.Read(&data[i * 2], 2);
+        passes[i] = pass;
+        expected[i] = ModeValues(set)[i];
+        values[i] = Decode(&data[i * 2]);
+      }
+    } else if (mode == MODE_DELTA) {
+      uint8_t changes = 0;
+      bus.Read(&changes, 1);
+      for (int i = 0; i < INPUTCOUNT; i++) {
+        passes[i] = pass;
+        expected[i] = ModeValues(set)[i];
+      }
+      if (changes) {
+        int n = 0;
+        for (int i = 0; i < INPUTCOUNT; i++)
+          if (changes & (1 << i)) n++;
+        bus.Read(data, n * 2);
+        n = 0;
+        for (int i = 0; i < INPUTCOUNT; i++)
+          if (changes & (1 << i)) copy[i] = Decode(&data[n++ * 2]);
+      }
+      memcpy(values, copy, sizeof(values));
+      if (set == 0) tolerance = DELTATHRESHOLD;
+    } else {
+      if (mode == MODE_BULK) bus.Select(bulkSelects[set]);
+      bus.Read(data, sizeof(data));
+      for (int i = 0; i < INPUTCOUNT; i++) {
+        passes[i] = pass;
+        expected[i] = ModeValues(set)[i];
+        values[i] = Decode(&data[i * 2]);
+      }
+    }
+
+    long first = passes[0], last = passes[0];
+    for (int i = 0; i < INPUTCOUNT; i++) {
+      if (abs(values[i] - expected[i]) > tolerance) summary.Misread++;
+      if (passes[i] < first) first = passes[i];
+      if (passes[i] > last) last = passes[i];
+    }
+    if (last != first) summary.Mixed++;
+    busy += bus.Us - scanStart - PAUSEUS;
+  }
+
+  summary.Transactions = (double)(bus.Transactions - transactions) / scans;
+  summary.Bytes = (double)(bus.Bytes - bytes) / scans;
+  // the last pause is not part of the scan
+  summary.BusUs = periodUs > 0 ? busy / scans : (bus.Us - start - PAUSEUS) / scans;
+  summary.ScansPerSecond = 1000000. / summary.BusUs;
+  summary.ScansPerSecondAll = 1000000. / (summary.BusUs * MAXMODULES);
+  return summary;
+}
+
+/*
+ * the selects left in the bulk range read an input (the port) like any other
+ */
+static bool StraySelects() {
+  Bus bus;
+  memset(&bus, 0, sizeof(bus));
+  Wire.onReceive(ReceiveEvent);
+  Wire.onRequest(RequestEvent);
+  report = InputReport();
+  pass = 0;
+  moving = INPUTCOUNT;
+  ReadInputs();
+  bus.NextRead = 1e30;
+
+  for (int select = TI_DELTA_N + 1; select < TI_BULK + 8; select++) {
+    uint8_t data[2];
+    bus.Select(select);
+    if (activeBulk || activeDelta) return false;
+    if (bus.Read(data, 2) != 2 || Decode(data) != inputValue[select & 7]) return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+
+  int scans = 1000;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--scans") && a + 1 < argc)
+      scans = atoi(argv[++a]);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--scans N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (scans < 1) scans = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  for (int p = 0; p < INPUTCOUNT; p++)
+    quant[p] = new Quantizer(0);
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("scans", (long)scans);
+  json.Field("read_timer_us", (long)READUS);
+  json.BeginArray("value_sets");
+
+  for (int set = 0; set < 3; set++) {
+    json.BeginObject();
+    json.Field("name", setNames[set]);
+    json.BeginArray("modes");
+
+    for (int mode = MODE_SINGLE; mode <= MODE_DELTA; mode++) {
+      Summary summary = Run(mode, set, scans, INPUTCOUNT, 0);
+      if (summary.Misread || (mode != MODE_SINGLE && summary.Mixed)) pass = false;
+
+      json.BeginObject();
+      json.Field("mode", modeNames[mode]);
+      json.Field("transactions", summary.Transactions);
+      json.Field("bytes", summary.Bytes);
+      json.Field("bus_us", summary.BusUs);
+      json.Field("scans_per_second", summary.ScansPerSecond);
+      json.Field("scans_per_second_8_modules", summary.ScansPerSecondAll);
+      json.Field("mixed_pass_scans", summary.Mixed);
+      json.Field("misread", summary.Misread);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+  }
+
+  json.EndArray();
+
+  // the normal values with fewer inputs moving, delta reads against armed
+  // bulk ones, a scan on each pass of the read timer
+  json.BeginArray("delta_moving");
+  for (size_t m = 0; m < MOVINGCOUNTS; m++) {
+    Summary armed = Run(MODE_ARMED, 0, scans, movingCounts[m], READUS);
+    Summary delta = Run(MODE_DELTA, 0, scans, movingCounts[m], READUS);
+    if (armed.Misread || armed.Mixed || delta.Misread || delta.Mixed) pass = false;
+
+    json.BeginObject();
+    json.Field("moving", (long)movingCounts[m]);
+    json.Field("transactions", delta.Transactions);
+    json.Field("bytes", delta.Bytes);
+    json.Field("bus_us", delta.BusUs);
+    json.Field("armed_bus_us", armed.BusUs);
+    json.Field("bus_time_saved", 1 - delta.BusUs / armed.BusUs);
+    json.Field("misread", delta.Misread);
+    json.EndObject();
+  }
+  json.EndArray();
+
+  bool stray = StraySelects();
+  if (!stray) pass = false;
+  json.Field("stray_selects", stray);
+
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
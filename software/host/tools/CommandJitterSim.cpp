@@ -0,0 +1,348 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * simulates groups of i2c commands (chords across the CV outputs, gates,
+ * ratchets) arriving over the bus and measures when the CV and trigger
+ * onsets land, for three ways of sending and applying them:
+ *   direct     - a write per command, applied in the receive callback
+ *                (before the command queue)
+ *   scheduled  - a write per command, applied on the sample
+ *                TxQueue::Stamp() assigns
+ *   framed     - one TO_FRAME write per group, stamped and published whole
+ * results are written as JSON
+ *
+ * usage: command_jitter_sim [--groups N] [--sender-jitter-us US] [--out FILE]
+ *   --groups            command groups per scenario (default: 400)
+ *   --sender-jitter-us  random delay before each group is sent (default: 50)
+ *   --out               write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a stamped command lands later than the first tick
+ * after it arrives, or a framed group does not land on a single sample
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "TxQueue.h"
+#include "telex.h"
+
+#define TICKUS (1000000. / SAMPLINGRATE)
+
+// a byte (and its acknowledge) at 400 kHz, the start and stop around a
+// write, and the sender's longest pause between writes
+#define BYTEUS 22.5
+#define FRAMEUS 5
+#define MAXPAUSEUS 30
+
+#define MODE_DIRECT 0
+#define MODE_SCHEDULED 1
+#define MODE_FRAMED 2
+
+static const char *modeNames[] = { "direct", "scheduled", "framed" };
+
+struct Scenario {
+  const char *Name;
+  int Cvs;
+  int Gates;
+  double IntervalUs;
+};
+
+static const Scenario scenarios[] = {
+  { "chord", 4, 0, 20000 },
+  { "chord+gates", 4, 4, 20000 },
+  { "ratchet", 0, 1, 3000 },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/*
+ * a command as it arrives over the bus, `Run` being the commands from it to
+ * the end of its frame (zero for a write of its own)
+ */
+struct Arrival {
+  double Us;
+  int Group;
+  int Run;
+  TxResponse Response;
+};
+
+/*
+ * when each command of a group took effect, and how long after it arrived
+ */
+struct Onsets {
+  double Intended;
+  std::vector<double> Us;
+  std::vector<double> DelayUs;
+};
+
+struct Summary {
+  double MeanLatencyUs;
+  double JitterUs;
+  double DeviationUs;
+  double MeanSpreadUs;
+  double MaxSpreadUs;
+  double MaxDelayUs;
+};
+
+static uint32_t random32 = 1;
+
+static double Uniform(double range) {
+  random32 = random32 * 1664525 + 1013904223;
+  return (random32 >> 8) * range / 16777216.;
+}
+
+/*
+ * the bus traffic for a scenario: each group's CVs, then its gates, back to
+ * back in writes of their own or all at the end of one frame
+ */
+static std::vector<Arrival> Traffic(const Scenario& s, int groups, double senderJitterUs, bool framed, std::vector<Onsets>& onsets) {
+  std::vector<Arrival> traffic;
+  int commands = s.Cvs + s.Gates;
+  onsets.resize(groups);
+  random32 = 1;
+  for (int g = 0; g < groups; g++) {
+    double intended = (g + 1) * s.IntervalUs;
+    double us = intended + Uniform(senderJitterUs);
+    onsets[g].Intended = intended;
+    onsets[g].Us.clear();
+    onsets[g].DelayUs.clear();
+    // the address byte goes first (and the TO_FRAME byte)
+    if (framed) us += (4 * commands + 2) * BYTEUS + FRAMEUS;
+    for (int c = 0; c < commands; c++) {
+      Arrival a;
+      if (!framed) us += 5 * BYTEUS + FRAMEUS;
+      a.Us = us;
+      a.Group = g;
+      a.Run = framed ? commands - c : 0;
+      a.Response.Command = c < s.Cvs ? TO_CV_SET : TO_TR_PULSE;
+      a.Response.Output = c < s.Cvs ? c : c - s.Cvs;
+      // alternate the chords so every CV changes
+      a.Response.Value = (g & 1 ? 2000 : 6000) + c * 500;
+      a.Response.Sample = 0;
+      traffic.push_back(a);
+      if (!framed) us += Uniform(MAXPAUSEUS);
+    }
+  }
+  return traffic;
+}
+
+/*
+ * the two commands of actOnCommand() the scenarios use
+ */
+static void Apply(BenchRig& rig, const TxResponse& response) {
+  if (response.Command == TO_CV_SET)
+    rig.cv[response.Output]->SetValue(response.Value << 1);
+  else if (response.Command == TO_TR_PULSE)
+    rig.tr[response.Output]->Pulse();
+}
+
+/*
+ * the onset of traffic[a] at `us`
+ */
+static void Onset(std::vector<Onsets>& onsets, const std::vector<Arrival>& traffic, size_t a, double us) {
+  onsets[traffic[a].Group].Us.push_back(us);
+  onsets[traffic[a].Group].DelayUs.push_back(us - traffic[a].Us);
+}
+
+/*
+ * runs the traffic and records the onsets; onsets on an output belong to
+ * that output's commands in order (every command changes its output)
+ */
+static void Run(int mode, const std::vector<Arrival>& traffic, std::vector<Onsets>& onsets) {
+
+  BenchRig rig;
+  TxQueue queue;
+  for (int i = 0; i < 4; i++)
+    rig.tr[i]->SetTime(1, 0);
+
+  // the commands waiting for their onset on each output (CV, gate)
+  std::vector<size_t> pending[2][4];
+  for (size_t a = 0; a < traffic.size(); a++) {
+    const TxResponse& r = traffic[a].Response;
+    pending[r.Command == TO_TR_PULSE][r.Output].push_back(a);
+  }
+  size_t next[2][4] = { { 0 } };
+
+  // let the outputs settle on their power-on values first
+  for (int t = 0; t < 10; t++)
+    rig.Tick();
+
+  uint16_t dac[4];
+  uint8_t pin[4];
+  for (int o = 0; o < 4; o++) {
+    dac[o] = HostHal::DacOutput(dacOutputs[o]);
+    pin[o] = HostHal::GetPin(trPins[o]);
+  }
+
+  size_t a = 0;
+  double endUs = traffic.back().Us + 10000;
+  uint32_t sampleClock = 0;
+
+  for (double tickUs = 0; tickUs < endUs; tickUs += TICKUS) {
+
+    // the commands that arrived since the last tick
+    for (; a < traffic.size() && traffic[a].Us < tickUs; a++) {
+      TxResponse response = traffic[a].Response;
+      HostHal::SetMicros((uint32_t)traffic[a].Us);
+      if (mode == MODE_DIRECT) {
+        Apply(rig, response);
+      } else if (!traffic[a].Run) {
+        queue.Stamp(response, sampleClock);
+        queue.Push(response);
+      } else {
+        // the frame as receiveEvent() queues it
+        if (a == 0 || traffic[a - 1].Group != traffic[a].Group)
+          queue.Reserve(traffic[a].Run);
+        queue.Stamp(response, sampleClock);
+        queue.Push(response, traffic[a].Run);
+        if (traffic[a].Run == 1)
+          queue.Publish();
+      }
+      // a gate set directly goes high as the command arrives
+      for (int o = 0; o < 4; o++) {
+        uint8_t now = HostHal::GetPin(trPins[o]);
+        if (now && !pin[o] && next[1][o] < pending[1][o].size())
+          Onset(onsets, traffic, pending[1][o][next[1][o]++], traffic[a].Us);
+        pin[o] = now;
+      }
+    }
+
+    // the write ISR
+    HostHal::SetMicros((uint32_t)tickUs);
+    TxResponse command;
+    for (int c = 0; queue.Pop(command, sampleClock, c); c++)
+      Apply(rig, command);
+    rig.Tick();
+    sampleClock++;
+
+    for (int o = 0; o < 4; o++) {
+      uint16_t value = HostHal::DacOutput(dacOutputs[o]);
+      if (value != dac[o] && next[0][o] < pending[0][o].size())
+        Onset(onsets, traffic, pending[0][o][next[0][o]++], tickUs);
+      dac[o] = value;
+      uint8_t now = HostHal::GetPin(trPins[o]);
+      if (now && !pin[o] && next[1][o] < pending[1][o].size())
+        Onset(onsets, traffic, pending[1][o][next[1][o]++], tickUs);
+      pin[o] = now;
+    }
+  }
+}
+
+static Summary Summarize(const std::vector<Onsets>& onsets, int perGroup, bool *complete) {
+  Summary s;
+  double sum = 0, squares = 0, lo = 1e30, hi = -1e30, spread = 0, maxSpread = 0, maxDelay = 0;
+  long count = 0;
+  *complete = true;
+  for (size_t g = 0; g < onsets.size(); g++) {
+    const std::vector<double>& us = onsets[g].Us;
+    if ((int)us.size() != perGroup) {
+      *complete = false;
+      continue;
+    }
+    double first = 1e30, last = -1e30;
+    for (size_t k = 0; k < us.size(); k++) {
+      if (onsets[g].DelayUs[k] > maxDelay) maxDelay = onsets[g].DelayUs[k];
+      double latency = us[k] - onsets[g].Intended;
+      sum += latency;
+      squares += latency * latency;
+      if (latency < lo) lo = latency;
+      if (latency > hi) hi = latency;
+      if (us[k] < first) first = us[k];
+      if (us[k] > last) last = us[k];
+      count++;
+    }
+    spread += last - first;
+    if (last - first > maxSpread) maxSpread = last - first;
+  }
+  double mean = count ? sum / count : 0;
+  s.MeanLatencyUs = mean;
+  s.JitterUs = count ? hi - lo : 0;
+  s.DeviationUs = count ? sqrt(squares / count - mean * mean) : 0;
+  s.MeanSpreadUs = onsets.size() ? spread / onsets.size() : 0;
+  s.MaxSpreadUs = maxSpread;
+  s.MaxDelayUs = maxDelay;
+  return s;
+}
+
+int main(int argc, char *argv[]) {
+
+  int groups = 400;
+  double senderJitterUs = 50;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--groups") && a + 1 < argc)
+      groups = atoi(argv[++a]);
+    else if (!strcmp(argv[a], "--sender-jitter-us") && a + 1 < argc)
+      senderJitterUs = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--groups N] [--sender-jitter-us US] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (groups < 1) groups = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("tick_us", TICKUS);
+  json.Field("sender_jitter_us", senderJitterUs);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.Field("commands_per_group", (long)(scenarios[s].Cvs + scenarios[s].Gates));
+    json.BeginArray("modes");
+
+    for (int mode = MODE_DIRECT; mode <= MODE_FRAMED; mode++) {
+      std::vector<Onsets> onsets;
+      std::vector<Arrival> traffic = Traffic(scenarios[s], groups, senderJitterUs, mode == MODE_FRAMED, onsets);
+      Run(mode, traffic, onsets);
+
+      bool complete;
+      Summary summary = Summarize(onsets, scenarios[s].Cvs + scenarios[s].Gates, &complete);
+      if (!complete || summary.MaxDelayUs > TICKUS) pass = false;
+      if (mode == MODE_FRAMED && summary.MaxSpreadUs > 0) pass = false;
+
+      json.BeginObject();
+      json.Field("mode", modeNames[mode]);
+      json.Field("mean_latency_us", summary.MeanLatencyUs);
+      json.Field("latency_jitter_us", summary.JitterUs);
+      json.Field("latency_deviation_us", summary.DeviationUs);
+      json.Field("mean_spread_us", summary.MeanSpreadUs);
+      json.Field("max_spread_us", summary.MaxSpreadUs);
+      json.Field("max_delay_us", summary.MaxDelayUs);
+      json.Field("complete", complete);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * checks the 24-bit words DAC::writeFrame() sends for a set of staged frames,
+ * then runs the output section and checks that every tick sends at most one
+ * frame, stores the changed channels in order and latches them together
+ *
+ * usage: dac_frame_check [--ticks N]
+ *   --ticks  writeOutputs() passes checked on the output section (default: one second)
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+
+static const int frequencies[3] = { 110, 220, 440 };
+
+static int failures = 0;
+
+/*
+ * one staged frame and the words it must produce
+ */
+struct Frame {
+  const char *Name;
+  int Staged;
+  uint8_t Channels[6];
+  uint16_t Values[6];
+  int Expected;
+  uint32_t Words[4];
+};
+
+static const Frame frames[] = {
+  // staged D to A like writeOutputs() - sent A to D, D latches
+  { "all", 4, { DAC_CHANNEL_D, DAC_CHANNEL_C, DAC_CHANNEL_B, DAC_CHANNEL_A }, { 0x4444, 0x3333, 0x2222, 0x1111 },
+    4, { 0x001111, 0x022222, 0x043333, 0x264444 } },
+  { "single", 1, { DAC_CHANNEL_B }, { 0xBEEF },
+    1, { 0x22BEEF } },
+  { "sparse", 2, { DAC_CHANNEL_C, DAC_CHANNEL_A }, { 0xCCCC, 0x0A0A },
+    2, { 0x000A0A, 0x24CCCC } },
+  { "restaged", 3, { DAC_CHANNEL_A, DAC_CHANNEL_D, DAC_CHANNEL_A }, { 0x0001, 0xFFFF, 0x0002 },
+    2, { 0x000002, 0x26FFFF } },
+  { "empty", 0, { 0 }, { 0 },
+    0, { 0 } },
+  { "broadcast", 1, { DAC_CHANNEL_ALL }, { 0x8000 },
+    0, { 0 } },
+};
+#define FRAMECOUNT (sizeof(frames) / sizeof(frames[0]))
+
+static void Fail(const char *format, ...) {
+  va_list args;
+  if (failures++ < 20) {
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+  }
+}
+
+/*
+ * the staged frames against their exact words and the latched registers
+ */
+static void CheckFrames(DAC& dac) {
+
+  for (size_t f = 0; f < FRAMECOUNT; f++) {
+    const Frame& frame = frames[f];
+    HostHal::ClearDac();
+
+    for (int s = 0; s < frame.Staged; s++)
+      dac.stageChannel(frame.Channels[s], frame.Values[s]);
+    dac.writeFrame();
+
+    const std::vector<uint32_t>& words = HostHal::DacWords();
+    if ((int)words.size() != frame.Expected) {
+      Fail("%s: %d words, expected %d\n", frame.Name, (int)words.size(), frame.Expected);
+      continue;
+    }
+    for (int w = 0; w < frame.Expected; w++)
+      if (words[w] != frame.Words[w])
+        Fail("%s: word %d is %06x, expected %06x\n", frame.Name, w, words[w], frame.Words[w]);
+
+    if (HostHal::DacLatchCount() != (frame.Expected ? 1u : 0u))
+      Fail("%s: %lu latches, expected %d\n", frame.Name, HostHal::DacLatchCount(), frame.Expected ? 1 : 0);
+    for (uint8_t c = DAC_CHANNEL_A; c <= DAC_CHANNEL_D; c++)
+      if (HostHal::DacOutput(c) != HostHal::DacBuffer(c))
+        Fail("%s: channel %d outputs %04x, stored %04x\n", frame.Name, c, HostHal::DacOutput(c), HostHal::DacBuffer(c));
+
+    // a frame is sent once
+    HostHal::ClearDac();
+    dac.writeFrame();
+    if (HostHal::DacWordCount())
+      Fail("%s: %lu words resent\n", frame.Name, HostHal::DacWordCount());
+  }
+}
+
+/*
+ * every tick of the output section: changed channels stored in order, the last one latching
+ */
+static unsigned long CheckRig(unsigned long ticks, unsigned long *wordTotal) {
+
+  BenchRig rig;
+  HostHal::RecordDac(true);
+
+  for (int i = 0; i < 3; i++) {
+    rig.cv[i]->SetValue(16383);
+    rig.cv[i]->SetWaveform(i * MORPHRANGE);
+    rig.cv[i]->SetFrequency(frequencies[i]);
+  }
+  // the last output slews instead of oscillating
+  rig.cv[3]->SetSlew(10, 0);
+
+  uint16_t previous[4];
+  unsigned long frames = 0;
+  *wordTotal = 0;
+
+  for (unsigned long t = 0; t < ticks; t++) {
+    if (t % 300 == 0)
+      rig.cv[3]->TargetValue((t / 300) % 2 ? 4096 : 16383);
+
+    for (int c = 0; c < 4; c++)
+      previous[c] = HostHal::DacOutput(c + 1);
+    HostHal::ClearDac();
+    rig.Tick();
+
+    const std::vector<uint32_t>& words = HostHal::DacWords();
+    *wordTotal += words.size();
+    if (words.empty()) continue;
+    frames++;
+
+    if (words.size() > 4)
+      Fail("tick %lu: %d words, expected at most 4\n", t, (int)words.size());
+    int last = 0;
+    for (size_t w = 0; w < words.size(); w++) {
+      DacWrite decoded = HostHal::DecodeDacWord(words[w]);
+      uint8_t load = w + 1 == words.size() ? 2 : 0;
+      if (decoded.Load != load)
+        Fail("tick %lu: word %d loads %d, expected %d\n", t, (int)w, decoded.Load, load);
+      if (decoded.Channel <= last)
+        Fail("tick %lu: channel %d out of order after %d\n", t, decoded.Channel, last);
+      if (decoded.Value == previous[decoded.Channel - 1])
+        Fail("tick %lu: unchanged value %04x sent to channel %d\n", t, decoded.Value, decoded.Channel);
+      last = decoded.Channel;
+    }
+    if (HostHal::DacLatchCount() != 1)
+      Fail("tick %lu: %lu latches, expected 1\n", t, HostHal::DacLatchCount());
+    for (uint8_t c = DAC_CHANNEL_A; c <= DAC_CHANNEL_D; c++)
+      if (HostHal::DacOutput(c) != HostHal::DacBuffer(c))
+        Fail("tick %lu: channel %d outputs %04x, stored %04x\n", t, c, HostHal::DacOutput(c), HostHal::DacBuffer(c));
+  }
+
+  HostHal::RecordDac(false);
+  return frames;
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long ticks = SAMPLINGRATE;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--ticks") && a + 1 < argc)
+      ticks = strtoul(argv[++a], NULL, 10);
+    else {
+      fprintf(stderr, "usage: %s [--ticks N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  DAC dac(-1, 10, -1, 11, 13);
+  dac.init();
+  HostHal::RecordDac(true);
+
+  CheckFrames(dac);
+  int frameFailures = failures;
+  printf("%d frames: %d failures\n", (int)FRAMECOUNT, frameFailures);
+
+  unsigned long words;
+  unsigned long sent = CheckRig(ticks, &words);
+  printf("%lu ticks: %lu frames, %.2f words per frame, %d failures\n",
+    ticks, sent, sent ? (double)words / sent : 0., failures - frameFailures);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * runs the output section with its DAC frames going through DacQueue and a
+ * simulated DMA-fed SPI peripheral, at several SPI clocks; checks that the
+ * DAC receives exactly the words the blocking writes send and reports the
+ * CPU time the ISR no longer spends waiting on SPI; results are written as JSON
+ *
+ * usage: dac_queue_sim [--ticks N] [--spi-hz HZ] [--gap-ns NS] [--out FILE]
+ *   --ticks   writeOutputs() passes per run (default: one second)
+ *   --spi-hz  simulate only this SPI clock (default: 30 MHz down to 500 kHz)
+ *   --gap-ns  SYNC high time and FIFO overhead per word (default: 200)
+ *   --out     write the JSON to FILE instead of stdout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "DacQueue.h"
+#include "HostHal.h"
+#include "SpiSim.h"
+
+// SPI_CLOCK_DIV2 of the 60 MHz bus on the Teensy 3.6, then clocks too slow to keep up
+static const double clocks[] = { 30000000., 8000000., 2000000., 500000. };
+#define CLOCKCOUNT (sizeof(clocks) / sizeof(clocks[0]))
+
+static const int frequencies[4] = { 110, 220, 440, 880 };
+
+/*
+ * all four outputs oscillating so every tick sends a full frame
+ */
+static void Setup(BenchRig& rig) {
+  for (int i = 0; i < 4; i++) {
+    rig.cv[i]->SetValue(16383);
+    rig.cv[i]->SetWaveform(i * MORPHRANGE);
+    rig.cv[i]->SetFrequency(frequencies[i]);
+  }
+}
+
+/*
+ * the words the blocking writes send (and the running total after each tick)
+ */
+static void RunBlocking(unsigned long ticks, std::vector<uint32_t>& words, std::vector<unsigned long>& sent, unsigned long *latches) {
+  BenchRig rig;
+  Setup(rig);
+  HostHal::RecordDac(true);
+  HostHal::ClearDac();
+  sent.resize(ticks);
+  for (unsigned long t = 0; t < ticks; t++) {
+    rig.Tick();
+    sent[t] = HostHal::DacWordCount();
+  }
+  words = HostHal::DacWords();
+  *latches = HostHal::DacLatchCount();
+  HostHal::RecordDac(false);
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long ticks = SAMPLINGRATE;
+  double spiHz = 0;
+  double gapNs = 200;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--ticks") && a + 1 < argc)
+      ticks = strtoul(argv[++a], NULL, 10);
+    else if (!strcmp(argv[a], "--spi-hz") && a + 1 < argc)
+      spiHz = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--gap-ns") && a + 1 < argc)
+      gapNs = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--ticks N] [--spi-hz HZ] [--gap-ns NS] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (ticks == 0) ticks = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  std::vector<uint32_t> reference;
+  std::vector<unsigned long> sent;
+  unsigned long referenceLatches;
+  RunBlocking(ticks, reference, sent, &referenceLatches);
+
+  JsonWriter json(out);
+  bool identical = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("ticks", (long)ticks);
+  json.Field("words_per_tick", (double)reference.size() / ticks);
+  json.BeginArray("runs");
+
+  for (size_t c = 0; c < CLOCKCOUNT; c++) {
+    double clock = spiHz > 0 ? spiHz : clocks[c];
+
+    BenchRig rig;
+    SpiSim spi(clock, gapNs);
+    DacQueue queue(&spi);
+    Setup(rig);
+    rig.Dac().setQueue(&queue);
+    HostHal::RecordDac(true);
+    HostHal::ClearDac();
+
+    // words handed to the queue but not yet at the DAC when a tick starts
+    unsigned long backlog = 0;
+    for (unsigned long t = 0; t < ticks; t++) {
+      spi.Advance(SAMPLEPERIODNS);
+      unsigned long produced = t ? sent[t - 1] : 0;
+      if (produced > HostHal::DacWordCount() && produced - HostHal::DacWordCount() > backlog)
+        backlog = produced - HostHal::DacWordCount();
+      rig.Tick();
+    }
+    queue.Drain();
+
+    const std::vector<uint32_t>& words = HostHal::DacWords();
+    size_t mismatches = words.size() > reference.size() ? words.size() - reference.size() : reference.size() - words.size();
+    for (size_t k = 0; k < words.size() && k < reference.size(); k++)
+      if (words[k] != reference[k]) mismatches++;
+    bool match = !mismatches && HostHal::DacLatchCount() == referenceLatches;
+    if (!match) identical = false;
+    HostHal::RecordDac(false);
+
+    json.BeginObject();
+    json.Field("spi_hz", clock);
+    json.Field("word_ns", spi.WordNs());
+    json.Field("blocking_spi_ns_per_tick", reference.size() * spi.WordNs() / ticks);
+    json.Field("queued_wait_ns_per_tick", spi.WaitedNs() / ticks);
+    json.Field("overruns", (long)queue.Overruns());
+    json.Field("stalls", (long)queue.Stalls());
+    json.Field("max_backlog_words", (long)backlog);
+    json.Field("mismatches", (long)mismatches);
+    json.Field("identical", match);
+    json.EndObject();
+
+    if (spiHz > 0) break;
+  }
+
+  json.EndArray();
+  json.Field("identical", identical);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * checks the integer per-sample path against the double math it replaced:
+ *   - table interpolation (FixedPoint.h) against the double scaler
+ *   - amplitude scaling against value * (sample / 32768.)
+ *   - the DAC values the output section sends for a set of oscillator
+ *     scenarios against a reference recorded with the double math
+ * the first two report the largest error in LSB; any error over one fails
+ *
+ * usage: fixed_point_check [--write] FILE
+ *   --write  record the output section reference instead of checking against it
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BenchRig.h"
+#include "FixedPoint.h"
+#include "HostHal.h"
+
+// random interpolation cases on top of the edge cases
+#define RANDOMCASES 20000000
+// ticks rendered per output section scenario
+#define SCENARIOTICKS 25000
+// the largest error allowed against the double math
+#define MAXLSB 1
+
+static const int edgeSamples[] = { -32768, -32767, -32766, -16385, -16384, -2, -1, 0, 1, 2, 16383, 16384, 32766, 32767 };
+#define EDGESAMPLECOUNT (sizeof(edgeSamples) / sizeof(edgeSamples[0]))
+
+static const uint32_t edgeFractions[] = { 0, 1, 2, 255, 256, 511, 512, 513, 16383, 16384, 4194303, 4194304, 4194305, 8388606, PHASEMASK };
+#define EDGEFRACTIONCOUNT (sizeof(edgeFractions) / sizeof(edgeFractions[0]))
+
+// the scaler Oscillator used (volatile so the compiler keeps the double math)
+static volatile double phasescale = 1.0 / (1 << REDUCEBITS);
+
+static uint32_t random32 = 1;
+
+static uint32_t Random() {
+  random32 = random32 * 1664525 + 1013904223;
+  return random32;
+}
+
+struct Errors {
+  unsigned long Cases;
+  unsigned long Differ;
+  int Max;
+};
+
+static void Count(Errors& e, int value, int reference) {
+  int error = abs(value - reference);
+  e.Cases++;
+  if (error) e.Differ++;
+  if (error > e.Max) e.Max = error;
+}
+
+/*
+ * one interpolation through a two-sample table, against the double expression
+ */
+static void CheckLerp(Errors& e, int a, int b, uint32_t frac) {
+  int16_t table[2] = { (int16_t)a, (int16_t)b };
+  int reference = table[0] + frac * phasescale * (table[1] - table[0]);
+  Count(e, TableLerp(table, 0, frac), reference);
+}
+
+static Errors CheckInterpolation() {
+  Errors e = { 0, 0, 0 };
+  for (size_t a = 0; a < EDGESAMPLECOUNT; a++)
+    for (size_t b = 0; b < EDGESAMPLECOUNT; b++)
+      for (size_t f = 0; f < EDGEFRACTIONCOUNT; f++)
+        CheckLerp(e, edgeSamples[a], edgeSamples[b], edgeFractions[f]);
+  for (long c = 0; c < RANDOMCASES; c++) {
+    uint32_t r = Random();
+    CheckLerp(e, (int16_t)r, (int16_t)(r >> 16), Random() & PHASEMASK);
+  }
+  return e;
+}
+
+/*
+ * every CV value against every seventh sample value (and the edges)
+ */
+static Errors CheckScaling() {
+  Errors e = { 0, 0, 0 };
+  for (int value = -32768; value <= 32767; value++) {
+    for (int sample = -32768; sample <= 32767; sample += 7)
+      Count(e, ScaleQ15(value, sample), (int)(value * (sample / 32768.)));
+    for (size_t s = 0; s < EDGESAMPLECOUNT; s++)
+      Count(e, ScaleQ15(value, edgeSamples[s]), (int)(value * (edgeSamples[s] / 32768.)));
+  }
+  return e;
+}
+
+// stands in for the noise waveform (after the last table) plus any morph
+#define NOISEWAVE -1000
+
+/*
+ * output section scenarios (all four outputs oscillating)
+ */
+struct Scenario {
+  const char *Name;
+  int Waves[4];
+  int Frequencies[4];
+  int Rectify[4];
+  bool Log;
+};
+
+static const Scenario scenarios[] = {
+  { "sines", { 0, 0, 0, 0 }, { 110, 440, 1234, 5000 }, { 0, 0, 0, 0 }, false },
+  { "shapes", { 1 * MORPHRANGE, 2 * MORPHRANGE, 3 * MORPHRANGE, 3 * MORPHRANGE + 50 }, { 220, 440, 880, 3000 }, { 0, 0, 0, 0 }, false },
+  { "tables", { 4 * MORPHRANGE, 20 * MORPHRANGE, 40 * MORPHRANGE, 60 * MORPHRANGE }, { 37, 440, 2000, 9000 }, { 0, 0, 0, 0 }, false },
+  { "tables+morph", { 4 * MORPHRANGE + 25, 20 * MORPHRANGE + 50, 40 * MORPHRANGE + 75, 1 * MORPHRANGE + 50 }, { 55, 330, 1500, 7000 }, { 0, 0, 0, 0 }, false },
+  { "tables/rect", { 0, 4 * MORPHRANGE, 20 * MORPHRANGE + 50, 40 * MORPHRANGE }, { 110, 220, 440, 880 }, { -2, -1, 1, 2 }, false },
+  { "noise", { NOISEWAVE, NOISEWAVE + MORPHRANGE / 2, 0, 4 * MORPHRANGE }, { 500, 2000, 440, 440 }, { 0, 2, 0, 0 }, false },
+  { "log", { 0, 4 * MORPHRANGE, 2 * MORPHRANGE, 20 * MORPHRANGE + 50 }, { 2, 5, 110, 440 }, { 0, 0, 0, 1 }, true },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/*
+ * FNV-1a over the four DAC outputs after every tick; the amplitude, center,
+ * phase and frequency are moved part way through
+ */
+static uint32_t Hash(const Scenario& s) {
+
+  BenchRig rig;
+  uint32_t hash = 2166136261u;
+  int tables = Oscillator::GetWaveformCount();
+
+  // the reference was recorded with every output at audio rate, reading the
+  // tables as stored
+  CVOutput::SetMultirate(false);
+  Oscillator::SetBandLimit(false);
+  randomSeed(1);
+  for (int o = 0; o < 4; o++) {
+    CVOutput *cv = rig.cv[o];
+    cv->SetWaveform(s.Waves[o] < 0 ? tables * MORPHRANGE + s.Waves[o] - NOISEWAVE : s.Waves[o]);
+    cv->SetRectify(s.Rectify[o]);
+    cv->SetLog(s.Log ? o + 1 : 0);
+    cv->SetValue(16383 - o * 3000);
+    cv->SetCenter(o * 1500 - 2000);
+    cv->SetFrequency(s.Frequencies[o]);
+  }
+
+  for (int t = 0; t < SCENARIOTICKS; t++) {
+    if (t == SCENARIOTICKS / 4) {
+      rig.cv[0]->SetSlew(100, 0);
+      rig.cv[0]->TargetValue(4000);
+      rig.cv[1]->Sync();
+    } else if (t == SCENARIOTICKS / 2) {
+      rig.cv[2]->SetPhaseOffset(8000);
+      rig.cv[3]->SetFrequency(s.Frequencies[3] / 2 + 1);
+    }
+    rig.Tick();
+    for (uint8_t c = DAC_CHANNEL_A; c <= DAC_CHANNEL_D; c++) {
+      uint16_t value = HostHal::DacOutput(c);
+      hash ^= value & 0xff;
+      hash *= 16777619u;
+      hash ^= value >> 8;
+      hash *= 16777619u;
+    }
+  }
+
+  return hash;
+}
+
+static bool Report(const char *name, const Errors& e) {
+  bool pass = e.Max <= MAXLSB;
+  printf("%s: %lu cases, %lu differ, max error %d LSB - %s\n", name, e.Cases, e.Differ, e.Max, pass ? "ok" : "FAILED");
+  return pass;
+}
+
+int main(int argc, char *argv[]) {
+
+  bool write = false;
+  const char *path = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--write"))
+      write = true;
+    else if (!path)
+      path = argv[a];
+    else
+      path = NULL;
+  }
+
+  if (!path) {
+    fprintf(stderr, "usage: %s [--write] FILE\n", argv[0]);
+    return 2;
+  }
+
+  bool pass = Report("interpolation", CheckInterpolation());
+  pass = Report("scaling", CheckScaling()) && pass;
+
+  uint32_t hashes[SCENARIOCOUNT];
+  for (size_t s = 0; s < SCENARIOCOUNT; s++)
+    hashes[s] = Hash(scenarios[s]);
+
+  if (write) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+      perror(path);
+      return 2;
+    }
+    for (size_t s = 0; s < SCENARIOCOUNT; s++)
+      fprintf(out, "%s %08x\n", scenarios[s].Name, hashes[s]);
+    fclose(out);
+    printf("recorded %d scenarios\n", (int)SCENARIOCOUNT);
+    return pass ? 0 : 1;
+  }
+
+  FILE *in = fopen(path, "r");
+  if (!in) {
+    perror(path);
+    return 2;
+  }
+
+  char name[48];
+  unsigned int hash;
+  int checked = 0;
+  int matched = 0;
+  while (fscanf(in, "%47s %x", name, &hash) == 2) {
+    for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+      if (strcmp(name, scenarios[s].Name)) continue;
+      checked++;
+      if (hashes[s] == hash)
+        matched++;
+      else
+        printf("output section %s: %08x, recorded %08x\n", name, hashes[s], hash);
+    }
+  }
+  fclose(in);
+
+  printf("%d of %d recorded output section scenarios match\n", matched, checked);
+  return pass && checked && matched == checked ? 0 : 1;
+}
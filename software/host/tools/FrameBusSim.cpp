@@ -0,0 +1,377 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * models the i2c bus time of typical updates (chords, gates, sequencer
+ * steps) sent two ways, through the receive callback wired as in TELEXo.ino:
+ *   single  - a four-byte write per command (as the Teletype sends them)
+ *   framed  - TO_FRAME writes carrying the update's commands, as few as the
+ *             frame limit (TXQUEUEDRAIN commands) allows
+ * with the write ISR's ticks running under the bus, each applying the
+ * commands due as writeOutputs() does
+ * reports the transactions, bytes and bus time per update, the updates a
+ * second the bus can carry, and how many samples apart the ISR applies an
+ * update's commands and a frame's; checks the frames decode to the same
+ * commands in the same order
+ * results are written as JSON
+ *
+ * usage: frame_bus_sim [--updates N] [--out FILE]
+ *   --updates  updates sent per scenario (default: 1000)
+ *   --out      write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a frame decodes differently from its single writes,
+ * its commands are not applied on one tick, a cut-off frame is misread, a
+ * tick applies more than TXQUEUEDRAIN commands, or a frame that is too long
+ * or has no room in the queue is not dropped whole
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "TxQueue.h"
+#include "telex.h"
+
+#define TICKUS (1000000. / SAMPLINGRATE)
+
+// a byte (and its acknowledge) at 400 kHz, the start and stop around a
+// write, and the sender's pause between writes
+#define BYTEUS 22.5
+#define FRAMEUS 5
+#define PAUSEUS 15
+
+// the time between updates (apart, so each is a group of its own)
+#define UPDATEUS 20000
+
+#define MODE_SINGLE 0
+#define MODE_FRAMED 1
+
+static const char *modeNames[] = { "single", "framed" };
+
+/*
+ * the commands an update sends to each of the four outputs
+ */
+struct Scenario {
+  const char *Name;
+  int Commands[4];
+  int Outputs;
+};
+
+static const Scenario scenarios[] = {
+  { "gate", { TO_TR_PULSE }, 1 },
+  { "chord", { TO_CV }, 4 },
+  { "chord+gates", { TO_CV, TO_TR_PULSE }, 4 },
+  { "sequencer step", { TO_CV_SLEW, TO_CV, TO_ENV_TRIG, TO_TR_PULSE }, 4 },
+};
+
+// the next update starts from an empty queue (a full ring drains in this many ticks)
+#define DRAINSAMPLES (TXQUEUESIZE / TXQUEUEDRAIN)
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct Summary {
+  int Commands;
+  int Transactions;
+  int Bytes;
+  double BusUs;
+  double UpdatesPerSecond;
+  uint32_t MaxSpread;
+  uint32_t MaxFrameSpread;
+};
+
+static TxQueue commandQueue;
+static uint32_t sampleClock = 0;
+static std::vector<TxResponse> received;
+// the samples the ISR applied the received commands on
+static std::vector<uint32_t> applied;
+// the most commands the ISR applied on one tick
+static int mostPerTick = 0;
+
+static uint32_t random32 = 1;
+
+static uint32_t Random() {
+  random32 = random32 * 1664525 + 1013904223;
+  return random32 >> 8;
+}
+
+static void ReceiveCommand(TxResponse& response, int run) {
+  commandQueue.Stamp(response, sampleClock);
+  commandQueue.Push(response, run);
+}
+
+/*
+ * receiveEvent() as TELEXo.ino has it (less the wavetable uploads)
+ */
+static void ReceiveEvent(size_t len) {
+  TxPayload payload;
+  TxResponse response = TxHelper::Parse(len, &payload);
+
+  if (response.Command == TO_FRAME) {
+    int count = (len - 1) / 4;
+    if (!commandQueue.Reserve(count))
+      return;
+    while (TxHelper::ParseNext(response))
+      ReceiveCommand(response, count--);
+    commandQueue.Publish();
+    return;
+  }
+
+  ReceiveCommand(response, 1);
+}
+
+static void Append(std::vector<uint8_t>& bytes, int command, int output, int value) {
+  bytes.push_back(command);
+  bytes.push_back(output);
+  bytes.push_back(((uint16_t)value >> 8) & 0xFF);
+  bytes.push_back(value & 0xFF);
+}
+
+static double Duration(size_t bytes) {
+  // the address byte goes first
+  return (bytes + 1) * BYTEUS + FRAMEUS;
+}
+
+/*
+ * the write ISR's ticks up to sample `until`, applying the commands due
+ * (as writeOutputs() does) and collecting them
+ */
+static void Tick(uint32_t until) {
+  TxResponse command;
+  for (; (int32_t)(until - sampleClock) > 0; sampleClock++) {
+    int c = 0;
+    for (; commandQueue.Pop(command, sampleClock, c); c++) {
+      received.push_back(command);
+      applied.push_back(sampleClock);
+    }
+    if (c > mostPerTick) mostPerTick = c;
+  }
+}
+
+/*
+ * the commands a write carries
+ */
+static size_t Commands(const std::vector<uint8_t>& write) {
+  return write[0] == TO_FRAME ? (write.size() - 1) / 4 : 1;
+}
+
+/*
+ * sends the writes of an update with the ticks running under them, then
+ * lets the queue drain
+ */
+static void Send(const std::vector<std::vector<uint8_t> >& writes, double& us, Summary& summary) {
+  size_t from = applied.size();
+  for (size_t w = 0; w < writes.size(); w++) {
+    us += Duration(writes[w].size());
+    Tick((uint32_t)(us / TICKUS));
+    Wire.Receive(&writes[w][0], writes[w].size());
+    us += PAUSEUS;
+  }
+  Tick(sampleClock + DRAINSAMPLES);
+  if (applied.size() > from && applied.back() - applied[from] > summary.MaxSpread)
+    summary.MaxSpread = applied.back() - applied[from];
+  // each write's commands, in the order they were applied
+  for (size_t w = 0, c = from; w < writes.size() && c < applied.size(); w++) {
+    size_t last = c + Commands(writes[w]) - 1;
+    if (last < applied.size() && applied[last] - applied[c] > summary.MaxFrameSpread)
+      summary.MaxFrameSpread = applied[last] - applied[c];
+    c = last + 1;
+  }
+}
+
+static Summary Run(const Scenario& s, int mode, int updates) {
+
+  Summary summary;
+  memset(&summary, 0, sizeof(summary));
+  double us = 0;
+  double busUs = 0;
+  int transactions = 0;
+  int bytes = 0;
+
+  random32 = 1;
+  received.clear();
+  applied.clear();
+  Wire.onReceive(ReceiveEvent);
+
+  for (int u = 0; u < updates; u++) {
+    std::vector<std::vector<uint8_t> > writes;
+    if (mode == MODE_FRAMED) writes.push_back(std::vector<uint8_t>(1, TO_FRAME));
+
+    int commands = 0;
+    for (int c = 0; c < 4 && s.Commands[c]; c++) {
+      for (int o = 0; o < s.Outputs; o++) {
+        if (mode == MODE_SINGLE) writes.push_back(std::vector<uint8_t>());
+        else if (Commands(writes.back()) == TXQUEUEDRAIN) writes.push_back(std::vector<uint8_t>(1, TO_FRAME));
+        Append(writes.back(), s.Commands[c], o, (int)(Random() % 16384));
+        commands++;
+      }
+    }
+
+    double start = us;
+    Send(writes, us, summary);
+    // the bus is busy from the first start to the last stop
+    busUs += us - start - PAUSEUS;
+    transactions += writes.size();
+    for (size_t w = 0; w < writes.size(); w++)
+      bytes += writes[w].size() + 1;
+    summary.Commands = commands;
+
+    us = (u + 1) * (double)UPDATEUS;
+    Tick((uint32_t)(us / TICKUS));
+  }
+
+  summary.Transactions = transactions / updates;
+  summary.Bytes = bytes / updates;
+  summary.BusUs = busUs / updates;
+  summary.UpdatesPerSecond = 1000000. / summary.BusUs;
+  return summary;
+}
+
+/*
+ * the commands of a frame cut off part way through its last one: the
+ * whole ones are kept, the rest dropped
+ */
+static bool CutOffFrame() {
+  std::vector<uint8_t> frame(1, TO_FRAME);
+  Append(frame, TO_CV, 0, 1000);
+  Append(frame, TO_CV, 1, -2000);
+  frame.push_back(TO_TR_PULSE);
+  frame.push_back(2);
+
+  received.clear();
+  Wire.onReceive(ReceiveEvent);
+  Wire.Receive(&frame[0], frame.size());
+  Tick(sampleClock + DRAINSAMPLES);
+
+  return received.size() == 2 &&
+    received[0].Command == TO_CV && received[0].Output == 0 && received[0].Value == 1000 &&
+    received[1].Command == TO_CV && received[1].Output == 1 && received[1].Value == -2000;
+}
+
+/*
+ * a frame of TXQUEUEDRAIN commands lands on one tick, even behind commands
+ * due on the same tick (it waits for the next); a longer frame, or one the
+ * ring has no room for, is dropped whole
+ */
+static bool FullFrame() {
+  std::vector<uint8_t> frame(1, TO_FRAME);
+  for (int c = 0; c < TXQUEUEDRAIN; c++)
+    Append(frame, TO_CV, c % 4, c);
+  std::vector<uint8_t> single;
+  Append(single, TO_TR_PULSE, 0, 0);
+
+  received.clear();
+  applied.clear();
+  Wire.onReceive(ReceiveEvent);
+  for (int c = 0; c < TXQUEUEDRAIN / 2; c++)
+    Wire.Receive(&single[0], single.size());
+  Wire.Receive(&frame[0], frame.size());
+  Tick(sampleClock + DRAINSAMPLES);
+  bool whole = received.size() == TXQUEUEDRAIN / 2 + TXQUEUEDRAIN &&
+    applied.back() == applied[TXQUEUEDRAIN / 2] && applied.back() == applied.front() + 1;
+
+  // the lone commands fill the ring but for one slot less than the frame needs
+  std::vector<uint8_t> longer(frame);
+  Append(longer, TO_CV, 0, 0);
+  unsigned long dropped = commandQueue.Dropped();
+  received.clear();
+  Wire.Receive(&longer[0], longer.size());
+  for (int c = 0; c < TXQUEUESIZE - TXQUEUEDRAIN + 1; c++)
+    Wire.Receive(&single[0], single.size());
+  Wire.Receive(&frame[0], frame.size());
+  Tick(sampleClock + DRAINSAMPLES);
+
+  return whole && received.size() == TXQUEUESIZE - TXQUEUEDRAIN + 1 &&
+    commandQueue.Dropped() - dropped == 2 * TXQUEUEDRAIN + 1;
+}
+
+int main(int argc, char *argv[]) {
+
+  int updates = 1000;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--updates") && a + 1 < argc)
+      updates = atoi(argv[++a]);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--updates N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (updates < 1) updates = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("updates", (long)updates);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.BeginArray("modes");
+
+    Summary summaries[2];
+    std::vector<TxResponse> decoded[2];
+    for (int mode = MODE_SINGLE; mode <= MODE_FRAMED; mode++) {
+      summaries[mode] = Run(scenarios[s], mode, updates);
+      decoded[mode] = received;
+    }
+
+    bool identical = decoded[MODE_SINGLE].size() == decoded[MODE_FRAMED].size();
+    for (size_t c = 0; identical && c < decoded[MODE_SINGLE].size(); c++) {
+      const TxResponse& a = decoded[MODE_SINGLE][c];
+      const TxResponse& b = decoded[MODE_FRAMED][c];
+      identical = a.Command == b.Command && a.Output == b.Output && a.Value == b.Value;
+    }
+    if (!identical || summaries[MODE_FRAMED].MaxFrameSpread != 0) pass = false;
+
+    for (int mode = MODE_SINGLE; mode <= MODE_FRAMED; mode++) {
+      json.BeginObject();
+      json.Field("mode", modeNames[mode]);
+      json.Field("commands", (long)summaries[mode].Commands);
+      json.Field("transactions", (long)summaries[mode].Transactions);
+      json.Field("bytes", (long)summaries[mode].Bytes);
+      json.Field("bus_us", summaries[mode].BusUs);
+      json.Field("updates_per_second", summaries[mode].UpdatesPerSecond);
+      json.Field("landing_spread_samples", (long)summaries[mode].MaxSpread);
+      json.Field("frame_spread_samples", (long)summaries[mode].MaxFrameSpread);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.Field("bus_time_saved", 1 - summaries[MODE_FRAMED].BusUs / summaries[MODE_SINGLE].BusUs);
+    json.Field("identical", identical);
+    json.EndObject();
+  }
+
+  json.EndArray();
+
+  bool cutOff = CutOffFrame();
+  if (!cutOff) pass = false;
+  json.Field("cut_off_frame", cutOff);
+  bool fullFrame = FullFrame();
+  if (!fullFrame) pass = false;
+  json.Field("full_frame", fullFrame);
+  if (mostPerTick > TXQUEUEDRAIN) pass = false;
+  json.Field("most_per_tick", (long)mostPerTick);
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * checks the cycle length of the oscillator from 1 ms to 60 minutes, set the
+ * way TO_OSC_CYC and TO_OSC_LFO set it, against the requested length; and that
+ * a minute-long slide between two slow LFOs moves the phase as far as a
+ * linear slide of the frequency should
+ *
+ * usage: lfo_cycle_check [--max-error PERCENT]
+ *   --max-error  the largest cycle length error allowed (default: 0.1)
+ *
+ * the error a 32-bit step would have is printed alongside for comparison
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defines.h"
+#include "Oscillator.h"
+
+// the saw (waveform 2)
+#define SAW (2 * MORPHRANGE)
+// a wrap drops the saw by over a quarter of its range; the BLEP can split
+// it over two samples, so the saw must climb past WRAPDROP again in between
+#define WRAPDROP 16384
+// cycles measured (fewer when they would take more than MAXSAMPLES)
+#define CYCLES 1000
+#define MAXSAMPLES 20000000.
+
+struct Cycle {
+  const char *Name;
+  double Ms;
+  int Millihertz;
+};
+
+static const Cycle cycles[] = {
+  { "1 ms", 1, 0 },
+  { "7 ms", 7, 0 },
+  { "100 ms", 100, 0 },
+  { "1 s", 1000, 0 },
+  { "3.3 s", 3300, 0 },
+  { "10 s", 10000, 0 },
+  { "1 min", 60000, 0 },
+  { "10 min", 600000, 0 },
+  { "37 min", 2220000, 0 },
+  { "60 min", 3600000, 0 },
+  { "32.767 Hz lfo", 0, 32767 },
+  { "1.5 Hz lfo", 0, 1500 },
+  { "0.123 Hz lfo", 0, 123 },
+  { "7 mHz lfo", 0, 7 },
+  { "1 mHz lfo", 0, 1 },
+};
+#define CYCLECOUNT (sizeof(cycles) / sizeof(cycles[0]))
+
+/*
+ * renders a saw until `count` wraps; returns the sample of the last one
+ */
+static double LastWrap(Oscillator& osc, int count) {
+  int16_t block[RENDERBLOCK];
+  int previous = -32768;
+  bool armed = false;
+  int wraps = 0;
+  double sample = 0;
+  while (wraps < count) {
+    osc.Render(block, RENDERBLOCK);
+    for (int i = 0; i < RENDERBLOCK; i++, sample++) {
+      if (armed && previous - block[i] > WRAPDROP) {
+        if (++wraps == count) return sample;
+        armed = false;
+      }
+      if (block[i] > WRAPDROP) armed = true;
+      previous = block[i];
+    }
+  }
+  return sample;
+}
+
+/*
+ * the error of the 32-bit step SetFreq used to truncate to
+ */
+static double TruncatedError(double hz) {
+  double step = floor(hz / SAMPLINGRATE * FULLPHASE);
+  return step > 0 ? fabs(FULLPHASE / step / SAMPLINGRATE * hz - 1) * 100 : 100;
+}
+
+static bool CheckCycle(const Cycle& c, double maxError) {
+
+  Oscillator osc;
+  double hz = c.Millihertz ? c.Millihertz / 1000. : 1000. / c.Ms;
+  double expected = SAMPLINGRATE / hz;
+
+  osc.SetWaveform(SAW);
+  if (c.Millihertz)
+    osc.SetLFO(c.Millihertz);
+  else
+    osc.SetFloatFrequency(1000. / c.Ms);
+  osc.ResetPhase(0);
+
+  int count = (int)(MAXSAMPLES / expected);
+  if (count > CYCLES) count = CYCLES;
+  if (count < 1) count = 1;
+
+  // the phase starts at zero, so the wraps land on whole cycles
+  double period = (LastWrap(osc, count) + 1) / count;
+  double error = fabs(period / expected - 1) * 100;
+  bool pass = error < maxError;
+
+  printf("%-14s %12.1f samples, measured %14.3f over %4d cycles: %.5f%% (32-bit step: %.3f%%) - %s\n",
+    c.Name, expected, period, count, error, TruncatedError(hz), pass ? "ok" : "FAILED");
+  return pass;
+}
+
+/*
+ * a minute-long slide from a one hour cycle to a ten minute one
+ */
+static bool CheckSlide(double maxError) {
+
+  Oscillator osc;
+  double from = 1. / 3600;
+  double to = 1. / 600;
+  unsigned long ms = 60000;
+  size_t samples = (size_t)(ms * KRATE);
+
+  osc.SetWaveform(SAW);
+  osc.SetFloatFrequency(from);
+  osc.SetPortamentoMs(ms);
+  osc.ResetPhase(0);
+  osc.TargetFloatFrequency(to);
+
+  int16_t block[RENDERBLOCK];
+  size_t done = 0;
+  int value = 0;
+  while (done < samples) {
+    size_t count = samples - done < RENDERBLOCK ? samples - done : RENDERBLOCK;
+    osc.Render(block, count);
+    value = block[count - 1];
+    done += count;
+  }
+
+  // a linear slide covers the mean of the two steps per sample (the phase stays inside one cycle)
+  double phase = samples * (from + to) / 2 / SAMPLINGRATE * FULLPHASE;
+  double measured = ((double)value + 32767) * 65536;
+  double error = fabs(measured / phase - 1) * 100;
+  bool pass = error < maxError;
+
+  printf("%-14s phase %.0f, expected %.0f: %.5f%% - %s\n", "1 h to 10 min", measured, phase, error, pass ? "ok" : "FAILED");
+
+  // then the target's cycle
+  osc.ResetPhase(0);
+  double period = (LastWrap(osc, 1) + 1);
+  double cycleError = fabs(period / (SAMPLINGRATE / to) - 1) * 100;
+  bool landed = cycleError < maxError;
+  printf("%-14s %12.1f samples, measured %14.3f: %.5f%% - %s\n", "landed", SAMPLINGRATE / to, period, cycleError, landed ? "ok" : "FAILED");
+
+  return pass && landed;
+}
+
+int main(int argc, char *argv[]) {
+
+  double maxError = 0.1;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--max-error") && a + 1 < argc)
+      maxError = strtod(argv[++a], NULL);
+    else {
+      fprintf(stderr, "usage: %s [--max-error PERCENT]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  bool pass = true;
+  for (size_t c = 0; c < CYCLECOUNT; c++)
+    pass = CheckCycle(cycles[c], maxError) && pass;
+  pass = CheckSlide(maxError) && pass;
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * checks the wavetable scan against the tables it blends:
+ *   - a scan parked on a table against SetWaveform (not on the 3.2, whose
+ *     scan reads without interpolating)
+ *   - a scan position against the two tables around it, crossfaded in double
+ *   - a slide of the position, half way and landed, against a scan set there
+ *   - a change of the scan range, which slides to the same place in the new one
+ * and times Render() for a still scan, a scan sliding across a bank and one
+ * sliding across the whole range against a single morph
+ *
+ * usage: scan_check [--samples N]
+ *   --samples  samples timed per case, over TIMEROUNDS rounds (default: four seconds)
+ *
+ * any sample more than MAXLSB off fails (the weight is Q15, the morph's percent)
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "defines.h"
+#include "Oscillator.h"
+
+typedef std::chrono::steady_clock CheckClock;
+
+#define MAXLSB 2
+#define FREQUENCY 440
+// samples compared per position
+#define CHECKSAMPLES 2048
+// an even number of samples in both builds, so one of them is half way
+#define SLEWMS 1024
+#define SLEWSAMPLES ((size_t)(SLEWMS * KRATE))
+// the timings are the best of this many rounds
+#define TIMEROUNDS 16
+// the sliding scan sweeps a bank's tables (every build's), and then the whole
+// range, which in the turbo build mostly times the first reads of ten times the tables
+#define TIMEDTABLES 32
+
+struct Range {
+  const char *Name;
+  int From;
+  int To;
+};
+
+static int tables = 0;
+
+/*
+ * the scan at a position, from phase zero
+ */
+static void RenderScan(int from, int to, int position, int16_t *out, size_t n) {
+  Oscillator osc;
+  osc.SetScanFrom(from);
+  osc.SetScanTo(to);
+  osc.SetScan(position);
+  osc.SetFrequency(FREQUENCY);
+  osc.ResetPhase(0);
+  osc.Render(out, n);
+}
+
+/*
+ * a scan parked exactly on a table
+ */
+static void RenderOnTable(int table, int16_t *out, size_t n) {
+  RenderScan(table * MORPHRANGE, table * MORPHRANGE, 0, out, n);
+}
+
+#ifndef BASIC
+/*
+ * one table, from phase zero
+ */
+static void RenderTable(int table, int16_t *out, size_t n) {
+  Oscillator osc;
+  osc.SetWaveform(table * MORPHRANGE);
+  osc.SetFrequency(FREQUENCY);
+  osc.ResetPhase(0);
+  osc.Render(out, n);
+}
+#endif
+
+static int MaxError(const int16_t *a, const int16_t *b, size_t n) {
+  int worst = 0;
+  for (size_t i = 0; i < n; i++)
+    if (abs(a[i] - b[i]) > worst) worst = abs(a[i] - b[i]);
+  return worst;
+}
+
+/*
+ * a scan parked on a table reads it like SetWaveform (the triangle, saw and
+ * square render directly there, so they are left out)
+ */
+static bool CheckTables() {
+#ifdef BASIC
+  printf("%-18s skipped (the 3.2 scan does not interpolate)\n", "on a table");
+  return true;
+#else
+  int16_t scan[CHECKSAMPLES], table[CHECKSAMPLES];
+  int worst = 0;
+  int checked = 0;
+  for (int t = 0; t < tables; t += t == 0 ? 4 : 7) {
+    RenderOnTable(t, scan, CHECKSAMPLES);
+    RenderTable(t, table, CHECKSAMPLES);
+    int error = MaxError(scan, table, CHECKSAMPLES);
+    if (error > worst) worst = error;
+    checked++;
+  }
+  bool pass = worst == 0;
+  printf("%-18s %d tables, max error %d LSB - %s\n", "on a table", checked, worst, pass ? "ok" : "FAILED");
+  return pass;
+#endif
+}
+
+/*
+ * positions across a range against the crossfade of the tables around them
+ */
+static bool CheckPositions(const Range& r) {
+
+  static const int positions[] = { 0, 1, 1000, 4096, 5461, 8192, 12345, 16383, SCANRANGE };
+  int16_t scan[CHECKSAMPLES], a[CHECKSAMPLES], b[CHECKSAMPLES], expected[CHECKSAMPLES];
+  int worst = 0;
+  int checked = 0;
+
+  for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++) {
+    double wave = r.From + (double)(r.To - r.From) * positions[p] / SCANRANGE;
+    double table = wave / MORPHRANGE;
+    int below = (int)table;
+    int above = below + 1 < tables ? below + 1 : below;
+
+    RenderScan(r.From, r.To, positions[p], scan, CHECKSAMPLES);
+    RenderOnTable(below, a, CHECKSAMPLES);
+    RenderOnTable(above, b, CHECKSAMPLES);
+    for (int i = 0; i < CHECKSAMPLES; i++)
+      expected[i] = (int16_t)lround(a[i] + (b[i] - a[i]) * (table - below));
+
+    int error = MaxError(scan, expected, CHECKSAMPLES);
+    if (error > worst) worst = error;
+    checked++;
+  }
+
+  bool pass = checked > 0 && worst <= MAXLSB;
+  printf("%-18s %d positions, max error %d LSB - %s\n", r.Name, checked, worst, pass ? "ok" : "FAILED");
+  return pass;
+}
+
+/*
+ * a slide from one end of a range to the other: half way and landed
+ */
+static bool CheckSlide(const Range& r) {
+
+  size_t steps = SLEWSAMPLES;
+  std::vector<int16_t> slide(steps + CHECKSAMPLES);
+  std::vector<int16_t> still(steps + CHECKSAMPLES);
+
+  Oscillator osc;
+  osc.SetScanFrom(r.From);
+  osc.SetScanTo(r.To);
+  osc.SetScanSlewMs(SLEWMS);
+  osc.SetScan(0);
+  osc.SetFrequency(FREQUENCY);
+  osc.ResetPhase(0);
+  osc.TargetScan(SCANRANGE);
+  osc.Render(&slide[0], slide.size());
+
+  // half way: the sample the slide is at the middle of the range
+  RenderScan(r.From, r.To, SCANRANGE / 2, &still[0], still.size());
+  int half = abs(slide[steps / 2 - 1] - still[steps / 2 - 1]);
+
+  // landed: the rest matches the end of the range exactly
+  RenderScan(r.From, r.To, SCANRANGE, &still[0], still.size());
+  int landed = MaxError(&slide[steps], &still[steps], CHECKSAMPLES);
+
+  bool pass = half <= MAXLSB && landed == 0;
+  printf("%-18s slide: %d LSB half way, %d landed - %s\n", r.Name, half, landed, pass ? "ok" : "FAILED");
+  return pass;
+}
+
+/*
+ * a new range part way through: the scan slides to the position in the new range
+ */
+static bool CheckRangeChange() {
+
+  size_t steps = SLEWSAMPLES;
+  std::vector<int16_t> moved(steps + CHECKSAMPLES);
+  std::vector<int16_t> still(steps + CHECKSAMPLES);
+  int last = (tables - 1) * MORPHRANGE;
+
+  Oscillator osc;
+  osc.SetScanFrom(4 * MORPHRANGE);
+  osc.SetScanTo(last);
+  osc.SetScanSlewMs(SLEWMS);
+  osc.SetScan(SCANRANGE / 4);
+  osc.SetFrequency(FREQUENCY);
+  osc.ResetPhase(0);
+  osc.SetScanTo(20 * MORPHRANGE);
+  osc.Render(&moved[0], moved.size());
+
+  RenderScan(4 * MORPHRANGE, 20 * MORPHRANGE, SCANRANGE / 4, &still[0], still.size());
+  int landed = MaxError(&moved[steps], &still[steps], CHECKSAMPLES);
+
+  bool pass = landed == 0;
+  printf("%-18s %d landed - %s\n", "range change", landed, pass ? "ok" : "FAILED");
+  return pass;
+}
+
+/*
+ * times Render() from sample `from` for `samples` more, in ns a sample
+ */
+static double Time(Oscillator& osc, size_t from, size_t samples, bool slide) {
+  int16_t block[RENDERBLOCK];
+  CheckClock::time_point start = CheckClock::now();
+  for (size_t done = from; done < from + samples; done += RENDERBLOCK) {
+    // back and forth over the slew time
+    if (slide && done % SLEWSAMPLES < RENDERBLOCK)
+      osc.TargetScan((done / SLEWSAMPLES) % 2 ? 0 : SCANRANGE);
+    osc.Render(block, RENDERBLOCK);
+  }
+  return std::chrono::duration<double, std::nano>(CheckClock::now() - start).count() / samples;
+}
+
+int main(int argc, char *argv[]) {
+
+  size_t samples = SAMPLINGRATE * 4;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--samples") && a + 1 < argc)
+      samples = strtoul(argv[++a], NULL, 10);
+    else {
+      fprintf(stderr, "usage: %s [--samples N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // the tables as stored, so the crossfade can be rebuilt from SetWaveform
+  Oscillator::SetBandLimit(false);
+  tables = Oscillator::GetWaveformCount();
+
+  const Range ranges[] = {
+    { "two tables", 4 * MORPHRANGE, 5 * MORPHRANGE },
+    { "whole bank", 0, (tables - 1) * MORPHRANGE },
+    { "backwards", (tables - 1) * MORPHRANGE, 4 * MORPHRANGE + 50 },
+  };
+
+  bool pass = CheckTables();
+  for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+    pass = CheckPositions(ranges[r]) && pass;
+    pass = CheckSlide(ranges[r]) && pass;
+  }
+  pass = CheckRangeChange() && pass;
+
+  Oscillator::SetBandLimit(true);
+
+  Oscillator morph;
+  morph.SetWaveform(4 * MORPHRANGE + MORPHRANGE / 2);
+  morph.SetFrequency(FREQUENCY);
+  Oscillator still;
+  still.SetScan(SCANRANGE / 3);
+  still.SetFrequency(FREQUENCY);
+  Oscillator sliding;
+  sliding.SetScanTo((TIMEDTABLES - 1) * MORPHRANGE);
+  sliding.SetScanSlewMs(SLEWMS);
+  sliding.SetScan(0);
+  sliding.SetFrequency(FREQUENCY);
+  Oscillator sweeping;
+  sweeping.SetScanSlewMs(SLEWMS);
+  sweeping.SetScan(0);
+  sweeping.SetFrequency(FREQUENCY);
+
+  // the best of interleaved rounds, so they all see the same machine
+  double morphNs = 0, stillNs = 0, slidingNs = 0, sweepingNs = 0;
+  size_t round = (samples / TIMEROUNDS + RENDERBLOCK - 1) / RENDERBLOCK * RENDERBLOCK;
+  for (int r = 0; r < TIMEROUNDS; r++) {
+    double ns = Time(morph, r * round, round, false);
+    if (r == 0 || ns < morphNs) morphNs = ns;
+    ns = Time(still, r * round, round, false);
+    if (r == 0 || ns < stillNs) stillNs = ns;
+    ns = Time(sliding, r * round, round, true);
+    if (r == 0 || ns < slidingNs) slidingNs = ns;
+    ns = Time(sweeping, r * round, round, true);
+    if (r == 0 || ns < sweepingNs) sweepingNs = ns;
+  }
+  printf("render: morph %.2f ns/sample, scan %.2f (%.2fx), sliding scan %.2f (%.2fx), over the whole range %.2f (%.2fx)\n",
+    morphNs, stillNs, stillNs / morphNs, slidingNs, slidingNs / morphNs, sweepingNs, sweepingNs / morphNs);
+
+  printf("%s\n", pass ? "ok" : "FAILED");
+  return pass ? 0 : 1;
+}
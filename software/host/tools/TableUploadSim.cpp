@@ -0,0 +1,373 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * simulates wavetable uploads over a 400 kHz i2c bus while the outputs play
+ * the user tables they replace: each table goes up in writes of
+ * TXPAYLOADSIZE samples (TO_OSC_TABLE) and is swapped in (TO_OSC_TABLE_SWAP)
+ * through the command queue, the uploads back to back, with the receive
+ * callback wired as in TELEXo.ino; the last upload rewrites part of a table
+ *
+ * reports the transactions, bytes and time it takes to upload a table, and
+ * checks the swaps are glitch free: the outputs must match, sample for
+ * sample, a run in which each table is copied in whole on the sample its
+ * swap landed on
+ * results are written as JSON
+ *
+ * usage: table_upload_sim [--uploads N] [--out FILE]
+ *   --uploads  whole tables uploaded (default: 16)
+ *   --out      write the JSON to FILE instead of stdout
+ *
+ * exits with an error if an output differs, a write is refused or a swap is lost
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "TxQueue.h"
+#include "UserTables.h"
+#include "telex.h"
+
+#define TICKUS (1000000. / SAMPLINGRATE)
+
+// a byte (and its acknowledge) at 400 kHz, the start and stop around a write,
+// and the sender's pause between writes
+#define BYTEUS 22.5
+#define FRAMEUS 5
+#define MAXPAUSEUS 30
+
+// writes per table, and the harmonics in the tables sent
+#define CHUNKS (TABLERANGE / TXPAYLOADSIZE)
+#define HARMONICS 8
+// the chunk the partial upload rewrites
+#define PARTIALCHUNK 3
+// played on after the last swap
+#define TAILUS 20000
+// ticks of a sine before the uploads start (the outputs share a cycle of
+// OSCBUFFER ticks, so both runs are whole cycles and start on the same tick of it)
+#define SETTLETICKS (8 * OSCBUFFER)
+
+// the outputs play the first two user tables (and a morph between them)
+static const int waves[4] = { -100, -200, -150, 4 * MORPHRANGE };
+static const int frequencies[4] = { 110, 220, 330, 440 };
+
+/*
+ * a write as it arrives over the bus (the receive callback fires on its stop)
+ */
+struct Transaction {
+  double StartUs;
+  double Us;
+  std::vector<uint8_t> Bytes;
+};
+
+/*
+ * an upload: its writes and the table it leaves behind
+ */
+struct Upload {
+  int Table;
+  size_t First;
+  size_t Swap;
+  std::vector<int16_t> Samples;
+  uint32_t Landed;
+};
+
+static TxQueue commandQueue;
+static uint32_t sampleClock = 0;
+
+static uint32_t random32 = 1;
+
+static double Uniform(double range) {
+  random32 = random32 * 1664525 + 1013904223;
+  return (random32 >> 8) * range / 16777216.;
+}
+
+/*
+ * same as receiveEvent() in TELEXo.ino
+ */
+static void ReceiveEvent(size_t len) {
+
+  TxPayload payload;
+  TxResponse response = TxHelper::Parse(len, &payload);
+
+  if (response.Command == TO_OSC_TABLE) {
+    UserTables::Write(response.Output, response.Value, payload.Samples, payload.Length);
+    return;
+  }
+
+  if (response.Command == TO_OSC_TABLE_SWAP && !UserTables::Close(response.Output))
+    return;
+
+  commandQueue.Stamp(response, sampleClock);
+  if (!commandQueue.Push(response) && response.Command == TO_OSC_TABLE_SWAP)
+    UserTables::Reopen(response.Output);
+}
+
+/*
+ * a few harmonics at random levels and phases, scaled to full range
+ */
+static void Shape(int16_t *out, size_t n) {
+  double amplitude[HARMONICS], phase[HARMONICS], wave[TABLERANGE], peak = 0;
+  for (int h = 0; h < HARMONICS; h++) {
+    amplitude[h] = Uniform(1) / (h + 1);
+    phase[h] = Uniform(2 * M_PI);
+  }
+  for (int i = 0; i < TABLERANGE; i++) {
+    wave[i] = 0;
+    for (int h = 0; h < HARMONICS; h++)
+      wave[i] += amplitude[h] * sin(2 * M_PI * (h + 1) * i / TABLERANGE + phase[h]);
+    if (fabs(wave[i]) > peak) peak = fabs(wave[i]);
+  }
+  for (size_t i = 0; i < n; i++)
+    out[i] = (int16_t)lround(wave[i] * 32000 / peak);
+}
+
+static double Duration(size_t bytes) {
+  // the address byte goes first
+  return (bytes + 1) * BYTEUS + FRAMEUS;
+}
+
+static void Send(std::vector<Transaction>& traffic, double& us, int command, int table, int offset,
+    const int16_t *samples, size_t n) {
+  Transaction t;
+  t.Bytes.push_back(command);
+  t.Bytes.push_back(table);
+  t.Bytes.push_back((offset >> 8) & 0xFF);
+  t.Bytes.push_back(offset & 0xFF);
+  for (size_t i = 0; i < n; i++) {
+    t.Bytes.push_back(((uint16_t)samples[i] >> 8) & 0xFF);
+    t.Bytes.push_back(samples[i] & 0xFF);
+  }
+  t.StartUs = us;
+  us += Duration(t.Bytes.size());
+  t.Us = us;
+  traffic.push_back(t);
+  us += Uniform(MAXPAUSEUS);
+}
+
+/*
+ * the bus traffic: whole tables back to back, alternating between the first
+ * two user tables, then one chunk of the first rewritten on its own
+ */
+static std::vector<Transaction> Traffic(int uploads, std::vector<Upload>& sent) {
+
+  std::vector<Transaction> traffic;
+  std::vector<int16_t> tables[2];
+  double us = 1000;
+
+  random32 = 1;
+  tables[0].assign(TABLERANGE, 0);
+  tables[1].assign(TABLERANGE, 0);
+  sent.clear();
+
+  for (int u = 0; u <= uploads; u++) {
+    Upload upload;
+    bool partial = u == uploads;
+    upload.Table = partial ? 0 : u & 1;
+    upload.First = traffic.size();
+
+    std::vector<int16_t>& table = tables[upload.Table];
+    if (partial) {
+      std::vector<int16_t> shape(TABLERANGE);
+      Shape(&shape[0], TABLERANGE);
+      for (int i = 0; i < TXPAYLOADSIZE; i++)
+        table[PARTIALCHUNK * TXPAYLOADSIZE + i] = shape[i];
+      Send(traffic, us, TO_OSC_TABLE, upload.Table, PARTIALCHUNK * TXPAYLOADSIZE,
+        &table[PARTIALCHUNK * TXPAYLOADSIZE], TXPAYLOADSIZE);
+    } else {
+      Shape(&table[0], TABLERANGE);
+      for (int c = 0; c < CHUNKS; c++)
+        Send(traffic, us, TO_OSC_TABLE, upload.Table, c * TXPAYLOADSIZE, &table[c * TXPAYLOADSIZE], TXPAYLOADSIZE);
+    }
+
+    upload.Swap = traffic.size();
+    Send(traffic, us, TO_OSC_TABLE_SWAP, upload.Table, 0, NULL, 0);
+    upload.Samples = table;
+    upload.Landed = 0;
+    sent.push_back(upload);
+  }
+
+  return traffic;
+}
+
+/*
+ * copies a table in whole, the way the reference run swaps
+ */
+static void Load(int table, const int16_t *samples) {
+  UserTables::Write(table, 0, samples, TABLERANGE);
+  UserTables::Close(table);
+  UserTables::Swap(table);
+}
+
+/*
+ * sets the outputs playing; a sine first, so every DAC channel has been
+ * written the same way in both runs before the user tables take over
+ */
+static void Configure(BenchRig& rig) {
+  for (int o = 0; o < 4; o++) {
+    rig.cv[o]->SetValue(16383);
+    rig.cv[o]->SetFrequency(frequencies[o]);
+  }
+  for (int t = 0; t < SETTLETICKS; t++)
+    rig.Tick();
+  for (int o = 0; o < 4; o++)
+    rig.cv[o]->SetWaveform(waves[o]);
+}
+
+/*
+ * plays the outputs while the traffic arrives; records every tick's DAC
+ * values and the sample each swap landed on
+ */
+static void RunUploads(const std::vector<Transaction>& traffic, std::vector<Upload>& sent, std::vector<uint16_t>& dac) {
+
+  BenchRig rig;
+  Configure(rig);
+  Wire.onReceive(ReceiveEvent);
+
+  size_t a = 0;
+  size_t swaps = 0;
+  uint32_t ticks = (uint32_t)((traffic.back().Us + TAILUS) / TICKUS) + 1;
+  ticks = (ticks + OSCBUFFER - 1) / OSCBUFFER * OSCBUFFER;
+  sampleClock = 0;
+  dac.clear();
+
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+
+    double tickUs = tick * TICKUS;
+
+    for (; a < traffic.size() && traffic[a].Us < tickUs; a++) {
+      HostHal::SetMicros((uint32_t)traffic[a].Us);
+      Wire.Receive(&traffic[a].Bytes[0], traffic[a].Bytes.size());
+    }
+
+    // the write ISR
+    HostHal::SetMicros((uint32_t)tickUs);
+    TxResponse command;
+    for (int c = 0; commandQueue.Pop(command, sampleClock, c); c++) {
+      if (command.Command != TO_OSC_TABLE_SWAP) continue;
+      UserTables::Swap(command.Output);
+      if (swaps < sent.size()) sent[swaps++].Landed = sampleClock;
+    }
+    rig.Tick();
+    sampleClock++;
+
+    for (int o = 0; o < 4; o++)
+      dac.push_back(HostHal::DacOutput(dacOutputs[o]));
+  }
+}
+
+/*
+ * the same outputs with each table copied in whole on its swap's sample;
+ * returns the number of DAC values that differ from the upload run
+ */
+static long RunReference(const std::vector<Upload>& sent, const std::vector<uint16_t>& dac) {
+
+  // back to the power-on tables
+  std::vector<int16_t> silence(TABLERANGE, 0);
+  Load(0, &silence[0]);
+  Load(1, &silence[0]);
+
+  BenchRig rig;
+  Configure(rig);
+
+  size_t next = 0;
+  long differ = 0;
+
+  for (size_t tick = 0; tick < dac.size() / 4; tick++) {
+    for (; next < sent.size() && sent[next].Landed == tick; next++)
+      Load(sent[next].Table, &sent[next].Samples[0]);
+    rig.Tick();
+    for (int o = 0; o < 4; o++)
+      if (HostHal::DacOutput(dacOutputs[o]) != dac[tick * 4 + o]) differ++;
+  }
+
+  return differ;
+}
+
+int main(int argc, char *argv[]) {
+
+  int uploads = 16;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--uploads") && a + 1 < argc)
+      uploads = atoi(argv[++a]);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--uploads N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (uploads < 2) uploads = 2;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  std::vector<Upload> sent;
+  std::vector<Transaction> traffic = Traffic(uploads, sent);
+  std::vector<uint16_t> dac;
+
+  unsigned long refused = UserTables::Refused();
+  RunUploads(traffic, sent, dac);
+  refused = UserTables::Refused() - refused;
+
+  // a whole table, from the start of its first write to its swap landing
+  long lost = 0;
+  double busMs = 0, meanMs = 0, worstMs = 0;
+  for (int u = 0; u < uploads; u++) {
+    const Upload& upload = sent[u];
+    if (!upload.Landed) {
+      lost++;
+      continue;
+    }
+    double ms = (upload.Landed * TICKUS - traffic[upload.First].StartUs) / 1000.;
+    busMs += (traffic[upload.Swap].Us - traffic[upload.First].StartUs) / 1000.;
+    meanMs += ms;
+    if (ms > worstMs) worstMs = ms;
+  }
+  if (!sent[uploads].Landed) lost++;
+  if (uploads > lost) {
+    busMs /= uploads - lost;
+    meanMs /= uploads - lost;
+  }
+
+  long differ = RunReference(sent, dac);
+
+  size_t bytes = 0;
+  for (size_t t = sent[0].First; t <= sent[0].Swap; t++)
+    bytes += traffic[t].Bytes.size() + 1;
+
+  bool pass = !differ && !refused && !lost;
+
+  JsonWriter json(out);
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("user_tables", (long)USERTABLES);
+  json.Field("samples_per_write", (long)TXPAYLOADSIZE);
+  json.Field("transactions_per_table", (long)(sent[0].Swap - sent[0].First + 1));
+  json.Field("bytes_per_table", (long)bytes);
+  json.Field("uploads", (long)uploads);
+  json.Field("mean_bus_ms", busMs);
+  json.Field("mean_upload_ms", meanMs);
+  json.Field("worst_upload_ms", worstMs);
+  json.Field("refused", (long)refused);
+  json.Field("lost_swaps", lost);
+  json.Field("samples_compared", (long)dac.size());
+  json.Field("samples_differ", differ);
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * runs the four trigger metros on the shared tempo (as the TO.M commands
+ * set it) for hours of simulated time, with multipliers and tempo changes,
+ * and checks every beat against the exact time its tempo puts it at:
+ *   - each beat goes out on the first tick at or after its exact time
+ *   - the beats the outputs share (every reference beat) go out together
+ *   - the last beat is less than a sample from the tempo asked for
+ * and reports the drift a whole-millisecond interval (as the metros held
+ * it when polled) and a whole-microsecond one would have built up instead
+ * results are written as JSON
+ *
+ * usage: tempo_drift_sim [--hours N] [--out FILE]
+ *   --hours  simulated time per scenario (default: 4)
+ *   --out    write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a beat is off its tick, missing or out of step
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "TempoClock.h"
+#include "TriggerQueue.h"
+#include "TxHelper.h"
+
+typedef std::chrono::steady_clock SimClock;
+
+// the metros start on this (a tick of both builds)
+#define STARTUS 8000
+// tempos in a scenario (each taking up an equal part of the run)
+#define TEMPOS 3
+
+static int pins[4] = { 23, 22, 21, 20 };
+static int ledPins[4] = { 0, 1, 2, 7 };
+
+/*
+ * the shared tempo (in the SetMetroTime format) and each output's multiplier;
+ * a tempo of 0 ends the list
+ */
+struct Scenario {
+  const char *Name;
+  short Format;
+  unsigned long Tempo[TEMPOS];
+  int Multiply[4];
+};
+
+static const Scenario scenarios[] = {
+  { "97 bpm", 3, { 97, 0, 0 }, { 1, 2, 3, 4 } },
+  { "128.57, 97.30 and 140.00 bpm", 4, { 12857, 9730, 14000 }, { 1, 3, 4, 7 } },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/*
+ * where an output's beats are meant to be: the n-th step since the tempo
+ * was taken up lands on floor(n * Numerator / (Denominator * multiplier))
+ */
+struct Beats {
+  uint64_t Anchor;
+  uint64_t Numerator;
+  uint64_t Denominator;
+  uint64_t Step;
+  int Multiply;
+  int Tempo;
+
+  uint64_t Due() {
+    return Anchor + (uint64_t)((unsigned __int128)Step * Numerator / (Denominator * Multiply));
+  }
+};
+
+struct Summary {
+  long Beats;
+  long Late;
+  long Missing;
+  long SharedBeats;
+  long OutOfStep;
+  double MaxErrorUs;
+  double DriftUs;
+  double MsIntervalDriftUs;
+  double UsIntervalDriftUs;
+  double SimulatedPerSecond;
+};
+
+/*
+ * the first tick at or after a time
+ */
+static uint64_t TickOf(uint64_t us) {
+  return (us + SAMPLEUS - 1) / SAMPLEUS * SAMPLEUS;
+}
+
+/*
+ * the tempo as the metros used to hold it: whole milliseconds (hundredths
+ * of a BPM could only be sent as whole BPM) and whole microseconds
+ */
+static double MsInterval(const Scenario& s, int t) {
+  unsigned long bpm = s.Format == 4 ? (s.Tempo[t] + 50) / 100 : s.Tempo[t];
+  return TxHelper::ConvertMs(bpm, 3) * 1000.;
+}
+
+static double UsInterval(const Scenario& s, int t) {
+  return s.Format == 4 ? 6000000000ULL / s.Tempo[t] : TxHelper::ConvertUs(s.Tempo[t], s.Format);
+}
+
+static double Exact(const Scenario& s, int t) {
+  return s.Format == 4 ? 6000000000. / s.Tempo[t] : 60000000. / s.Tempo[t];
+}
+
+static Summary Run(const Scenario& s, double hours) {
+
+  TriggerQueue queue;
+  TempoClock tempo;
+  TriggerOutput *tr[4];
+  Beats beats[4];
+  std::vector<uint64_t> shared[4];
+  uint8_t pin[4];
+  int tempos = 0;
+  while (tempos < TEMPOS && s.Tempo[tempos]) tempos++;
+
+  uint64_t endUs = (uint64_t)(hours * 3600000000.);
+  uint64_t changeUs[TEMPOS];
+  for (int t = 0; t < tempos; t++)
+    changeUs[t] = t ? endUs / tempos * t / SAMPLEUS * SAMPLEUS : 0;
+
+  // wired as TELEXo.ino does it, with the TO.M commands' tempo
+  HostHal::SetMicros(0);
+  tempo.SetTime(s.Tempo[0], s.Format);
+  for (int o = 0; o < 4; o++) {
+    tr[o] = new TriggerOutput(pins[o], ledPins[o]);
+    tr[o]->ReferenceQueue(&queue);
+    tr[o]->Reset();
+    tr[o]->SetMultiplier(s.Multiply[o]);
+    tr[o]->SetTime(5, 0);
+    tr[o]->SetTempo(&tempo);
+  }
+  for (int o = 0; o < 4; o++) {
+    tr[o]->SetMetro(1, STARTUS);
+    pin[o] = HostHal::GetPin(pins[o]);
+    beats[o].Anchor = STARTUS;
+    beats[o].Numerator = tempo.Numerator();
+    beats[o].Denominator = tempo.Denominator();
+    beats[o].Step = 0;
+    beats[o].Multiply = s.Multiply[o];
+    beats[o].Tempo = 0;
+  }
+
+  Summary summary;
+  memset(&summary, 0, sizeof(summary));
+  int next = 1;
+  unsigned long fired = 0;
+  // the beats each tempo lasted (for the drifts), and when the last one went out
+  long tempoBeats[TEMPOS] = { 0 };
+  uint64_t lastShared = 0;
+
+  SimClock::time_point start = SimClock::now();
+  for (uint64_t tick = SAMPLEUS; tick < endUs; tick += SAMPLEUS) {
+
+    queue.Tick();
+
+    // a tempo change arrives after the trigger queue has run (as commands do in the ISR)
+    if (next < tempos && tick == changeUs[next]) {
+      tempo.SetTime(s.Tempo[next], s.Format);
+      for (int o = 0; o < 4; o++)
+        tr[o]->SetTempo(&tempo);
+      next++;
+    }
+
+    if (queue.Fired() == fired) continue;
+    fired = queue.Fired();
+
+    for (int o = 0; o < 4; o++) {
+      uint8_t level = HostHal::GetPin(pins[o]);
+      bool rising = level && !pin[o];
+      pin[o] = level;
+      if (!rising) continue;
+
+      Beats& b = beats[o];
+      // a reference beat after a change takes up the new tempo from its own time
+      if (b.Step % b.Multiply == 0 && b.Tempo + 1 < next && b.Due() > changeUs[b.Tempo + 1]) {
+        b.Anchor = b.Due();
+        b.Step = 0;
+        b.Tempo++;
+        TempoClock change;
+        change.SetTime(s.Tempo[b.Tempo], s.Format);
+        b.Numerator = change.Numerator();
+        b.Denominator = change.Denominator();
+      }
+
+      uint64_t due = b.Due();
+      double error = (double)tick - (double)due;
+      if (tick != TickOf(due)) summary.Late++;
+      if (fabs(error) > summary.MaxErrorUs) summary.MaxErrorUs = fabs(error);
+      if (b.Step % b.Multiply == 0) {
+        shared[o].push_back(tick);
+        if (o == 0) {
+          tempoBeats[b.Tempo] = (long)(b.Step / b.Multiply);
+          lastShared = tick;
+        }
+      }
+      b.Step++;
+      summary.Beats++;
+    }
+  }
+  double cpu = std::chrono::duration<double>(SimClock::now() - start).count();
+
+  // beats due before the end that never went out
+  for (int o = 0; o < 4; o++)
+    if (TickOf(beats[o].Due()) < endUs) summary.Missing++;
+
+  // the outputs' reference beats, side by side
+  size_t n = shared[0].size();
+  for (int o = 1; o < 4; o++)
+    if (shared[o].size() != n) summary.OutOfStep++;
+  for (size_t i = 0; i < n; i++) {
+    for (int o = 1; o < 4; o++)
+      if (i < shared[o].size() && shared[o][i] != shared[0][i]) {
+        summary.OutOfStep++;
+        break;
+      }
+  }
+  summary.SharedBeats = (long)n;
+
+  // the last reference beat against the tempos asked for (each tempo lasts
+  // up to the beat the next one starts on)
+  double exact = STARTUS;
+  for (int t = 0; t < tempos; t++) {
+    long intervals = t < tempos - 1 ? tempoBeats[t] + 1 : tempoBeats[t];
+    exact += intervals * Exact(s, t);
+    summary.MsIntervalDriftUs += intervals * (MsInterval(s, t) - Exact(s, t));
+    summary.UsIntervalDriftUs += intervals * (UsInterval(s, t) - Exact(s, t));
+  }
+  summary.DriftUs = (double)lastShared - exact;
+  summary.SimulatedPerSecond = cpu > 0 ? hours * 3600 / cpu : 0;
+
+  for (int o = 0; o < 4; o++)
+    delete tr[o];
+  return summary;
+}
+
+int main(int argc, char *argv[]) {
+
+  double hours = 4;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--hours") && a + 1 < argc)
+      hours = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--hours N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (hours < 0.01) hours = 0.01;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("sample_us", (long)SAMPLEUS);
+  json.Field("hours", hours);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    Summary summary = Run(scenarios[s], hours);
+    if (summary.Late || summary.Missing || summary.OutOfStep || fabs(summary.DriftUs) >= SAMPLEUS)
+      pass = false;
+
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.Field("beats", summary.Beats);
+    json.Field("late_beats", summary.Late);
+    json.Field("missing_beats", summary.Missing);
+    json.Field("shared_beats", summary.SharedBeats);
+    json.Field("out_of_step", summary.OutOfStep);
+    json.Field("max_error_us", summary.MaxErrorUs);
+    json.Field("drift_us", summary.DriftUs);
+    json.Field("ms_interval_drift_us", summary.MsIntervalDriftUs);
+    json.Field("us_interval_drift_us", summary.UsIntervalDriftUs);
+    json.Field("simulated_s_per_cpu_s", summary.SimulatedPerSecond);
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
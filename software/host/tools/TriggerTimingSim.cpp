@@ -0,0 +1,338 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * runs the four trigger outputs' metros (with multipliers) and pulse ends
+ * two ways and measures every beat against the time the output's interval
+ * puts it at, every pulse end against its pulse time after the beat (and
+ * the last beat against the tempo asked for):
+ *   polling    - Update() from loop() with millis(), times in whole
+ *                milliseconds (the way TELEXo.ino ran them before the queue)
+ *   scheduled  - the trigger queue, ticked by the write ISR on the sample clock
+ * and the CPU the trigger code takes per edge and per second
+ * results are written as JSON
+ *
+ * usage: trigger_timing_sim [--seconds N] [--out FILE]
+ *   --seconds  simulated time per scenario (default: 60)
+ *   --out      write the JSON to FILE instead of stdout
+ *
+ * exits with an error if a scheduled edge is more than a sample off or missing
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BenchRig.h"
+#include "HostHal.h"
+#include "TempoClock.h"
+#include "TriggerQueue.h"
+#include "TxHelper.h"
+
+typedef std::chrono::steady_clock SimClock;
+
+#define MODE_POLLING 0
+#define MODE_SCHEDULED 1
+
+static const char *modeNames[] = { "polling", "scheduled" };
+
+// the time between two passes of loop() (the write ISR and the LEDs take the rest)
+#define MINLOOPUS 2
+#define MAXLOOPUS 40
+
+// an edge missing from either end of the run
+#define MAXMISSING 1
+// the metros start on this (a tick of both builds)
+#define STARTUS 8000
+
+static int pins[4] = { 23, 22, 21, 20 };
+static int ledPins[4] = { 0, 1, 2, 7 };
+
+/*
+ * each output's metro (value in the SetMetroTime format), multiplier and pulse time
+ */
+struct Scenario {
+  const char *Name;
+  short Format;
+  int Metro[4];
+  int Multiply[4];
+  int PulseMs[4];
+};
+
+static const Scenario scenarios[] = {
+  { "metro ms", 0, { 100, 125, 250, 500 }, { 1, 1, 2, 3 }, { 10, 10, 5, 5 } },
+  { "metro bpm", 3, { 97, 120, 133, 140 }, { 1, 2, 1, 4 }, { 5, 5, 5, 5 } },
+};
+#define SCENARIOCOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct Summary {
+  long Edges;
+  long Expected;
+  double MeanErrorUs;
+  double MaxErrorUs;
+  double JitterUs;
+  double DriftUs;
+  double NsPerEdge;
+  double NsPerSecond;
+  bool Complete;
+};
+
+static uint32_t random32 = 1;
+
+static double Uniform(double range) {
+  random32 = random32 * 1664525 + 1013904223;
+  return (random32 >> 8) * range / 16777216.;
+}
+
+/*
+ * the edges each output is meant to make, each pulse ending its time after
+ * its beat: polled, a beat every whole millisecond interval (as ConvertMs
+ * gave it) with the multiplied beats a whole microsecond step apart; on the
+ * queue, the multiplied beats of the exact tempo (see TempoClock)
+ */
+static void Ideal(const Scenario& s, int mode, double endUs, std::vector<double> edges[4]) {
+  for (int o = 0; o < 4; o++) {
+    uint64_t interval = TxHelper::ConvertMs(s.Metro[o], s.Format) * 1000ULL;
+    uint64_t step = interval / s.Multiply[o];
+    TempoClock tempo;
+    tempo.SetTime(s.Metro[o], s.Format);
+    edges[o].clear();
+    for (long b = 0; ; b++) {
+      double beat = STARTUS + (double)(b / s.Multiply[o] * interval + b % s.Multiply[o] * step);
+      if (mode == MODE_SCHEDULED)
+        beat = STARTUS + (double)(b * tempo.Numerator() / (tempo.Denominator() * s.Multiply[o]));
+      if (beat + s.PulseMs[o] * 1000. >= endUs) break;
+      edges[o].push_back(beat);
+      edges[o].push_back(beat + s.PulseMs[o] * 1000.);
+    }
+  }
+}
+
+/*
+ * how far an output's last beat is from the tempo asked for
+ */
+static double Drift(const Scenario& s, int o, const std::vector<double>& edges) {
+  double interval = s.Format == 3 ? 60000000. / s.Metro[o] : s.Metro[o] * 1000.;
+  double step = interval / s.Multiply[o];
+  // the rising edges are the even ones
+  size_t last = (edges.size() - 1) & ~(size_t)1;
+  double beat = last / 2 * step;
+  return edges.empty() ? 0 : edges[last] - STARTUS - beat;
+}
+
+/*
+ * the polling run sets the times the old way: whole milliseconds
+ */
+static void Configure(TriggerOutput *tr, const Scenario& s, int o, int mode) {
+  tr->SetMultiplier(s.Multiply[o]);
+  if (mode == MODE_POLLING) {
+    tr->SetMetroTime(TxHelper::ConvertMs(s.Metro[o], s.Format), 0);
+  } else {
+    tr->SetMetroTime(s.Metro[o], s.Format);
+  }
+  tr->SetTime(s.PulseMs[o], 0);
+}
+
+/*
+ * builds the four outputs and starts their metros together (as TO.M.ACT does)
+ */
+static void Start(const Scenario& s, int mode, TriggerQueue& queue, TriggerOutput *tr[4]) {
+  HostHal::SetMicros(0);
+  for (int o = 0; o < 4; o++) {
+    tr[o] = new TriggerOutput(pins[o], ledPins[o]);
+    if (mode == MODE_SCHEDULED) tr[o]->ReferenceQueue(&queue);
+    tr[o]->Reset();
+    Configure(tr[o], s, o, mode);
+  }
+  for (int o = 0; o < 4; o++)
+    tr[o]->SetMetro(1, STARTUS);
+  random32 = 1;
+}
+
+/*
+ * the nanoseconds the trigger code takes over the run: the loop() passes
+ * or ISR ticks timed as a whole, less the same loop() passes without the outputs
+ */
+static double Cost(const Scenario& s, int mode, double seconds) {
+
+  TriggerQueue queue;
+  TriggerOutput *tr[4];
+  double endUs = seconds * 1000000.;
+
+  Start(s, mode, queue, tr);
+  SimClock::time_point start = SimClock::now();
+  if (mode == MODE_POLLING) {
+    for (double us = 0; us < endUs; us += MINLOOPUS + Uniform(MAXLOOPUS - MINLOOPUS)) {
+      uint64_t now = (uint64_t)(us / 1000) * 1000;
+      HostHal::SetMicros((uint32_t)now);
+      for (int o = 0; o < 4; o++)
+        tr[o]->Update(now);
+    }
+  } else {
+    for (uint64_t tick = 1; tick * SAMPLEUS < endUs; tick++)
+      queue.Tick();
+  }
+  double ns = std::chrono::duration<double, std::nano>(SimClock::now() - start).count();
+
+  // the loop() passes' own cost (the ticks have none worth taking off)
+  if (mode == MODE_POLLING) {
+    random32 = 1;
+    start = SimClock::now();
+    for (double us = 0; us < endUs; us += MINLOOPUS + Uniform(MAXLOOPUS - MINLOOPUS))
+      HostHal::SetMicros((uint32_t)((uint64_t)(us / 1000) * 1000));
+    ns -= std::chrono::duration<double, std::nano>(SimClock::now() - start).count();
+  }
+
+  for (int o = 0; o < 4; o++)
+    delete tr[o];
+  return ns > 0 ? ns : 0;
+}
+
+static Summary Run(const Scenario& s, int mode, double seconds) {
+
+  TriggerQueue queue;
+  TriggerOutput *tr[4];
+  std::vector<double> edges[4];
+  uint8_t pin[4];
+  double endUs = seconds * 1000000.;
+
+  Start(s, mode, queue, tr);
+  for (int o = 0; o < 4; o++)
+    pin[o] = HostHal::GetPin(pins[o]);
+
+  if (mode == MODE_POLLING) {
+    for (double us = 0; us < endUs; us += MINLOOPUS + Uniform(MAXLOOPUS - MINLOOPUS)) {
+      // millis() as loop() reads it
+      uint64_t now = (uint64_t)(us / 1000) * 1000;
+      HostHal::SetMicros((uint32_t)now);
+      for (int o = 0; o < 4; o++)
+        tr[o]->Update(now);
+      for (int o = 0; o < 4; o++) {
+        uint8_t level = HostHal::GetPin(pins[o]);
+        if (level != pin[o]) edges[o].push_back(us);
+        pin[o] = level;
+      }
+    }
+  } else {
+    for (uint64_t tick = 1; tick * SAMPLEUS < endUs; tick++) {
+      queue.Tick();
+      for (int o = 0; o < 4; o++) {
+        uint8_t level = HostHal::GetPin(pins[o]);
+        if (level != pin[o]) edges[o].push_back((double)(tick * SAMPLEUS));
+        pin[o] = level;
+      }
+    }
+  }
+
+  std::vector<double> ideal[4];
+  Ideal(s, mode, endUs, ideal);
+
+  Summary summary;
+  double sum = 0, squares = 0, worst = 0, drift = 0;
+  long count = 0, expected = 0;
+  bool complete = true;
+  for (int o = 0; o < 4; o++) {
+    size_t n = std::min(edges[o].size(), ideal[o].size());
+    long missing = labs((long)edges[o].size() - (long)ideal[o].size());
+    if (missing > MAXMISSING * 2) complete = false;
+    for (size_t e = 0; e < n; e++) {
+      // a pulse end is timed from the tick its beat went out on
+      double error = e & 1 ? (edges[o][e] - edges[o][e - 1]) - (ideal[o][e] - ideal[o][e - 1])
+                           : edges[o][e] - ideal[o][e];
+      sum += error;
+      squares += error * error;
+      if (fabs(error) > worst) worst = fabs(error);
+      count++;
+    }
+    expected += ideal[o].size();
+    if (fabs(Drift(s, o, edges[o])) > fabs(drift)) drift = Drift(s, o, edges[o]);
+    delete tr[o];
+  }
+
+  double mean = count ? sum / count : 0;
+  summary.Edges = count;
+  summary.Expected = expected;
+  summary.MeanErrorUs = mean;
+  summary.MaxErrorUs = worst;
+  summary.JitterUs = count ? sqrt(std::max(0., squares / count - mean * mean)) : 0;
+  summary.DriftUs = drift;
+  double cpuNs = Cost(s, mode, seconds);
+  summary.NsPerEdge = count ? cpuNs / count : 0;
+  summary.NsPerSecond = cpuNs / seconds;
+  summary.Complete = complete;
+  return summary;
+}
+
+int main(int argc, char *argv[]) {
+
+  double seconds = 60;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--seconds") && a + 1 < argc)
+      seconds = strtod(argv[++a], NULL);
+    else if (!strcmp(argv[a], "--out") && a + 1 < argc)
+      outPath = argv[++a];
+    else {
+      fprintf(stderr, "usage: %s [--seconds N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (seconds < 1) seconds = 1;
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+
+  JsonWriter json(out);
+  bool pass = true;
+
+  json.BeginObject();
+  json.Field("sampling_rate", (long)SAMPLINGRATE);
+  json.Field("sample_us", (long)SAMPLEUS);
+  json.Field("seconds", seconds);
+  json.BeginArray("scenarios");
+
+  for (size_t s = 0; s < SCENARIOCOUNT; s++) {
+    json.BeginObject();
+    json.Field("name", scenarios[s].Name);
+    json.BeginArray("modes");
+
+    for (int mode = MODE_POLLING; mode <= MODE_SCHEDULED; mode++) {
+      Summary summary = Run(scenarios[s], mode, seconds);
+      if (mode == MODE_SCHEDULED && (!summary.Complete || summary.MaxErrorUs >= SAMPLEUS)) pass = false;
+
+      json.BeginObject();
+      json.Field("mode", modeNames[mode]);
+      json.Field("edges", summary.Edges);
+      json.Field("expected_edges", summary.Expected);
+      json.Field("mean_error_us", summary.MeanErrorUs);
+      json.Field("max_error_us", summary.MaxErrorUs);
+      json.Field("jitter_us", summary.JitterUs);
+      json.Field("tempo_drift_us", summary.DriftUs);
+      json.Field("cpu_ns_per_edge", summary.NsPerEdge);
+      json.Field("cpu_ns_per_second", summary.NsPerSecond);
+      json.Field("complete", summary.Complete);
+      json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+  }
+
+  json.EndArray();
+  json.Field("pass", pass);
+  json.EndObject();
+
+  if (out != stdout) fclose(out);
+
+  return pass ? 0 : 1;
+}
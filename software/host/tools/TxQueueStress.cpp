@@ -0,0 +1,220 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * hammers TxQueue from a producer thread (standing in for the i2c receive
+ * callback) while a consumer thread renders the output section, draining
+ * the queue before each tick the way writeOutputs() does; checks that every
+ * command arrives once, in order and untorn
+ *
+ * usage: tx_queue_stress [--commands N]
+ *   --commands  commands pushed per phase (default: 2000000)
+ *
+ * the first phase retries when the ring is full and must deliver every
+ * command; the second drops them like receiveEvent() and must account for
+ * every one it lost; the last times the tick that applies the worst frame
+ * the write ISR takes (TXQUEUEDRAIN quantized pitches with portamento) and
+ * checks that it lands on one tick
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "BenchRig.h"
+#include "TxQueue.h"
+#include "telex.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+// worst frames timed
+#define FRAMES 20000
+
+/*
+ * every field is derived from the sequence number so a torn copy shows up
+ */
+static TxResponse Make(uint32_t sequence) {
+  TxResponse response;
+  response.Command = (sequence ^ (sequence >> 8)) & 0xFF;
+  response.Output = (sequence * 7) & 3;
+  response.Value = (int)sequence;
+  response.Sample = 0;
+  return response;
+}
+
+static bool Valid(const TxResponse& response) {
+  TxResponse expected = Make((uint32_t)response.Value);
+  return response.Command == expected.Command && response.Output == expected.Output;
+}
+
+struct Result {
+  unsigned long Received;
+  unsigned long Torn;
+  unsigned long OutOfOrder;
+  unsigned long Ticks;
+  unsigned long Full;
+  unsigned long Dropped;
+};
+
+/*
+ * one producer/consumer run; `retry` spins on a full ring instead of dropping
+ */
+static Result Run(BenchRig& rig, unsigned long commands, bool retry) {
+
+  TxQueue queue;
+  std::atomic<bool> done(false);
+  Result result;
+  memset(&result, 0, sizeof(result));
+
+  std::thread producer([&]() {
+    // bursts of up to three rings' worth, so the ring also runs full
+    uint32_t random = 1;
+    uint32_t burst = 0;
+    for (uint32_t s = 0; s < commands; s++) {
+      TxResponse response = Make(s);
+      while (!queue.Push(response)) {
+        result.Full++;
+        if (!retry) break;
+        std::this_thread::yield();
+      }
+      if (burst-- == 0) {
+        random = random * 1664525 + 1013904223;
+        burst = (random >> 16) % (TXQUEUESIZE * 3);
+        std::this_thread::yield();
+      }
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  long next = 0;
+  TxResponse response;
+  bool finished = false;
+  while (!finished) {
+    // read the flag first: anything pushed before it is set is still drained
+    finished = done.load(std::memory_order_acquire);
+    bool more = true;
+    while (more) {
+      int c = 0;
+      for (; c < TXQUEUEDRAIN && (more = queue.Pop(response)); c++) {
+        if (!Valid(response)) result.Torn++;
+        if (response.Value < next || (retry && response.Value != next)) result.OutOfOrder++;
+        next = response.Value + 1;
+        result.Received++;
+        // give the render something to do with the commands
+        if ((response.Command & 3) == 0)
+          rig.cv[response.Output]->TargetValue(response.Value & 0x3FFF);
+        else if ((response.Command & 3) == 1)
+          rig.cv[response.Output]->SetFrequency(100 + (response.Value & 1023));
+      }
+      rig.Tick();
+      result.Ticks++;
+      // nothing waiting - let the producer run (the host may have a single core)
+      if (!c) std::this_thread::yield();
+      if (!finished) break;
+    }
+  }
+
+  producer.join();
+  result.Dropped = queue.Dropped();
+  return result;
+}
+
+static bool Report(const char *name, const Result& r, unsigned long commands, bool retry) {
+  bool pass = !r.Torn && !r.OutOfOrder
+    && (retry ? r.Received == commands : r.Received + r.Dropped == commands);
+  printf("%s: %lu received, %lu dropped, %lu full, %lu ticks, %lu torn, %lu out of order - %s\n",
+    name, r.Received, retry ? 0 : r.Dropped, r.Full, r.Ticks, r.Torn, r.OutOfOrder, pass ? "ok" : "FAILED");
+  return pass;
+}
+
+static double Median(std::vector<double>& ns) {
+  std::nth_element(ns.begin(), ns.begin() + ns.size() / 2, ns.end());
+  return ns[ns.size() / 2];
+}
+
+/*
+ * one write ISR tick: the commands due (TO_OSC_QT as actOnCommand() has it)
+ * and the render; returns the commands applied
+ */
+static int Tick(BenchRig& rig, TxQueue& queue, uint32_t sample, double& ns) {
+  TxResponse command;
+  int c = 0;
+  BenchClock::time_point start = BenchClock::now();
+  for (; queue.Pop(command, sample, c); c++)
+    rig.cv[command.Output]->TargetQuantizedVOct(command.Value);
+  rig.Tick();
+  ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+  return c;
+}
+
+/*
+ * the costliest frame a tick applies against a tick with nothing to apply;
+ * the frame is pushed the way receiveEvent() queues one
+ */
+static bool WorstFrame(BenchRig& rig) {
+
+  TxQueue queue;
+  std::vector<double> framed(FRAMES);
+  std::vector<double> idle(FRAMES);
+  uint32_t sample = 0;
+  unsigned long split = 0;
+
+  for (int i = 0; i < 4; i++) {
+    rig.cv[i]->SetOscQuantizationScale(1);
+    rig.cv[i]->SetFrequencySlew(20, 0);
+  }
+
+  for (int f = 0; f < FRAMES; f++) {
+    queue.Reserve(TXQUEUEDRAIN);
+    for (int c = TXQUEUEDRAIN; c > 0; c--) {
+      TxResponse response;
+      response.Command = TO_OSC_QT;
+      response.Output = c & 3;
+      // a different pitch every time, so each one sets up a new slide
+      response.Value = (f * 977 + c * 1499) % 16384;
+      response.Sample = sample;
+      queue.Push(response, c);
+    }
+    queue.Publish();
+    if (Tick(rig, queue, sample++, framed[f]) != TXQUEUEDRAIN) split++;
+    Tick(rig, queue, sample++, idle[f]);
+  }
+
+  double frameNs = Median(framed);
+  double idleNs = Median(idle);
+  printf("worst frame: %d commands in %.0f ns a tick (%.0f ns with none), %.1f%% of the %.0f ns sample period, %lu split - %s\n",
+    TXQUEUEDRAIN, frameNs, idleNs, 100 * frameNs / SAMPLEPERIODNS, SAMPLEPERIODNS, split, split ? "FAILED" : "ok");
+  return !split;
+}
+
+int main(int argc, char *argv[]) {
+
+  unsigned long commands = 2000000;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--commands") && a + 1 < argc)
+      commands = strtoul(argv[++a], NULL, 10);
+    else {
+      fprintf(stderr, "usage: %s [--commands N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  BenchRig rig;
+  for (int i = 0; i < 4; i++) {
+    rig.cv[i]->SetSlew(5, 0);
+    rig.cv[i]->SetWaveform(i * MORPHRANGE);
+    rig.cv[i]->SetFrequency(440);
+  }
+
+  bool pass = Report("lossless", Run(rig, commands, true), commands, true);
+  pass = Report("dropping", Run(rig, commands, false), commands, false) && pass;
+  pass = WorstFrame(rig) && pass;
+
+  return pass ? 0 : 1;
+}
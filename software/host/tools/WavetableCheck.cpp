@@ -0,0 +1,137 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * checks that Oscillator::Oscillate() produces the same samples for every
+ * wavetable as a recorded reference (a hash of the table on its own and one
+ * morphing into the next), so the table storage can be re-encoded without
+ * changing the sound
+ *
+ * usage: wavetable_check [--write] FILE
+ *   --write  record the reference instead of checking against it
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "Oscillator.h"
+
+// samples rendered per setting (a little over five cycles at the lowest frequency)
+#define CHECKSAMPLES 4096
+
+/*
+ * FNV-1a over the rendered samples of each setting { morph, frequency (-1: portamento) }
+ */
+static uint32_t Hash(int table, const int (*settings)[2], int count) {
+
+  uint32_t hash = 2166136261u;
+
+  for (int s = 0; s < count; s++) {
+    Oscillator osc;
+    osc.SetWaveform(table * MORPHRANGE + settings[s][0]);
+    if (settings[s][1] < 0) {
+      osc.SetFrequency(100);
+      osc.SetPortamentoMs(50);
+      osc.TargetFrequency(2000);
+    } else {
+      osc.SetFrequency(settings[s][1]);
+    }
+    osc.ResetPhase(0);
+    for (int i = 0; i < CHECKSAMPLES; i++) {
+      int value = osc.Oscillate();
+      for (int b = 0; b < 4; b++) {
+        hash ^= (value >> (b * 8)) & 0xff;
+        hash *= 16777619u;
+      }
+    }
+  }
+
+  return hash;
+}
+
+static const int plainSettings[3][2] = { { 0, 37 }, { 0, 1234 }, { 0, -1 } };
+static const int morphSettings[1][2] = { { MORPHRANGE / 2, 440 } };
+
+int main(int argc, char *argv[]) {
+
+  bool write = false;
+  const char *path = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--write"))
+      write = true;
+    else if (!path)
+      path = argv[a];
+    else
+      path = NULL, a = argc;
+  }
+
+  if (!path) {
+    fprintf(stderr, "usage: %s [--write] FILE\n", argv[0]);
+    return 2;
+  }
+
+  FILE *file = fopen(path, write ? "w" : "r");
+  if (!file) {
+    perror(path);
+    return 2;
+  }
+
+  // the reference reads every table as stored (level 0), whatever the frequency
+  Oscillator::SetBandLimit(false);
+
+  int tables = Oscillator::GetWaveformCount();
+  int mismatches = 0;
+  int checked = 0;
+  int table, recorded;
+  unsigned int plain, morph;
+  std::vector<uint32_t> expected;
+
+  if (!write) {
+    // the last line holds the number of tables the reference was recorded with
+    while (fscanf(file, "%d %x %x", &table, &plain, &morph) == 3) {
+      expected.push_back(plain);
+      expected.push_back(morph);
+    }
+    if (fscanf(file, "tables %d", &recorded) != 1 || recorded != (int)expected.size() / 2) {
+      fprintf(stderr, "%s: not a reference file\n", path);
+      return 2;
+    }
+  }
+
+  for (int t = 0; t < tables; t++) {
+    uint32_t plainHash = Hash(t, plainSettings, 3);
+    uint32_t morphHash = Hash(t, morphSettings, 1);
+    if (write) {
+      fprintf(file, "%d %08x %08x\n", t, plainHash, morphHash);
+      continue;
+    }
+    // tables added since the reference was recorded are not checked
+    if (t >= recorded)
+      break;
+    checked++;
+    if (plainHash != expected[t * 2]) {
+      fprintf(stderr, "table %d: %08x, expected %08x\n", t, plainHash, expected[t * 2]);
+      mismatches++;
+    // with a different table count the last table morphs into something else (noise or a table)
+    } else if (morphHash != expected[t * 2 + 1] && (tables == recorded || (t + 1 != recorded && t + 1 != tables))) {
+      fprintf(stderr, "table %d (morphing): %08x, expected %08x\n", t, morphHash, expected[t * 2 + 1]);
+      mismatches++;
+    }
+  }
+
+  if (write)
+    fprintf(file, "tables %d\n", tables);
+
+  fclose(file);
+
+  if (write)
+    printf("recorded %d tables\n", tables);
+  else
+    printf("%d of %d recorded tables match (%d tables built)\n", checked - mismatches, checked, tables);
+
+  return mismatches ? 1 : 0;
+}
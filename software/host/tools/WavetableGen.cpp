@@ -0,0 +1,496 @@
+/*
+ * TELEX Host Build
+ * (c) 2016-2018 Brendon Cassidy
+ * MIT License
+ *
+ * writes the TELEXo Wavetables.h: 16-bit tables grouped into banks, a flat
+ * index of the tables, their band-limited (mipmapped) levels and the
+ * per-build bank selection
+ *
+ * usage: wavetable_gen [--header FILE] [--wav FILE ...] [--bank-size N]
+ *                      [--basic-banks N] [--mips N] [--out FILE]
+ *   --header       read the tables from an existing Wavetables.h (either the
+ *                  generated layout or the original one-array-per-table layout)
+ *   --wav          append a 16-bit mono PCM WAV of 512 (or 513) samples
+ *   --bank-size    tables per bank (a power of two, default 32)
+ *   --basic-banks  banks compiled into the Teensy 3.2 build (default 2)
+ *   --mips         band-limited levels after the table itself (default 7); level
+ *                  k keeps the harmonics below (256 >> k) in (512 >> LevelShift(k))
+ *                  + 1 samples
+ *   --out          write the header to FILE instead of stdout
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TABLESIZE 513
+#define TABLELENGTH 512
+#define HARMONICS (TABLELENGTH / 2)
+// the top level holds the fundamental alone
+#define MAXMIPS 7
+// harmonics below this amplitude (in LSB) do not count towards a table's top
+#define TOPLSB 16.
+
+// the square is rendered directly, so its slot only needs to be valid
+#define SQUARE_WAVE 3
+
+struct Table {
+  std::string Name;
+  std::vector<int> Samples;
+  // the band-limited levels (Mips[k - 1] is level k)
+  std::vector<std::vector<int> > Mips;
+  // the highest harmonic over TOPLSB
+  int Top;
+  // level 1's interpolation images outweigh what the table as stored aliases
+  bool Imaged;
+};
+
+static bool ReadFile(const char *path, std::string& text) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  char buffer[65536];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    text.append(buffer, count);
+  fclose(file);
+  return true;
+}
+
+static Table Square() {
+  Table table;
+  table.Name = "computed square (not read: the square is rendered directly)";
+  for (int i = 0; i < TABLESIZE; i++)
+    table.Samples.push_back(i < TABLELENGTH / 2 || i == TABLELENGTH ? 32767 : -32767);
+  return table;
+}
+
+/*
+ * parses the numbers of one brace group; false if it holds anything else
+ */
+static bool ParseSamples(const std::string& body, std::vector<int>& samples) {
+  const char *p = body.c_str();
+  char *end;
+  samples.clear();
+  while (*p) {
+    while (isspace((unsigned char)*p) || *p == ',') p++;
+    if (!*p) break;
+    long value = strtol(p, &end, 0);
+    if (end == p) return false;
+    samples.push_back((int)value);
+    p = end;
+  }
+  return true;
+}
+
+/*
+ * every innermost { } group of TABLESIZE numbers is a table; the last // comment
+ * before it is its name and a preceding "wtN[" (the original layout) its index
+ */
+static bool ReadHeader(const char *path, std::vector<Table>& tables) {
+
+  std::string text;
+  if (!ReadFile(path, text)) return false;
+
+  std::string comment;
+  long index = -1;
+  size_t pos = 0;
+
+  while (pos < text.size()) {
+    if (text.compare(pos, 2, "//") == 0) {
+      size_t end = text.find('\n', pos);
+      if (end == std::string::npos) end = text.size();
+      comment = text.substr(pos + 2, end - pos - 2);
+      comment.erase(0, comment.find_first_not_of(' '));
+      comment.erase(comment.find_last_not_of(" \r") + 1);
+      pos = end;
+    } else if (text.compare(pos, 2, "wt") == 0 && isdigit((unsigned char)text[pos + 2])) {
+      index = strtol(text.c_str() + pos + 2, NULL, 10);
+      pos += 2;
+    } else if (text[pos] == '{') {
+      size_t close = text.find('}', pos);
+      size_t open = text.find('{', pos + 1);
+      if (close == std::string::npos) break;
+      if (open != std::string::npos && open < close) {
+        // an outer group; keep scanning inside it
+        pos++;
+        continue;
+      }
+      Table table;
+      if (ParseSamples(text.substr(pos + 1, close - pos - 1), table.Samples) && table.Samples.size() == TABLESIZE) {
+        table.Name = comment;
+        if (index >= 0) {
+          // the original layout leaves the square out
+          while ((long)tables.size() < index)
+            tables.push_back(Square());
+        }
+        tables.push_back(table);
+      }
+      index = -1;
+      pos = close + 1;
+    } else {
+      pos++;
+    }
+  }
+
+  return true;
+}
+
+static uint32_t Read32(const std::string& data, size_t pos) {
+  return (uint8_t)data[pos] | (uint8_t)data[pos + 1] << 8 | (uint8_t)data[pos + 2] << 16 | (uint32_t)(uint8_t)data[pos + 3] << 24;
+}
+
+/*
+ * a 16-bit mono PCM WAV of TABLELENGTH samples (the wrap sample is added) or TABLESIZE
+ */
+static bool ReadWav(const char *path, std::vector<Table>& tables) {
+
+  std::string data;
+  if (!ReadFile(path, data)) return false;
+
+  if (data.size() < 12 || data.compare(0, 4, "RIFF") || data.compare(8, 4, "WAVE")) {
+    fprintf(stderr, "%s: not a WAV file\n", path);
+    return false;
+  }
+
+  bool format = false;
+  size_t pos = 12;
+  while (pos + 8 <= data.size()) {
+    uint32_t size = Read32(data, pos + 4);
+    if (!data.compare(pos, 4, "fmt ") && size >= 16) {
+      int tag = (uint8_t)data[pos + 8] | (uint8_t)data[pos + 9] << 8;
+      int channels = (uint8_t)data[pos + 10] | (uint8_t)data[pos + 11] << 8;
+      int bits = (uint8_t)data[pos + 22] | (uint8_t)data[pos + 23] << 8;
+      format = tag == 1 && channels == 1 && bits == 16;
+    } else if (!data.compare(pos, 4, "data")) {
+      size_t count = size / 2;
+      if (!format || (count != TABLELENGTH && count != TABLESIZE) || pos + 8 + size > data.size()) {
+        fprintf(stderr, "%s: expected %d or %d 16-bit mono samples\n", path, TABLELENGTH, TABLESIZE);
+        return false;
+      }
+      Table table;
+      table.Name = path;
+      for (size_t i = 0; i < count; i++)
+        table.Samples.push_back((int16_t)((uint8_t)data[pos + 8 + i * 2] | (uint8_t)data[pos + 9 + i * 2] << 8));
+      if (count == TABLELENGTH)
+        table.Samples.push_back(table.Samples[0]);
+      tables.push_back(table);
+      return true;
+    }
+    pos += 8 + size + (size & 1);
+  }
+
+  fprintf(stderr, "%s: no data chunk\n", path);
+  return false;
+}
+
+/*
+ * the bits a level drops from the phase: level 1 keeps half the table's
+ * harmonics in half its samples (as the table itself has them), and each
+ * level after has half the samples of the one before, down to 64 (the images
+ * of the smallest levels would fold back among their few harmonics)
+ */
+static int LevelShift(int k) {
+  return k > 4 ? 3 : k > 1 ? k - 1 : k;
+}
+
+/*
+ * the power linear interpolation passes at a harmonic of a table of `length`
+ */
+static double Lerp(int harmonic, int length) {
+  double x = 3.14159265358979323846 * harmonic / length;
+  return pow(sin(x) / x, 4);
+}
+
+/*
+ * resynthesises the table at every level from its harmonics: level k keeps
+ * the harmonics below HARMONICS >> k, so each level only halves the
+ * bandwidth of the one before, in TABLELENGTH >> LevelShift(k) samples (plus
+ * the wrap sample); from level 2 on that is four samples a cycle of the top
+ * harmonic, so the images linear interpolation makes of them start well
+ * above the harmonics themselves
+ */
+static void BuildMips(Table& table, int mips) {
+
+  std::vector<double> re(HARMONICS), im(HARMONICS);
+  const double pi = 3.14159265358979323846;
+
+  for (int h = 0; h < HARMONICS; h++) {
+    double r = 0, i = 0;
+    for (int n = 0; n < TABLELENGTH; n++) {
+      double angle = 2 * pi * h * n / TABLELENGTH;
+      r += table.Samples[n] * cos(angle);
+      i -= table.Samples[n] * sin(angle);
+    }
+    re[h] = r / TABLELENGTH;
+    im[h] = i / TABLELENGTH;
+  }
+
+  table.Top = 0;
+  for (int h = 1; h < HARMONICS; h++)
+    if (2 * sqrt(re[h] * re[h] + im[h] * im[h]) >= TOPLSB)
+      table.Top = h;
+
+  // level 1 has two samples a cycle of its top harmonic, so the first images
+  // linear interpolation makes of the harmonics it keeps (either side of its
+  // length, each down by sinc^2) can outweigh what the table as stored sends
+  // past them: the harmonics level 1 removes and the table's own images
+  double stored = 0, imaged = 0;
+  for (int h = 1; h < HARMONICS; h++) {
+    double power = re[h] * re[h] + im[h] * im[h];
+    if (h >= HARMONICS >> 1)
+      stored += power * Lerp(h, TABLELENGTH);
+    stored += power * (Lerp(TABLELENGTH - h, TABLELENGTH) + Lerp(TABLELENGTH + h, TABLELENGTH));
+    if (h < HARMONICS >> 1)
+      imaged += power * (Lerp(TABLELENGTH / 2 - h, TABLELENGTH / 2) + Lerp(TABLELENGTH / 2 + h, TABLELENGTH / 2));
+  }
+  table.Imaged = imaged > stored;
+
+  table.Mips.clear();
+  for (int k = 1; k <= mips; k++) {
+    int length = TABLELENGTH >> LevelShift(k);
+    std::vector<int> samples(length + 1);
+    for (int n = 0; n < length; n++) {
+      double value = re[0];
+      for (int h = 1; h < HARMONICS >> k; h++) {
+        double angle = 2 * pi * h * n / length;
+        value += 2 * (re[h] * cos(angle) - im[h] * sin(angle));
+      }
+      // the ringing of a hard edge can overshoot 16 bits
+      long rounded = lround(value);
+      samples[n] = rounded < -32768 ? -32768 : rounded > 32767 ? 32767 : (int)rounded;
+    }
+    samples[length] = samples[0];
+    table.Mips.push_back(samples);
+  }
+}
+
+static void WriteSample(FILE *out, int value) {
+  if (value < 0)
+    fprintf(out, "-0x%x", -value);
+  else
+    fprintf(out, "0x%x", value);
+}
+
+static void Write(FILE *out, const std::vector<Table>& tables, int bankSize, int basicBanks, int mips) {
+
+  int banks = (tables.size() + bankSize - 1) / bankSize;
+
+  fputs("/*\n"
+        " * TELEXo Eurorack Module\n"
+        " * (c) 2016-2018 Brendon Cassidy\n"
+        " * MIT License\n"
+        " *\n"
+        " * generated by wavetable_gen (software/host/tools) - regenerate rather than edit\n"
+        " */\n"
+        "\n"
+        "#ifndef Wavetables_h\n"
+        "#define Wavetables_h\n"
+        "\n"
+        "#include \"defines.h\"\n"
+        "\n"
+        "#define SINE_WAVE 0\n"
+        "#define TRIANGLE_WAVE 1\n"
+        "#define SAW_WAVE 2\n"
+        "#define SQUARE_WAVE 3\n"
+        "\n", out);
+
+  fprintf(out, "// 16-bit tables are stored in banks of WAVEBANKSIZE\n"
+               "#define WAVEBANKSIZE %d\n"
+               "#define WAVEBANKTOTAL %d\n"
+               "\n", bankSize, banks);
+
+  fprintf(out, "// banks compiled into this build (can be set by the build)\n"
+               "#ifndef WAVEBANKS\n"
+               "#if defined(DEBUG)\n"
+               "#define WAVEBANKS 1\n"
+               "#elif defined(TURBO)\n"
+               "#define WAVEBANKS WAVEBANKTOTAL\n"
+               "#else\n"
+               "#define WAVEBANKS %d\n"
+               "#endif\n"
+               "#endif\n"
+               "\n", basicBanks < banks ? basicBanks : banks);
+
+  fputs("/*\n"
+        " * tables 4 and up are selected from\n"
+        " * Adventure Kid's Public Domain waveform collection\n"
+        " * more info here: https://www.adventurekid.se/akrt/waveforms/adventure-kid-waveforms/\n"
+        " *\n"
+        " * they were resampled (to 37650Hz) in order to make them 512 samples long\n"
+        " */\n", out);
+
+  for (int b = 0; b < banks; b++) {
+    int first = b * bankSize;
+    int count = (int)tables.size() - first < bankSize ? (int)tables.size() - first : bankSize;
+    fputs("\n", out);
+    if (b > 0) fprintf(out, "#if WAVEBANKS > %d\n", b);
+    fprintf(out, "// bank %d (tables %d-%d)\n", b, first, first + count - 1);
+    fprintf(out, "const int16_t wavebank%d[%d][%d] = {\n", b, count, TABLESIZE);
+    for (int t = first; t < first + count; t++) {
+      fprintf(out, "  // %s\n  { ", tables[t].Name.c_str());
+      for (int i = 0; i < TABLESIZE; i++) {
+        if (i) fputs(", ", out);
+        WriteSample(out, tables[t].Samples[i]);
+      }
+      fputs(t + 1 < first + count ? " },\n" : " }\n", out);
+    }
+    fputs("};\n", out);
+    for (int k = 1; k <= mips; k++) {
+      fprintf(out, "// bank %d, level %d (harmonics below %d)\n", b, k, HARMONICS >> k);
+      fprintf(out, "const int16_t wavebank%dmip%d[%d][%d] = {\n", b, k, count, (TABLELENGTH >> LevelShift(k)) + 1);
+      for (int t = first; t < first + count; t++) {
+        fputs("  { ", out);
+        for (int i = 0; i <= TABLELENGTH >> LevelShift(k); i++) {
+          if (i) fputs(", ", out);
+          WriteSample(out, tables[t].Mips[k - 1][i]);
+        }
+        fputs(t + 1 < first + count ? " },\n" : " }\n", out);
+      }
+      fputs("};\n", out);
+    }
+    if (b > 0) fputs("#endif\n", out);
+  }
+
+  fputs("\n// the tables by waveform number\nconst int16_t * const wavetables[] = {\n", out);
+  for (int b = 0; b < banks; b++) {
+    int first = b * bankSize;
+    int count = (int)tables.size() - first < bankSize ? (int)tables.size() - first : bankSize;
+    if (b > 0) fprintf(out, "#if WAVEBANKS > %d\n", b);
+    fputs(" ", out);
+    for (int t = 0; t < count; t++)
+      fprintf(out, " wavebank%d[%d],", b, t);
+    fputs("\n", out);
+    if (b > 0) fputs("#endif\n", out);
+  }
+  fputs("};\n\n", out);
+
+  fprintf(out, "// each table's band-limited levels by waveform number: level k keeps the\n"
+               "// harmonics below (TABLERANGEDIV2 >> k) in (TABLERANGE >> LEVELSHIFT(k)) + 1\n"
+               "// samples (level 0 is the table itself)\n"
+               "#define LEVELSHIFT(k) ((k) > 4 ? 3 : (k) > 1 ? (k) - 1 : (k))\n"
+               "#define WAVEMIPS %d\n"
+               "const int16_t * const wavemips[][WAVEMIPS + 1] = {\n", mips);
+  for (int b = 0; b < banks; b++) {
+    int first = b * bankSize;
+    int count = (int)tables.size() - first < bankSize ? (int)tables.size() - first : bankSize;
+    if (b > 0) fprintf(out, "#if WAVEBANKS > %d\n", b);
+    for (int t = 0; t < count; t++) {
+      fprintf(out, "  { wavebank%d[%d]", b, t);
+      for (int k = 1; k <= mips; k++)
+        fprintf(out, ", wavebank%dmip%d[%d]", b, k, t);
+      fputs(" },\n", out);
+    }
+    if (b > 0) fputs("#endif\n", out);
+  }
+  fputs("};\n\n", out);
+
+  fputs("// each table's highest harmonic (a table only needs the levels that remove some)\n"
+        "const uint16_t wavetops[] = {\n", out);
+  for (int b = 0; b < banks; b++) {
+    int first = b * bankSize;
+    int count = (int)tables.size() - first < bankSize ? (int)tables.size() - first : bankSize;
+    if (b > 0) fprintf(out, "#if WAVEBANKS > %d\n", b);
+    fputs(" ", out);
+    for (int t = first; t < first + count; t++)
+      fprintf(out, " %d,", tables[t].Top);
+    fputs("\n", out);
+    if (b > 0) fputs("#endif\n", out);
+  }
+  fputs("};\n\n", out);
+
+  fputs("// each table whose level 1 makes stronger interpolation images than the\n"
+        "// table as stored aliases (at a low sampling rate they fold into the band)\n"
+        "const bool waveimaged[] = {\n", out);
+  for (int b = 0; b < banks; b++) {
+    int first = b * bankSize;
+    int count = (int)tables.size() - first < bankSize ? (int)tables.size() - first : bankSize;
+    if (b > 0) fprintf(out, "#if WAVEBANKS > %d\n", b);
+    fputs(" ", out);
+    for (int t = first; t < first + count; t++)
+      fprintf(out, " %d,", tables[t].Imaged ? 1 : 0);
+    fputs("\n", out);
+    if (b > 0) fputs("#endif\n", out);
+  }
+  fputs("};\n\n", out);
+
+  fprintf(out, "#if WAVEBANKS >= WAVEBANKTOTAL\n"
+               "#define WAVETABLECOUNT %d\n"
+               "#else\n"
+               "#define WAVETABLECOUNT (WAVEBANKS * WAVEBANKSIZE)\n"
+               "#endif\n"
+               "\n"
+               "#endif\n", (int)tables.size());
+}
+
+int main(int argc, char *argv[]) {
+
+  std::vector<Table> tables;
+  int bankSize = 32;
+  int basicBanks = 2;
+  int mips = MAXMIPS;
+  const char *outPath = NULL;
+
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "--header") && a + 1 < argc) {
+      if (!ReadHeader(argv[++a], tables)) return 2;
+    } else if (!strcmp(argv[a], "--wav") && a + 1 < argc) {
+      while (a + 1 < argc && strncmp(argv[a + 1], "--", 2))
+        if (!ReadWav(argv[++a], tables)) return 2;
+    } else if (!strcmp(argv[a], "--bank-size") && a + 1 < argc) {
+      bankSize = atoi(argv[++a]);
+    } else if (!strcmp(argv[a], "--basic-banks") && a + 1 < argc) {
+      basicBanks = atoi(argv[++a]);
+    } else if (!strcmp(argv[a], "--mips") && a + 1 < argc) {
+      mips = atoi(argv[++a]);
+    } else if (!strcmp(argv[a], "--out") && a + 1 < argc) {
+      outPath = argv[++a];
+    } else {
+      fprintf(stderr, "usage: %s [--header FILE] [--wav FILE ...] [--bank-size N] [--basic-banks N] [--mips N] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (bankSize <= 0 || (bankSize & (bankSize - 1)) || basicBanks <= 0) {
+    fprintf(stderr, "the bank size must be a power of two and at least one bank is needed\n");
+    return 2;
+  }
+  if (mips < 0 || mips > MAXMIPS) {
+    fprintf(stderr, "between 0 and %d band-limited levels\n", MAXMIPS);
+    return 2;
+  }
+  if ((int)tables.size() <= SQUARE_WAVE) {
+    fprintf(stderr, "expected at least the sine, triangle, saw and square\n");
+    return 2;
+  }
+  for (size_t t = 0; t < tables.size(); t++) {
+    for (int i = 0; i < TABLESIZE; i++) {
+      if (tables[t].Samples[i] < -32768 || tables[t].Samples[i] > 32767) {
+        fprintf(stderr, "table %d (%s) does not fit 16 bits\n", (int)t, tables[t].Name.c_str());
+        return 1;
+      }
+    }
+  }
+
+  for (size_t t = 0; t < tables.size(); t++)
+    BuildMips(tables[t], mips);
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 2;
+  }
+  Write(out, tables, bankSize, basicBanks, mips);
+  if (out != stdout) fclose(out);
+
+  fprintf(stderr, "%d tables in %d banks of %d\n", (int)tables.size(), (int)(tables.size() + bankSize - 1) / bankSize, bankSize);
+  return 0;
+}